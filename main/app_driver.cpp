@@ -6,112 +6,203 @@
    CONDITIONS OF ANY KIND, either express or implied.
 */
 
+#include <atomic>
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <device.h>
 #include <esp_matter.h>
 #include <led_driver.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <app/reporting/reporting.h>
 
 #include <app_priv.h>
+#include <app_fan_mode.h>
+#include <app_fan_endpoints.h>
 #include "driver/ledc.h"
+#include <app_fan_bank.h>
+#include <app_tach.h>
+#include <app_fan_pid.h>
+#include <app_fan_curve.h>
+#include <app_fan_auto.h>
+#include <app_spsc_ring.h>
+#include <app_trace.h>
+#include <app_latency.h>
+#include <app_report_coalescer.h>
+#include <app_persist.h>
+#include <app_mem.h>
 #include <app_reset.h>
+#include <esp_matter_console.h>
 #include <iot_button.h>
 #include "driver/gpio.h"
 #include "soc/gpio_num.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 using namespace chip::app::Clusters;
 using namespace chip::app::Clusters::FanControl;
 using namespace esp_matter;
 
-#define LEDC_TIMER              LEDC_TIMER_0
-#define LEDC_MODE               LEDC_LOW_SPEED_MODE
-#define LEDC_CHANNEL            LEDC_CHANNEL_0
-#define LEDC_DUTY_RES           LEDC_TIMER_13_BIT // Set duty resolution to 13 bits
-#define LEDC_DUTY               (4096) // Set duty to 50%. (2 ** 13) * 50% = 4096
-#define LEDC_FREQUENCY          (4000) // Frequency in Hertz. Set frequency at 4 kHz
-#define LEDC_DUTY_MAX           8192
-
-// PWM-Konfiguration für den Lüfter
-#define MAX_LEDS 2
-
+/* FanControl attribute handles of the endpoint driving a fan, resolved once by app_driver_fan_bind_endpoint() */
+typedef struct {
+    attribute_t *fan_mode;
+    attribute_t *percent_setting;
+    attribute_t *percent_current;
+    attribute_t *fan_mode_sequence;
+    attribute_t *speed_setting;     /* NULL without the Multi-Speed feature */
+    attribute_t *speed_current;
+} fan_attribute_cache_t;
 
 typedef struct {
     gpio_num_t gpio;
-    ledc_channel_t channel;
-    ledc_timer_t timer;
+    uint8_t channel;    /* channel in the fan bank */
     bool power_state;
     uint32_t speed;
+    uint16_t endpoint_id;
+    fan_attribute_cache_t attributes;
+    app_report_coalescer_t percent_report;  /* PercentCurrent, sampled from the output by the report timer */
+    uint8_t reported_speed;                 /* SpeedCurrent, only touched on the CHIP thread */
+    uint8_t setpoint_percent;
+    std::atomic<uint8_t> fan_mode;  /* FanMode as last reconciled, only written on the CHIP thread */
+    const fan_mode_table_t *mode_table;     /* FanMode <-> PercentSetting mapping of the endpoint's sequence */
+    app_fan_pid_state_t pid;
+    app_fan_curve_t curve;          /* duty of every percent step, linear until the fan is calibrated */
+    std::atomic<app_fan_curve_span_t> rpm_span;     /* span of the curve, for the report timer */
+    bool calibrated;
+    bool auto_mode;                 /* speed follows the Auto mode controller */
+    bool pulsing;                   /* an Identify pulse owns the output, speed is applied when it ends */
+    bool kicking;                   /* a kick-start pulse owns the output, speed is applied when it ends */
+    bool calibrating;               /* a calibration sweep owns the output, speed is applied when it ends */
 } led_config_t;
 
-led_config_t fan_configs[MAX_LEDS] = {
-    {
-        .gpio = (gpio_num_t)CONFIG_EXAMPLE_FAN_GPIO,
-        .channel = LEDC_CHANNEL_0,
-        .timer = LEDC_TIMER_0,
-        .power_state = false,
-        .speed = 0
-    },
-    {
-        .gpio = (gpio_num_t)CONFIG_EXAMPLE_FAN2_GPIO,
-        .channel = LEDC_CHANNEL_1,
-        .timer = LEDC_TIMER_1,
-        .power_state = false,
-        .speed = 0
-    }
+#define DRIVER_TASK_STACK_SIZE      3072
+#define DRIVER_TASK_PRIORITY        5
+#define DRIVER_COMMAND_RING_SIZE    32
+#define DRIVER_LOCAL_RING_SIZE      8
+#define DRIVER_NOTIFY_COMMAND       (1 << 0)
+#define DRIVER_NOTIFY_CONTROL_TICK  (1 << 1)
+#define DRIVER_NOTIFY_PULSE_END     (1 << 2)
+#define DRIVER_NOTIFY_KICK_END      (1 << 3)
+
+/* Endpoint IDs are handed out in creation order, the fan endpoints always fall inside the dynamic endpoint range */
+#define FAN_DISPATCH_SIZE           (CONFIG_ESP_MATTER_MAX_DYNAMIC_ENDPOINT_COUNT + 1)
+
+#define FAN_REPORT_SAMPLE_MS        100
+
+typedef enum {
+    FAN_COMMAND_SET_SPEED,
+    FAN_COMMAND_PULSE,
+    FAN_COMMAND_CALIBRATE,
+} fan_command_type_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t fan_index;
+    uint8_t percent;
+} fan_command_t;
+
+/* The bank is only touched by the driver task. The CHIP thread hands new targets over through the command ring and
+   returns at once, so LEDC register writes and fades never run in the Matter event loop. */
+static fan_bank<CONFIG_FAN_COUNT> s_fan_bank;
+static spsc_ring<fan_command_t, DRIVER_COMMAND_RING_SIZE> s_command_ring;
+/* Second producer: button gestures run in the esp_timer task and reach the PWM without waiting for the CHIP thread */
+static spsc_ring<fan_command_t, DRIVER_LOCAL_RING_SIZE> s_local_ring;
+static uint8_t s_local_fan;     /* fan selected for local control, index into fan_configs */
+static TaskHandle_t s_driver_task;
+static std::atomic<bool> s_flush_scheduled{false};
+static esp_timer_handle_t s_pulse_timer;
+static esp_timer_handle_t s_kick_timer;
+led_config_t fan_configs[CONFIG_FAN_COUNT];
+/* Fan driven by each endpoint, NULL for endpoints which are not fans */
+static led_config_t *s_endpoint_fans[FAN_DISPATCH_SIZE];
+static esp_timer_handle_t s_report_timer;
+
+static const app_report_coalescer_config_t s_report_config = {
+    .min_delta = CONFIG_FAN_REPORT_MIN_DELTA,
+    .min_interval_ms = CONFIG_FAN_REPORT_MIN_INTERVAL_MS,
+    .max_interval_ms = CONFIG_FAN_REPORT_MAX_INTERVAL_MS,
 };
 
 static const char *TAG = "app_driver";
-extern uint16_t fan_endpoint_id;
 
-static void get_attribute(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id, esp_matter_attr_val_t *val)
-{
-    node_t *node = node::get();
-    endpoint_t *endpoint = endpoint::get(node, endpoint_id);
-    cluster_t *cluster = cluster::get(endpoint, cluster_id);
-    attribute_t *attribute = attribute::get(cluster, attribute_id);
+static const app_fan_auto_config_t s_auto_config = {
+    .temp_min = CONFIG_FAN_AUTO_TEMP_MIN * 100,
+    .temp_max = CONFIG_FAN_AUTO_TEMP_MAX * 100,
+    .hysteresis = CONFIG_FAN_AUTO_HYSTERESIS,
+    .percent_min = CONFIG_FAN_AUTO_PERCENT_MIN,
+    .percent_max = 100,
+};
+static app_fan_auto_state_t s_auto_state;
 
-    attribute::get_val(attribute, val);
+/* The fan mode logic in app_fan_mode.h does not depend on the Matter headers, keep its values in sync */
+static_assert(APP_FAN_MODE_OFF == chip::to_underlying(FanModeEnum::kOff) &&
+              APP_FAN_MODE_LOW == chip::to_underlying(FanModeEnum::kLow) &&
+              APP_FAN_MODE_MEDIUM == chip::to_underlying(FanModeEnum::kMedium) &&
+              APP_FAN_MODE_HIGH == chip::to_underlying(FanModeEnum::kHigh) &&
+              APP_FAN_MODE_ON == chip::to_underlying(FanModeEnum::kOn) &&
+              APP_FAN_MODE_AUTO == chip::to_underlying(FanModeEnum::kAuto) &&
+              APP_FAN_MODE_SMART == chip::to_underlying(FanModeEnum::kSmart), "FanModeEnum mismatch");
+static_assert(APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH == chip::to_underlying(FanModeSequenceEnum::kOffLowMedHigh) &&
+              APP_FAN_MODE_SEQUENCE_OFF_LOW_HIGH == chip::to_underlying(FanModeSequenceEnum::kOffLowHigh) &&
+              APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH_AUTO ==
+                  chip::to_underlying(FanModeSequenceEnum::kOffLowMedHighAuto) &&
+              APP_FAN_MODE_SEQUENCE_OFF_LOW_HIGH_AUTO == chip::to_underlying(FanModeSequenceEnum::kOffLowHighAuto) &&
+              APP_FAN_MODE_SEQUENCE_OFF_HIGH_AUTO == chip::to_underlying(FanModeSequenceEnum::kOffHighAuto) &&
+              APP_FAN_MODE_SEQUENCE_OFF_HIGH == chip::to_underlying(FanModeSequenceEnum::kOffHigh),
+              "FanModeSequenceEnum mismatch");
+
+static constexpr fan_mode_table_t k_fan_mode_tables[] = {
+    make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH),
+    make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_LOW_HIGH),
+    make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH_AUTO),
+    make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_LOW_HIGH_AUTO),
+    make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_HIGH_AUTO),
+    make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_HIGH),
+};
+
+static led_config_t *fan_for_endpoint(uint16_t endpoint_id)
+{
+    return endpoint_id < FAN_DISPATCH_SIZE ? s_endpoint_fans[endpoint_id] : NULL;
 }
 
-static esp_err_t set_attribute(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id, esp_matter_attr_val_t val)
+template <size_t N>
+static esp_err_t push_command(spsc_ring<fan_command_t, N> &ring, led_config_t *fan_config, fan_command_type_t type,
+                              uint8_t percent)
 {
-    node_t *node = node::get();
-    endpoint_t *endpoint = endpoint::get(node, endpoint_id);
-    cluster_t *cluster = cluster::get(endpoint, cluster_id);
-    attribute_t *attribute = attribute::get(cluster, attribute_id);
+    fan_command_t command = {
+        .type = (uint8_t)type,
+        .fan_index = fan_config->channel,
+        .percent = percent > 100 ? (uint8_t)100 : percent,
+    };
+    if (!ring.push(command)) {
+        APP_TRACE(APP_TRACE_COMMAND_DROPPED, fan_config->channel, 0, 0, 0, command.percent);
+        ESP_LOGE(TAG, "Driver command ring full, dropping update of fan %d", fan_config->channel);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
 
-    return attribute::set_val(attribute, &val);
-    //return attribute::update(endpoint_id, cluster_id, attribute_id, &val);
+static void driver_flush(intptr_t arg)
+{
+    s_flush_scheduled.store(false, std::memory_order_relaxed);
+    xTaskNotify(s_driver_task, DRIVER_NOTIFY_COMMAND, eSetBits);
 }
 
-static bool check_if_mode_percent_match(uint8_t fan_mode, uint8_t percent)
+/* Runs on the CHIP thread. The driver task is only woken once the current CHIP event is done, so all fans written
+   by one group write, scene recall or preset land in the same commit and switch in the same PWM period. */
+static void notify_driver_deferred()
 {
-    switch (fan_mode) {
-        case chip::to_underlying(FanModeEnum::kHigh): {
-            if (percent < HIGH_MODE_PERCENT_MIN) {
-                return false;
-            }
-            break;
-        }
-        case chip::to_underlying(FanModeEnum::kMedium): {
-            if ((percent < MED_MODE_PERCENT_MIN) || (percent > MED_MODE_PERCENT_MAX)) {
-               return false;
-            }
-            break;
-        }
-        case chip::to_underlying(FanModeEnum::kLow): {
-            if ((percent < LOW_MODE_PERCENT_MIN) || (percent > LOW_MODE_PERCENT_MAX)) {
-                return false;
-            }
-            break;
-        }
-        default:
-            return false;
+    if (s_flush_scheduled.exchange(true, std::memory_order_relaxed)) {
+        return;
+    }
+    if (chip::DeviceLayer::PlatformMgr().ScheduleWork(driver_flush, 0) != CHIP_NO_ERROR) {
+        /* The flush would never run and block every later one, wake the driver task right away instead */
+        s_flush_scheduled.store(false, std::memory_order_relaxed);
+        xTaskNotify(s_driver_task, DRIVER_NOTIFY_COMMAND, eSetBits);
     }
-
-    return true;
 }
 
 static esp_err_t set_fan_speed(led_config_t *fan_config, uint8_t percent)
@@ -121,156 +212,630 @@ static esp_err_t set_fan_speed(led_config_t *fan_config, uint8_t percent)
         return ESP_ERR_INVALID_ARG;
     }
 
-    if (percent > 100) {
-        percent = 100;
+    uint32_t start = app_latency_now();
+    esp_err_t err = push_command(s_command_ring, fan_config, FAN_COMMAND_SET_SPEED, percent);
+    if (err == ESP_OK) {
+        notify_driver_deferred();
     }
+    app_latency_record(APP_LATENCY_SET_FAN_SPEED, fan_config->endpoint_id, start);
+    return err;
+}
 
-    // Calculate duty cycle for 13-bit resolution (0-8191)
-    uint32_t duty = 0;
-    if (percent > 0) {
-        duty = ((uint32_t)percent * (LEDC_DUTY_MAX - 1)) / 100;
+/* Runs on the driver task. A fan that stands still may not start at a low duty, it is driven at its start duty
+   for CONFIG_FAN_KICK_MS first. */
+static bool kick_fan(led_config_t *fan_config, uint32_t duty)
+{
+#if CONFIG_FAN_CALIBRATION
+    uint32_t start_duty = fan_config->curve.start_duty;
+    if (duty == 0 || duty >= start_duty ||
+        (s_fan_bank.target(fan_config->channel) > 0 && app_tach_get_rpm(fan_config->channel) > 0)) {
+        return false;
     }
+    APP_TRACE(APP_TRACE_FAN_APPLY, fan_config->channel, 0, 0, duty, start_duty);
+    fan_config->kicking = true;
+    s_fan_bank.stage(fan_config->channel, start_duty, true);
+    esp_timer_stop(s_kick_timer);
+    esp_timer_start_once(s_kick_timer, CONFIG_FAN_KICK_MS * 1000);
+    return true;
+#else
+    return false;
+#endif
+}
 
-    ESP_LOGI(TAG, "duty=%lu", duty);
-    ESP_LOGI(TAG, "Setting fan speed: GPIO=%d, Channel=%d, Percent=%d%%, Duty=%lu", 
-             fan_config->gpio, fan_config->channel, percent, duty);
+/* Runs on the driver task, stages the new target of a fan for the next commit */
+static void apply_fan_speed(led_config_t *fan_config, uint8_t percent)
+{
+    uint32_t duty = fan_config->curve.duty[percent];
+    APP_TRACE(APP_TRACE_FAN_APPLY, fan_config->channel, 0, 0, fan_config->speed, duty);
 
     // Store speed in config
     fan_config->speed = duty;
+    fan_config->power_state = duty > 0;
 
-    // Set PWM duty cycle
-    esp_err_t err = ledc_set_duty(LEDC_MODE, fan_config->channel, duty);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set duty: %s (channel: %d)", esp_err_to_name(err), fan_config->channel);
-        return err;
+    /* In closed-loop mode the open-loop duty is applied at once as the feedforward term, the control tick then
+       corrects it from the measured speed */
+    fan_config->setpoint_percent = percent;
+#if CONFIG_FAN_CLOSED_LOOP
+    if (percent == 0) {
+        app_fan_pid_reset(&fan_config->pid, app_tach_get_rpm(fan_config->channel));
     }
+#endif
+    if (!fan_config->pulsing && !fan_config->kicking && !fan_config->calibrating && !kick_fan(fan_config, duty)) {
+        s_fan_bank.stage(fan_config->channel, duty);
+    }
+}
 
-    // Update PWM duty cycle
-    err = ledc_update_duty(LEDC_MODE, fan_config->channel);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to update duty: %s (channel: %d)", esp_err_to_name(err), fan_config->channel);
-        return err;
+/* Runs on the driver task. The pulse jumps to the pulse speed without a ramp so it is clearly audible, or stops
+   the fan if it already runs at that speed. */
+static void start_fan_pulse(led_config_t *fan_config, uint8_t percent)
+{
+    if (fan_config->calibrating) {
+        return;
     }
+    uint8_t pulse_percent = fan_config->setpoint_percent == percent ? 0 : percent;
+    fan_config->pulsing = true;
+    fan_config->kicking = false;
+    s_fan_bank.stage(fan_config->channel, fan_config->curve.duty[pulse_percent], true);
+    esp_timer_stop(s_pulse_timer);
+    esp_timer_start_once(s_pulse_timer, CONFIG_FAN_IDENTIFY_PULSE_MS * 1000);
+}
 
-    ESP_LOGI(TAG, "Successfully set fan speed to %d%% (duty: %lu)", percent, duty);
-    return ESP_OK;
+static void end_fan_pulses()
+{
+    for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+        led_config_t *fan_config = &fan_configs[i];
+        if (fan_config->pulsing) {
+            fan_config->pulsing = false;
+            s_fan_bank.stage(fan_config->channel, fan_config->speed, true);
+        }
+    }
 }
 
-static void app_driver_fan_set_percent(led_driver_handle_t handle, esp_matter_attr_val_t val)
+static void end_fan_kicks()
 {
-    /*this is just used to simulate fan driver*/
-    set_attribute(fan_endpoint_id, FanControl::Id, Attributes::PercentCurrent::Id, val);
-    ESP_LOGI(TAG, "Call app_driver_fan_set_percent");
+    for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+        led_config_t *fan_config = &fan_configs[i];
+        if (fan_config->kicking) {
+            fan_config->kicking = false;
+            s_fan_bank.stage(fan_config->channel, fan_config->speed);
+        }
+    }
 }
 
-esp_err_t app_driver_attribute_update(app_driver_handle_t driver_handle, uint16_t endpoint_id, uint32_t cluster_id,
-                                      uint32_t attribute_id, esp_matter_attr_val_t *val)
+static void pulse_timer_cb(void *arg)
 {
-    esp_err_t err = ESP_OK;
-    ESP_LOGI(TAG, "Enpoint id %d", endpoint_id);
-    ESP_LOGI(TAG, "Custer id %lu", cluster_id);
-    led_config_t *fan_configs = (led_config_t *)driver_handle;
-    int fan_index = endpoint_id - 1;
-
-    // if (fan_index < 0 || fan_index >= MAX_LEDS) {
-    //     ESP_LOGE(TAG, "Invalid fan index: %d", fan_index);
-    //     return ESP_ERR_INVALID_ARG;
-    // }
-
-    ESP_LOGI(TAG, "if Enpoint id %d", endpoint_id);
-    if (cluster_id == FanControl::Id) {
-        ESP_LOGI(TAG, "if Custer id %lu", cluster_id);
-        if (attribute_id == FanControl::Attributes::FanMode::Id) {
-            ESP_LOGI(TAG, "if attribute id %lu", attribute_id);
-            ESP_LOGI(TAG, "fan index: %d", fan_index);
-            esp_matter_attr_val_t val_a = esp_matter_invalid(NULL);
-            get_attribute(endpoint_id, FanControl::Id, Attributes::PercentSetting::Id, &val_a);
-            /* When FanMode attribute change , should check the persent setting value, if this value not match
-               FanMode, need write the persent setting value to corresponding value. Now we set it to the max
-               value of the FanMode*/
-            if (!check_if_mode_percent_match(val->val.u8, val_a.val.u8)) {
-                switch (val->val.u8) {
-                    case chip::to_underlying(FanModeEnum::kHigh): {
-                        ESP_LOGI(TAG, "fan index: %d", fan_index);
-                        val_a.val.u8 = HIGH_MODE_PERCENT_MAX;
-                        set_attribute(endpoint_id, FanControl::Id, Attributes::PercentSetting::Id, val_a);
-                        err = set_fan_speed(&fan_configs[fan_index], HIGH_MODE_PERCENT_MAX);
-                        if (err != ESP_OK) {
-                            ESP_LOGE(TAG, "Failed to set HIGH mode");
-                            return err;
-                        }
-                        ESP_LOGI(TAG, "HIGH MODE");
-                        break;
-                    }
-                    case chip::to_underlying(FanModeEnum::kMedium): {
-                        ESP_LOGI(TAG, "fan index: %d", fan_index);
-                        set_attribute(endpoint_id, FanControl::Id, Attributes::PercentSetting::Id, val_a);
-                        val_a.val.u8 = MED_MODE_PERCENT_MAX;
-                        err = set_fan_speed(&fan_configs[fan_index], MED_MODE_PERCENT_MAX);
-                        if (err != ESP_OK) {
-                            ESP_LOGE(TAG, "Failed to set MEDIUM mode");
-                            return err;
-                        }
-                        ESP_LOGI(TAG, "MEDIUM MODE");
-                        break;
-                    }
-                    case chip::to_underlying(FanModeEnum::kLow): {
-                        ESP_LOGI(TAG, "fan index: %d", fan_index);
-                        set_attribute(endpoint_id, FanControl::Id, Attributes::PercentSetting::Id, val_a);
-                        val_a.val.u8 = LOW_MODE_PERCENT_MAX;
-                        err = set_fan_speed(&fan_configs[fan_index], LOW_MODE_PERCENT_MAX);
-                        if (err != ESP_OK) {
-                            ESP_LOGE(TAG, "Failed to set LOW mode");
-                            return err;
-                        }
-                        ESP_LOGI(TAG, "LOW MODE");
-                        break;
-                    }
-                    // case chip::to_underlying(FanModeEnum::kAuto): {
-                    //     /* add auto mode driver for auto logic */
-                    //     break;
-                    // }
-                    case chip::to_underlying(FanModeEnum::kOff): {
-                        set_attribute(endpoint_id, FanControl::Id, Attributes::PercentSetting::Id, val_a);
-                        val_a.val.u8 = 0;
-                        set_fan_speed(&fan_configs[fan_index], 0);
-                        ESP_LOGI(TAG, "OFF MODE");
-                        break;
-                    }
-                    default:
-                        break;
+    xTaskNotify(s_driver_task, DRIVER_NOTIFY_PULSE_END, eSetBits);
+}
+
+static void kick_timer_cb(void *arg)
+{
+    xTaskNotify(s_driver_task, DRIVER_NOTIFY_KICK_END, eSetBits);
+}
+
+static void get_attribute(uint16_t endpoint_id, attribute_t *attribute, esp_matter_attr_val_t *val)
+{
+    uint32_t start = app_latency_now();
+    attribute::get_val(attribute, val);
+    app_latency_record(APP_LATENCY_ATTRIBUTE_ACCESS, endpoint_id, start);
+}
+
+static esp_err_t set_attribute(uint16_t endpoint_id, attribute_t *attribute, esp_matter_attr_val_t *val)
+{
+    uint32_t start = app_latency_now();
+    esp_err_t err = attribute::set_val(attribute, val);
+    app_latency_record(APP_LATENCY_ATTRIBUTE_ACCESS, endpoint_id, start);
+    return err;
+}
+
+static uint8_t percent_to_speed(uint8_t percent)
+{
+    return app_fan_percent_to_speed(percent, CONFIG_FAN_SPEED_MAX);
+}
+
+static uint8_t speed_to_percent(uint8_t speed)
+{
+    return app_fan_speed_to_percent(speed, CONFIG_FAN_SPEED_MAX);
+}
+
+#if CONFIG_FAN_TACH_ENABLE
+#if CONFIG_FAN_TACH_SOURCE_PCNT
+static gpio_num_t fan_tach_gpios[CONFIG_FAN_COUNT];
+#endif
+
+static uint32_t fan_duty_permille(size_t fan_index)
+{
+    return (s_fan_bank.duty(fan_index) * 1000) / (FAN_BANK_DUTY_MAX - 1);
+}
+
+#if CONFIG_FAN_CLOSED_LOOP
+static const app_fan_pid_gains_t s_pid_gains = {
+    .kp = CONFIG_FAN_PID_KP_Q8,
+    .ki = CONFIG_FAN_PID_KI_Q8,
+    .kd = CONFIG_FAN_PID_KD_Q8,
+    .out_min = 0,
+    .out_max = FAN_BANK_DUTY_MAX - 1,
+};
+
+/* One control tick for all fans, run right after each tach window so every tick sees a fresh measurement */
+static void fan_control_tick()
+{
+    for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+        led_config_t *fan_config = &fan_configs[i];
+        if (fan_config->setpoint_percent == 0 || fan_config->pulsing || fan_config->kicking ||
+            fan_config->calibrating) {
+            continue;
+        }
+        int32_t setpoint = app_fan_curve_percent_to_rpm(fan_config->curve.span, fan_config->setpoint_percent,
+                                                        CONFIG_FAN_MAX_RPM);
+        int32_t feedforward = fan_config->curve.duty[fan_config->setpoint_percent];
+        int32_t duty = app_fan_pid_step(&s_pid_gains, &fan_config->pid, setpoint,
+                                        app_tach_get_rpm(fan_config->channel), feedforward);
+        fan_config->speed = duty;
+        s_fan_bank.stage(fan_config->channel, duty);
+    }
+}
+
+#endif
+
+#if CONFIG_FAN_CALIBRATION
+static app_fan_sweep_t s_sweeps[CONFIG_FAN_COUNT];
+
+static void start_fan_calibration(led_config_t *fan_config)
+{
+    if (fan_config->calibrating) {
+        return;
+    }
+    ESP_LOGI(TAG, "Calibrating fan %d", fan_config->channel);
+    fan_config->calibrating = true;
+    fan_config->pulsing = false;
+    fan_config->kicking = false;
+    uint16_t duty = app_fan_sweep_begin(&s_sweeps[fan_config->channel], FAN_BANK_DUTY_MAX - 1,
+                                        CONFIG_FAN_CALIBRATION_SETTLE_WINDOWS);
+    s_fan_bank.stage(fan_config->channel, duty, true);
+}
+
+static void finish_fan_calibration(led_config_t *fan_config, const app_fan_sweep_t *sweep)
+{
+    fan_config->calibrating = false;
+    app_fan_curve_t curve;
+    if (sweep->phase == APP_FAN_SWEEP_DONE &&
+        app_fan_curve_fit(sweep->samples, sweep->count, FAN_BANK_DUTY_MAX - 1, sweep->start_duty, &curve)) {
+        fan_config->curve = curve;
+        fan_config->calibrated = true;
+        fan_config->rpm_span.store(curve.span, std::memory_order_relaxed);
+        ESP_LOGI(TAG, "Fan %d calibrated: start duty %d, %d to %d RPM", fan_config->channel, curve.start_duty,
+                 curve.span.rpm_min, curve.span.rpm_max);
+        app_persist_set_curve(fan_config->channel, &curve);
+    } else {
+        ESP_LOGE(TAG, "Calibration of fan %d failed after %d samples, keeping the previous curve",
+                 fan_config->channel, sweep->count);
+    }
+    apply_fan_speed(fan_config, fan_config->setpoint_percent);
+}
+
+/* One sweep step for every fan being calibrated, run right after each tach window */
+static void fan_calibration_tick()
+{
+    for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+        led_config_t *fan_config = &fan_configs[i];
+        if (!fan_config->calibrating) {
+            continue;
+        }
+        app_fan_sweep_t *sweep = &s_sweeps[fan_config->channel];
+        uint16_t duty = app_fan_sweep_step(sweep, app_tach_get_rpm(fan_config->channel));
+        if (sweep->phase == APP_FAN_SWEEP_DONE || sweep->phase == APP_FAN_SWEEP_FAILED) {
+            finish_fan_calibration(fan_config, sweep);
+        } else {
+            s_fan_bank.stage(fan_config->channel, duty, true);
+        }
+    }
+}
+#endif // CONFIG_FAN_CALIBRATION
+
+#if CONFIG_FAN_CLOSED_LOOP || CONFIG_FAN_CALIBRATION
+static void tach_window_cb(void *arg)
+{
+    xTaskNotify(s_driver_task, DRIVER_NOTIFY_CONTROL_TICK, eSetBits);
+}
+#endif
+#endif // CONFIG_FAN_TACH_ENABLE
+
+/* Output of a fan in percent: the measured speed with a tach, on the same scale as the setpoint of the fan's curve,
+   otherwise the duty the LEDC currently outputs, which differs from the target while a ramp is running */
+static uint8_t fan_output_percent(const led_config_t *fan_config, bool *settled)
+{
+#if CONFIG_FAN_TACH_ENABLE
+    uint32_t percent = app_fan_curve_rpm_to_percent(fan_config->rpm_span.load(std::memory_order_relaxed),
+                                                    app_tach_get_rpm(fan_config->channel), CONFIG_FAN_MAX_RPM);
+    *settled = false;
+#else
+    uint32_t duty = s_fan_bank.duty(fan_config->channel);
+    uint32_t percent = (duty * 100 + (FAN_BANK_DUTY_MAX - 1) / 2) / (FAN_BANK_DUTY_MAX - 1);
+    *settled = duty == s_fan_bank.target(fan_config->channel);
+#endif
+    return percent > 100 ? 100 : percent;
+}
+
+/* Runs on the CHIP thread, reports the fans selected by the report timer */
+static void app_driver_fan_report_current(intptr_t arg)
+{
+    uint32_t pending = (uint32_t)arg;
+    for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+        if (!(pending & (1u << i))) {
+            continue;
+        }
+        led_config_t *fan_config = &fan_configs[i];
+        uint8_t percent = fan_config->percent_report.reported;
+        esp_matter_attr_val_t val = esp_matter_uint8(percent);
+        attribute::update(fan_config->endpoint_id, FanControl::Id, Attributes::PercentCurrent::Id, &val);
+
+        uint8_t speed = percent_to_speed(percent);
+        if (fan_config->attributes.speed_current && speed != fan_config->reported_speed) {
+            val = esp_matter_uint8(speed);
+            attribute::update(fan_config->endpoint_id, FanControl::Id, Attributes::SpeedCurrent::Id, &val);
+            fan_config->reported_speed = speed;
+        }
+    }
+}
+
+/* Samples the output of every fan and only wakes the CHIP thread if a fan has a change worth reporting, a ramp
+   produces at most one report per FAN_REPORT_MIN_INTERVAL_MS instead of one per fade step */
+static void report_timer_cb(void *arg)
+{
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    uint32_t pending = 0;
+    app_report_coalescer_t previous[CONFIG_FAN_COUNT];
+    for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+        led_config_t *fan_config = &fan_configs[i];
+        if (fan_config->endpoint_id == 0) {
+            continue;
+        }
+        bool settled = false;
+        uint8_t percent = fan_output_percent(fan_config, &settled);
+        previous[i] = fan_config->percent_report;
+        if (app_report_coalescer_update(&s_report_config, &fan_config->percent_report, percent, settled, now_ms)) {
+            pending |= (1u << i);
+        }
+    }
+    if (pending &&
+        chip::DeviceLayer::PlatformMgr().ScheduleWork(app_driver_fan_report_current, (intptr_t)pending) !=
+            CHIP_NO_ERROR) {
+        /* Nothing was reported, the coalescers compare the next sample against the last value that was */
+        for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+            if (pending & (1u << i)) {
+                fan_configs[i].percent_report = previous[i];
+            }
+        }
+    }
+}
+
+static void driver_task(void *arg)
+{
+    while (true) {
+        uint32_t notified = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &notified, portMAX_DELAY);
+        uint32_t start = app_latency_now();
+
+        if (notified & DRIVER_NOTIFY_COMMAND) {
+            /* Only the latest target per fan reaches the hardware, bursts of writes collapse into one commit */
+            uint8_t latest[CONFIG_FAN_COUNT] = {};
+            uint8_t pulse[CONFIG_FAN_COUNT] = {};
+            uint32_t pending = 0;
+            uint32_t pulses = 0;
+            fan_command_t command;
+            /* Local commands are newer than anything the CHIP thread queued before them */
+            while (s_command_ring.pop(command) || s_local_ring.pop(command)) {
+                if (command.type == FAN_COMMAND_PULSE) {
+                    pulse[command.fan_index] = command.percent;
+                    pulses |= (1u << command.fan_index);
+                    continue;
+                }
+#if CONFIG_FAN_CALIBRATION
+                if (command.type == FAN_COMMAND_CALIBRATE) {
+                    start_fan_calibration(&fan_configs[command.fan_index]);
+                    continue;
                 }
+#endif
+                latest[command.fan_index] = command.percent;
+                pending |= (1u << command.fan_index);
             }
-            // set_attribute(endpoint_id, FanControl::Id, FanControl::Attributes::PercentCurrent::Id, val_a);
-        } else if (attribute_id == FanControl::Attributes::PercentSetting::Id) {
-            /* When the Percent setting attribute change, should check the FanMode value, if not match, need write
-               the FanMode value to the corresponding FanMode.*/
-            esp_matter_attr_val_t val_b = esp_matter_invalid(NULL);
-            get_attribute(endpoint_id, FanControl::Id, Attributes::FanMode::Id, &val_b);
-            if (!check_if_mode_percent_match(val_b.val.u8, val->val.u8)) {
-                if (val->val.u8 >= HIGH_MODE_PERCENT_MIN) {
-                    /* set high mode */
-                    val_b.val.u8 = chip::to_underlying(FanModeEnum::kHigh);
-                    set_attribute(endpoint_id, FanControl::Id, Attributes::FanMode::Id, val_b);
-                } else if (val->val.u8 >= MED_MODE_PERCENT_MIN) {
-                    /* set med mode */
-                    val_b.val.u8 = chip::to_underlying(FanModeEnum::kMedium);
-                    set_attribute(endpoint_id, FanControl::Id, Attributes::FanMode::Id, val_b);
-                } else if (val->val.u8 >= LOW_MODE_PERCENT_MIN) {
-                    /* set low mode */
-                    val_b.val.u8 = chip::to_underlying(FanModeEnum::kLow);
-                    set_attribute(endpoint_id, FanControl::Id, Attributes::FanMode::Id, val_b);
+            for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+                if (pending & (1u << i)) {
+                    apply_fan_speed(&fan_configs[i], latest[i]);
                 }
+                if (pulses & (1u << i)) {
+                    start_fan_pulse(&fan_configs[i], pulse[i]);
+                }
+            }
+        }
+        if (notified & DRIVER_NOTIFY_PULSE_END) {
+            end_fan_pulses();
+        }
+        if (notified & DRIVER_NOTIFY_KICK_END) {
+            end_fan_kicks();
+        }
+#if CONFIG_FAN_CLOSED_LOOP
+        if (notified & DRIVER_NOTIFY_CONTROL_TICK) {
+            fan_control_tick();
+        }
+#endif
+#if CONFIG_FAN_CALIBRATION
+        if (notified & DRIVER_NOTIFY_CONTROL_TICK) {
+            fan_calibration_tick();
+        }
+#endif
+        esp_err_t err = s_fan_bank.commit();
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to commit fan speeds: %s", esp_err_to_name(err));
+        }
+        app_latency_record(APP_LATENCY_FAN_COMMIT, 0, start);
+    }
+}
 
+esp_err_t app_driver_fan_auto_temperature(int16_t temperature)
+{
+    if (!app_fan_auto_update(&s_auto_config, &s_auto_state, temperature)) {
+        return ESP_OK;
+    }
+
+    APP_TRACE(APP_TRACE_AUTO_RECOMPUTE, 0, TemperatureMeasurement::Id, 0, (uint32_t)temperature,
+              s_auto_state.percent);
+    esp_err_t err = ESP_OK;
+    for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+        if (fan_configs[i].auto_mode) {
+            /* Restored after a reboot until the first temperature sample arrives */
+            app_persist_set_fan(fan_configs[i].channel, fan_configs[i].fan_mode, s_auto_state.percent);
+            err |= set_fan_speed(&fan_configs[i], s_auto_state.percent);
+        }
+    }
+    return err;
+}
+
+/* Runs on the CHIP thread after a FanMode write of an unsupported mode has been stored */
+static void write_reconciled_fan_mode(intptr_t arg)
+{
+    uint16_t endpoint_id = (uint16_t)arg;
+    led_config_t *fan_config = fan_for_endpoint(endpoint_id);
+    if (!fan_config) {
+        return;
+    }
+    esp_matter_attr_val_t mode_val = esp_matter_enum8(fan_config->fan_mode.load(std::memory_order_relaxed));
+    set_attribute(endpoint_id, fan_config->attributes.fan_mode, &mode_val);
+    /* The unsupported mode was already reported with the write, subscribers only see the correction if it is
+       reported as well */
+    MatterReportingAttributeChangeCallback(endpoint_id, FanControl::Id, FanControl::Attributes::FanMode::Id);
+}
+
+static esp_err_t driver_attribute_update(app_driver_handle_t driver_handle, uint16_t endpoint_id, uint32_t cluster_id,
+                                         uint32_t attribute_id, esp_matter_attr_val_t *val)
+{
+    if (cluster_id == TemperatureMeasurement::Id &&
+        attribute_id == TemperatureMeasurement::Attributes::MeasuredValue::Id) {
+        if (val->val.i16 == INT16_MIN) {
+            /* null */
+            return ESP_OK;
+        }
+        return app_driver_fan_auto_temperature(val->val.i16);
+    }
+    if (cluster_id != FanControl::Id) {
+        return ESP_OK;
+    }
+
+    led_config_t *fan_config = fan_for_endpoint(endpoint_id);
+    if (!fan_config) {
+        return ESP_OK;
+    }
+    fan_attribute_cache_t *attributes = &fan_config->attributes;
+    const fan_mode_table_t &mode_table = *fan_config->mode_table;
+
+    uint8_t fan_mode;
+    uint8_t percent;
+    if (attribute_id == FanControl::Attributes::FanMode::Id) {
+        /* When FanMode attribute change, the percent setting must lie inside the band of the new mode. If it does
+           not, the percent setting is moved to the max value of the FanMode. */
+        fan_mode = val->val.u8;
+        if (fan_mode >= k_fan_mode_count) {
+            return ESP_OK;
+        }
+        esp_matter_attr_val_t mode_val = esp_matter_invalid(NULL);
+        get_attribute(endpoint_id, attributes->fan_mode, &mode_val);
+        APP_TRACE(APP_TRACE_ATTRIBUTE_WRITE, endpoint_id, cluster_id, attribute_id, mode_val.val.u8, fan_mode);
+
+        esp_matter_attr_val_t percent_val = esp_matter_invalid(NULL);
+        get_attribute(endpoint_id, attributes->percent_setting, &percent_val);
+
+        fan_mode_reconcile_t reconciled = fan_mode_reconcile_mode_write(mode_table, fan_mode, percent_val.val.u8);
+        if (reconciled.percent_changed) {
+            APP_TRACE(APP_TRACE_RECONCILE, endpoint_id, cluster_id, Attributes::PercentSetting::Id,
+                      percent_val.val.u8, reconciled.percent);
+            percent_val.val.u8 = reconciled.percent;
+            set_attribute(endpoint_id, attributes->percent_setting, &percent_val);
+        }
+        percent = reconciled.percent;
+        /* A mode the FanModeSequence does not support is replaced by the mode whose band it was given. The written
+           value is only stored once this callback returns, so FanMode is corrected after that. */
+        if (reconciled.fan_mode_changed) {
+            APP_TRACE(APP_TRACE_RECONCILE, endpoint_id, cluster_id, Attributes::FanMode::Id, fan_mode,
+                      reconciled.fan_mode);
+            fan_mode = reconciled.fan_mode;
+            if (chip::DeviceLayer::PlatformMgr().ScheduleWork(write_reconciled_fan_mode, endpoint_id) !=
+                CHIP_NO_ERROR) {
+                ESP_LOGE(TAG, "Failed to schedule the FanMode update of endpoint %d", endpoint_id);
             }
-            // set_attribute(endpoint_id, FanControl::Id, FanControl::Attributes::PercentCurrent::Id, *val);
-            /* add percent setting driver */
-            // app_driver_fan_set_percent(*val);
         }
+        /* In Auto mode the speed comes from the temperature input, until the first sample arrives the fan keeps
+           its current percent */
+        if (fan_mode == chip::to_underlying(FanModeEnum::kAuto) && s_auto_state.valid) {
+            percent = s_auto_state.percent;
+        }
+    } else if (attribute_id == FanControl::Attributes::PercentSetting::Id) {
+        /* When the Percent setting attribute change, the FanMode is kept if the percent lies inside its band,
+           otherwise it is moved to the mode the percent maps to. */
+        if (val->val.u8 == UINT8_MAX) {
+            /* null */
+            return ESP_OK;
+        }
+        esp_matter_attr_val_t percent_val = esp_matter_invalid(NULL);
+        get_attribute(endpoint_id, attributes->percent_setting, &percent_val);
+        APP_TRACE(APP_TRACE_ATTRIBUTE_WRITE, endpoint_id, cluster_id, attribute_id, percent_val.val.u8, val->val.u8);
+
+        esp_matter_attr_val_t mode_val = esp_matter_invalid(NULL);
+        get_attribute(endpoint_id, attributes->fan_mode, &mode_val);
+
+        fan_mode_reconcile_t reconciled = fan_mode_reconcile_percent_write(mode_table, mode_val.val.u8, val->val.u8);
+        percent = reconciled.percent;
+        fan_mode = reconciled.fan_mode;
+        if (reconciled.fan_mode_changed) {
+            APP_TRACE(APP_TRACE_RECONCILE, endpoint_id, cluster_id, Attributes::FanMode::Id, mode_val.val.u8,
+                      fan_mode);
+            mode_val.val.u8 = fan_mode;
+            set_attribute(endpoint_id, attributes->fan_mode, &mode_val);
+        }
+    } else if (attribute_id == FanControl::Attributes::SpeedSetting::Id) {
+        /* A SpeedSetting write is applied as the corresponding PercentSetting */
+        if (val->val.u8 == UINT8_MAX) {
+            return ESP_OK;
+        }
+        uint8_t speed = val->val.u8 > CONFIG_FAN_SPEED_MAX ? CONFIG_FAN_SPEED_MAX : val->val.u8;
+        APP_TRACE(APP_TRACE_ATTRIBUTE_WRITE, endpoint_id, cluster_id, attribute_id, 0, speed);
+        percent = speed_to_percent(speed);
+        fan_mode = mode_table.percent_to_mode[percent];
+        esp_matter_attr_val_t percent_val = esp_matter_nullable_uint8(percent);
+        set_attribute(endpoint_id, attributes->percent_setting, &percent_val);
+        esp_matter_attr_val_t mode_val = esp_matter_enum8(fan_mode);
+        set_attribute(endpoint_id, attributes->fan_mode, &mode_val);
+    } else {
+        return ESP_OK;
+    }
+
+    fan_config->fan_mode = fan_mode;
+    fan_config->auto_mode = fan_mode == chip::to_underlying(FanModeEnum::kAuto);
+    if (attributes->speed_setting && attribute_id != FanControl::Attributes::SpeedSetting::Id &&
+        !fan_config->auto_mode) {
+        esp_matter_attr_val_t speed_val = esp_matter_nullable_uint8(percent_to_speed(percent));
+        set_attribute(endpoint_id, attributes->speed_setting, &speed_val);
+    }
+
+    app_persist_set_fan(fan_config->channel, fan_mode, percent);
+
+    esp_err_t err = set_fan_speed(fan_config, percent);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set fan speed on endpoint %d", endpoint_id);
+    }
+    return err;
+}
+
+esp_err_t app_driver_attribute_update(app_driver_handle_t driver_handle, uint16_t endpoint_id, uint32_t cluster_id,
+                                      uint32_t attribute_id, esp_matter_attr_val_t *val)
+{
+    uint32_t start = app_latency_now();
+    esp_err_t err = driver_attribute_update(driver_handle, endpoint_id, cluster_id, attribute_id, val);
+    app_latency_record(APP_LATENCY_DRIVER_UPDATE, endpoint_id, start);
+    return err;
+}
+
+esp_err_t app_driver_fan_bind_endpoint(app_driver_handle_t driver_handle, size_t fan_index, uint16_t endpoint_id)
+{
+    led_config_t *fan_configs = (led_config_t *)driver_handle;
+    if (!fan_configs || fan_index >= CONFIG_FAN_COUNT || endpoint_id >= FAN_DISPATCH_SIZE) {
+        ESP_LOGE(TAG, "Cannot bind fan %d to endpoint %d", (int)fan_index, endpoint_id);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cluster_t *cluster = cluster::get(endpoint::get(node::get(), endpoint_id), FanControl::Id);
+    fan_attribute_cache_t attributes = {
+        .fan_mode = attribute::get(cluster, Attributes::FanMode::Id),
+        .percent_setting = attribute::get(cluster, Attributes::PercentSetting::Id),
+        .percent_current = attribute::get(cluster, Attributes::PercentCurrent::Id),
+        .fan_mode_sequence = attribute::get(cluster, Attributes::FanModeSequence::Id),
+        .speed_setting = attribute::get(cluster, Attributes::SpeedSetting::Id),
+        .speed_current = attribute::get(cluster, Attributes::SpeedCurrent::Id),
+    };
+    if (!attributes.fan_mode || !attributes.percent_setting || !attributes.percent_current ||
+        !attributes.fan_mode_sequence) {
+        ESP_LOGE(TAG, "Endpoint %d has no complete FanControl cluster", endpoint_id);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    led_config_t *fan_config = &fan_configs[k_fan_endpoints[fan_index].channel];
+    fan_config->attributes = attributes;
+    fan_config->endpoint_id = endpoint_id;
+    s_endpoint_fans[endpoint_id] = fan_config;
+    return ESP_OK;
+}
+
+esp_err_t app_driver_fan_identify_pulse(app_driver_handle_t driver_handle, uint16_t endpoint_id)
+{
+    led_config_t *fan_config = fan_for_endpoint(endpoint_id);
+    if (!fan_config) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t err = push_command(s_command_ring, fan_config, FAN_COMMAND_PULSE, CONFIG_FAN_IDENTIFY_PULSE_PERCENT);
+    if (err == ESP_OK) {
+        notify_driver_deferred();
     }
     return err;
 }
 
+esp_err_t app_driver_fan_calibrate(app_driver_handle_t driver_handle, uint16_t endpoint_id, bool force)
+{
+#if CONFIG_FAN_CALIBRATION
+    led_config_t *fan_config = fan_for_endpoint(endpoint_id);
+    if (!fan_config) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (fan_config->calibrated && !force) {
+        return ESP_OK;
+    }
+    esp_err_t err = push_command(s_command_ring, fan_config, FAN_COMMAND_CALIBRATE, 0);
+    if (err == ESP_OK) {
+        notify_driver_deferred();
+    }
+    return err;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t app_driver_fan_set_slew_rate(app_driver_handle_t driver_handle, uint16_t endpoint_id,
+                                       uint32_t percent_per_sec)
+{
+    led_config_t *fan_config = fan_for_endpoint(endpoint_id);
+    if (!fan_config) {
+        ESP_LOGE(TAG, "No fan for endpoint %d", endpoint_id);
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_fan_bank.set_slew_rate(fan_config->channel, percent_per_sec);
+    return ESP_OK;
+}
+
+/* Bring every fan back to its last persisted state at once, so hardware cooled by the fans gets airflow right
+   after boot instead of when the Matter stack is up. Runs before the driver task exists, the bank is still ours. */
+static void fan_restore()
+{
+    for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+        led_config_t *fan_config = &fan_configs[i];
+        app_persist_fan_t state;
+        if (app_persist_get_fan(fan_config->channel, &state) != ESP_OK || state.percent > 100) {
+            continue;
+        }
+        s_fan_bank.set_slew_rate(fan_config->channel, 0);
+        apply_fan_speed(fan_config, state.percent);
+        fan_config->fan_mode = state.fan_mode;
+        fan_config->auto_mode = state.fan_mode == chip::to_underlying(FanModeEnum::kAuto);
+        /* app_main() seeds PercentCurrent and SpeedCurrent with the same values */
+        fan_config->percent_report.reported = state.percent;
+        fan_config->reported_speed = percent_to_speed(state.percent);
+    }
+    esp_err_t err = s_fan_bank.commit();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to restore fan speeds: %s", esp_err_to_name(err));
+    }
+    for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+        s_fan_bank.set_slew_rate(fan_configs[i].channel, CONFIG_FAN_SLEW_RATE_PERCENT_PER_SEC);
+    }
+}
+
 // app_driver_handle_t app_driver_button_init()
 // {
 //     /* Initialize button */
@@ -279,26 +844,82 @@ esp_err_t app_driver_attribute_update(app_driver_handle_t driver_handle, uint16_
 
 app_driver_handle_t app_driver_fan_init()
 {
-    for (int i = 0; i < MAX_LEDS; i++) {
-        ledc_timer_config_t ledc_timer = {
-            .speed_mode = LEDC_LOW_SPEED_MODE,
-            .duty_resolution = LEDC_TIMER_13_BIT,
-            .timer_num = fan_configs[i].timer,
-            .freq_hz = 5000,
-            .clk_cfg = LEDC_AUTO_CLK
-        };
-        ESP_ERROR_CHECK(ledc_timer_config(&ledc_timer));
-
-        ledc_channel_config_t ledc_channel = {
-            .gpio_num = fan_configs[i].gpio,
-            .speed_mode = LEDC_LOW_SPEED_MODE,
-            .channel = fan_configs[i].channel,
-            .intr_type = LEDC_INTR_DISABLE,
-            .timer_sel = fan_configs[i].timer,
-            .duty = 0,
-            .hpoint = 0
-        };
-        ESP_ERROR_CHECK(ledc_channel_config(&ledc_channel));
+    gpio_num_t fan_gpios[CONFIG_FAN_COUNT];
+    for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+        /* fan_configs is indexed by bank channel like the command ring and the tach */
+        const app_fan_endpoint_config_t &fan = k_fan_endpoints[i];
+        fan_configs[fan.channel].gpio = fan.gpio;
+        fan_configs[fan.channel].channel = fan.channel;
+        fan_configs[fan.channel].mode_table = &k_fan_mode_tables[fan.fan_mode_sequence];
+        fan_gpios[fan.channel] = fan.gpio;
+#if CONFIG_FAN_TACH_SOURCE_PCNT
+        fan_tach_gpios[fan.channel] = fan.tach_gpio;
+#endif
+    }
+    for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+        led_config_t *fan_config = &fan_configs[i];
+        fan_config->calibrated = app_persist_get_curve(fan_config->channel, &fan_config->curve) == ESP_OK &&
+                                 fan_config->curve.duty_max == FAN_BANK_DUTY_MAX - 1;
+        if (!fan_config->calibrated) {
+            app_fan_curve_linear(FAN_BANK_DUTY_MAX - 1, &fan_config->curve);
+        }
+        fan_config->rpm_span.store(fan_config->curve.span, std::memory_order_relaxed);
+    }
+    ESP_ERROR_CHECK(s_fan_bank.init(fan_gpios, CONFIG_FAN_SLEW_RATE_PERCENT_PER_SEC));
+    esp_timer_create_args_t pulse_timer_args = {
+        .callback = pulse_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "fan_pulse",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&pulse_timer_args, &s_pulse_timer));
+    /* A restored fan that stands still gets a kick-start, the kick ends long after the driver task exists */
+    esp_timer_create_args_t kick_timer_args = {
+        .callback = kick_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "fan_kick",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&kick_timer_args, &s_kick_timer));
+    fan_restore();
+    BaseType_t created = xTaskCreate(driver_task, "fan_driver", DRIVER_TASK_STACK_SIZE, NULL, DRIVER_TASK_PRIORITY,
+                                     &s_driver_task);
+    ESP_ERROR_CHECK(created == pdPASS ? ESP_OK : ESP_ERR_NO_MEM);
+    app_mem_register_task(s_driver_task, DRIVER_TASK_STACK_SIZE);
+
+#if CONFIG_FAN_TACH_ENABLE
+    app_tach_config_t tach_config = {
+#if CONFIG_FAN_TACH_SOURCE_PCNT
+        .gpios = fan_tach_gpios,
+#else
+        .gpios = NULL,
+#endif
+        .fan_count = CONFIG_FAN_COUNT,
+        .get_duty_permille = fan_duty_permille,
+#if CONFIG_FAN_CLOSED_LOOP || CONFIG_FAN_CALIBRATION
+        .window_cb = tach_window_cb,
+#else
+        .window_cb = NULL,
+#endif
+        .window_cb_arg = NULL,
+    };
+    if (app_tach_init(&tach_config) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize the tach capture");
+    }
+#endif
+
+    esp_timer_create_args_t report_timer_args = {
+        .callback = report_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "fan_report",
+        .skip_unhandled_events = true,
+    };
+    if (esp_timer_create(&report_timer_args, &s_report_timer) != ESP_OK ||
+        esp_timer_start_periodic(s_report_timer, FAN_REPORT_SAMPLE_MS * 1000) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start the PercentCurrent reporting");
     }
 
     return (app_driver_handle_t)fan_configs;
@@ -323,16 +944,143 @@ app_driver_handle_t app_driver_button_init(gpio_num_t * reset_gpio)
     return reset_handle;
 }
 
-void led_init()
+/* Next mode of the local FanMode cycle Off -> Low -> Medium -> High -> Off, skipping modes the fan's FanModeSequence
+   does not support */
+static uint8_t next_local_mode(const led_config_t *fan_config)
 {
-    gpio_config_t io_conf = {};
-    io_conf.intr_type = GPIO_INTR_DISABLE;
-    io_conf.mode = GPIO_MODE_OUTPUT;
-    io_conf.pin_bit_mask = (1ULL << (gpio_num_t)CONFIG_LED_PIN);
-    io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-    io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
-    gpio_config(&io_conf);
+    static const uint8_t cycle[] = { APP_FAN_MODE_OFF, APP_FAN_MODE_LOW, APP_FAN_MODE_MEDIUM, APP_FAN_MODE_HIGH };
+    const size_t count = sizeof(cycle) / sizeof(cycle[0]);
+    uint8_t fan_mode = fan_config->fan_mode.load(std::memory_order_relaxed);
+    size_t position = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (cycle[i] == fan_mode) {
+            position = i;
+        }
+    }
+    for (size_t i = 1; i <= count; i++) {
+        uint8_t mode = cycle[(position + i) % count];
+        /* Unsupported modes stand for the next higher supported one */
+        if (fan_config->mode_table->range[mode].mode == mode) {
+            return mode;
+        }
+    }
+    return APP_FAN_MODE_OFF;
+}
+
+/* Runs on the CHIP thread. Writing FanMode through the data model runs the usual reconciliation and reports it, the
+   PercentSetting and SpeedSetting adjusted by the reconciliation are reported as well. */
+static void local_control_sync(intptr_t arg)
+{
+    led_config_t *fan_config = &fan_configs[arg & 0xff];
+    uint8_t fan_mode = (arg >> 8) & 0xff;
+    esp_matter_attr_val_t val = esp_matter_enum8(fan_mode);
+    attribute::update(fan_config->endpoint_id, FanControl::Id, Attributes::FanMode::Id, &val);
+    MatterReportingAttributeChangeCallback(fan_config->endpoint_id, FanControl::Id, Attributes::PercentSetting::Id);
+    if (fan_config->attributes.speed_setting) {
+        MatterReportingAttributeChangeCallback(fan_config->endpoint_id, FanControl::Id, Attributes::SpeedSetting::Id);
+    }
+}
 
-    // Schalten Sie die LED standardmäßig aus
-    gpio_set_level((gpio_num_t)CONFIG_LED_PIN, 0);
+/* Single click: step the selected fan to its next FanMode. The PWM changes at once, the data model follows. */
+static void button_single_click_cb(void *arg, void *data)
+{
+    uint32_t start = app_latency_now();
+    led_config_t *fan_config = &fan_configs[s_local_fan];
+    if (fan_config->endpoint_id == 0) {
+        return;
+    }
+    uint8_t fan_mode = next_local_mode(fan_config);
+    uint8_t percent = fan_config->mode_table->range[fan_mode].percent_max;
+    if (push_command(s_local_ring, fan_config, FAN_COMMAND_SET_SPEED, percent) != ESP_OK) {
+        return;
+    }
+    xTaskNotify(s_driver_task, DRIVER_NOTIFY_COMMAND, eSetBits);
+    app_latency_record(APP_LATENCY_LOCAL_CONTROL, fan_config->endpoint_id, start);
+    /* fan_config->fan_mode belongs to the CHIP thread, local_control_sync() updates it through the FanMode write */
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(local_control_sync, (intptr_t)(s_local_fan | (fan_mode << 8)));
 }
+
+/* Double click: select the next fan for local control and pulse it, so it is clear which fan is selected */
+static void button_double_click_cb(void *arg, void *data)
+{
+    s_local_fan = (s_local_fan + 1) % CONFIG_FAN_COUNT;
+    led_config_t *fan_config = &fan_configs[s_local_fan];
+    if (fan_config->endpoint_id != 0 &&
+        push_command(s_local_ring, fan_config, FAN_COMMAND_PULSE, CONFIG_FAN_IDENTIFY_PULSE_PERCENT) == ESP_OK) {
+        xTaskNotify(s_driver_task, DRIVER_NOTIFY_COMMAND, eSetBits);
+    }
+}
+
+esp_err_t app_driver_button_register_local_control(app_driver_handle_t button_handle)
+{
+    if (!button_handle) {
+        ESP_LOGE(TAG, "Handle cannot be NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = ESP_OK;
+    err |= iot_button_register_cb((button_handle_t)button_handle, BUTTON_SINGLE_CLICK, button_single_click_cb, NULL);
+    err |= iot_button_register_cb((button_handle_t)button_handle, BUTTON_DOUBLE_CLICK, button_double_click_cb, NULL);
+    return err;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static void calibrate_work(intptr_t arg)
+{
+    for (int i = 0; i < CONFIG_FAN_COUNT; i++) {
+        if (arg == -1 || fan_configs[i].endpoint_id == arg) {
+            app_driver_fan_calibrate(fan_configs, fan_configs[i].endpoint_id, true);
+        }
+    }
+}
+
+static esp_err_t curve_command_handler(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[0], "calibrate") == 0) {
+        intptr_t endpoint_id = strcmp(argv[1], "all") == 0 ? -1 : atoi(argv[1]);
+        chip::DeviceLayer::PlatformMgr().ScheduleWork(calibrate_work, endpoint_id);
+        return ESP_OK;
+    }
+    if (argc == 2 && strcmp(argv[0], "dump") == 0) {
+        led_config_t *fan_config = fan_for_endpoint(atoi(argv[1]));
+        if (!fan_config) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        printf("calibrated,%d,start_duty,%u,rpm_min,%u,rpm_max,%u\n", fan_config->calibrated,
+               fan_config->curve.start_duty, fan_config->curve.span.rpm_min, fan_config->curve.span.rpm_max);
+        printf("percent,duty\n");
+        for (int percent = 0; percent < APP_FAN_CURVE_POINTS; percent++) {
+            printf("%d,%u\n", percent, fan_config->curve.duty[percent]);
+        }
+#if CONFIG_FAN_CALIBRATION
+        /* The samples of the last sweep since boot, to replay the fit on a host */
+        const app_fan_sweep_t *sweep = &s_sweeps[fan_config->channel];
+        printf("duty,rpm\n");
+        for (int i = 0; i < sweep->count; i++) {
+            printf("%u,%u\n", sweep->samples[i].duty, sweep->samples[i].rpm);
+        }
+#endif
+        return ESP_OK;
+    }
+    ESP_LOGE(TAG, "Usage: curve calibrate <endpoint>|all, curve dump <endpoint>");
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t app_driver_fan_register_commands()
+{
+    static const esp_matter::console::command_t command = {
+        .name = "curve",
+        .description = "Calibrate or print the duty curves of the fans. "
+                       "Usage: matter esp curve calibrate <endpoint>|all, matter esp curve dump <endpoint>",
+        .handler = curve_command_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+}
+
+#else
+
+esp_err_t app_driver_fan_register_commands()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_ENABLE_CHIP_SHELL
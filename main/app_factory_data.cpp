@@ -0,0 +1,268 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+
+#include <esp_matter_providers.h>
+#include <crypto/CHIPCryptoPAL.h>
+#include <lib/support/Base64.h>
+#include <lib/support/Span.h>
+#include <platform/ESP32/ESP32FactoryDataProvider.h>
+
+#include <app_factory_data.h>
+#include <app_factory_nvs.h>
+
+#define FACTORY_NAMESPACE       "chip-factory"
+
+using namespace chip;
+
+static const char *TAG = "app_factory_data";
+
+#if CONFIG_APP_FACTORY_DATA_MMAP
+
+/* The items of the mapped partition, empty spans and `false` for the ones the mapping does not hold */
+typedef struct {
+    ByteSpan dac_cert;
+    ByteSpan dac_key;
+    ByteSpan dac_pub_key;
+    ByteSpan pai_cert;
+    ByteSpan cert_dclrn;
+    ByteSpan salt; // Base64
+    ByteSpan verifier; // Base64
+    uint32_t discriminator;
+    uint32_t iteration_count;
+    bool has_discriminator;
+    bool has_iteration_count;
+} factory_data_t;
+
+/* Decode into a buffer of the largest size the base64 text can decode to, the caller's buffer may be smaller */
+template <size_t N>
+static CHIP_ERROR decode_base64(ByteSpan encoded, MutableByteSpan &out, size_t &out_len)
+{
+    uint8_t decoded[BASE64_MAX_DECODED_LEN(BASE64_ENCODED_LEN(N))];
+    VerifyOrReturnError(BASE64_MAX_DECODED_LEN(encoded.size()) <= sizeof(decoded), CHIP_ERROR_BUFFER_TOO_SMALL);
+    uint32_t len = Base64Decode32(reinterpret_cast<const char *>(encoded.data()),
+                                  static_cast<uint32_t>(encoded.size()), decoded);
+    VerifyOrReturnError(len != UINT32_MAX, CHIP_ERROR_INVALID_ARGUMENT);
+    VerifyOrReturnError(len <= out.size(), CHIP_ERROR_BUFFER_TOO_SMALL);
+    memcpy(out.data(), decoded, len);
+    out_len = len;
+    return CHIP_NO_ERROR;
+}
+
+/* Serves the factory data from the flash mapping. Every getter falls back to the NVS API of the base class for
+   items the mapping does not hold. The getters have to copy into the caller's buffer, but they do it straight
+   from flash without opening an NVS handle or staging the data in a buffer of their own. */
+class factory_data_provider : public DeviceLayer::ESP32FactoryDataProvider {
+public:
+    void set_data(const factory_data_t &data) { m_data = data; }
+
+    CHIP_ERROR GetSetupDiscriminator(uint16_t &setupDiscriminator) override
+    {
+        if (!m_data.has_discriminator) {
+            return ESP32FactoryDataProvider::GetSetupDiscriminator(setupDiscriminator);
+        }
+        setupDiscriminator = static_cast<uint16_t>(m_data.discriminator);
+        return CHIP_NO_ERROR;
+    }
+
+    CHIP_ERROR GetSpake2pIterationCount(uint32_t &iterationCount) override
+    {
+        if (!m_data.has_iteration_count) {
+            return ESP32FactoryDataProvider::GetSpake2pIterationCount(iterationCount);
+        }
+        iterationCount = m_data.iteration_count;
+        return CHIP_NO_ERROR;
+    }
+
+    CHIP_ERROR GetSpake2pSalt(MutableByteSpan &saltBuf) override
+    {
+        if (m_data.salt.empty()) {
+            return ESP32FactoryDataProvider::GetSpake2pSalt(saltBuf);
+        }
+        size_t len;
+        ReturnErrorOnFailure(decode_base64<Crypto::kSpake2p_Max_PBKDF_Salt_Length>(m_data.salt, saltBuf, len));
+        saltBuf.reduce_size(len);
+        return CHIP_NO_ERROR;
+    }
+
+    CHIP_ERROR GetSpake2pVerifier(MutableByteSpan &verifierBuf, size_t &verifierLen) override
+    {
+        if (m_data.verifier.empty()) {
+            return ESP32FactoryDataProvider::GetSpake2pVerifier(verifierBuf, verifierLen);
+        }
+        ReturnErrorOnFailure(
+            decode_base64<Crypto::kSpake2p_VerifierSerialized_Length>(m_data.verifier, verifierBuf, verifierLen));
+        verifierBuf.reduce_size(verifierLen);
+        return CHIP_NO_ERROR;
+    }
+
+    CHIP_ERROR GetCertificationDeclaration(MutableByteSpan &outBuffer) override
+    {
+        if (m_data.cert_dclrn.empty()) {
+            return ESP32FactoryDataProvider::GetCertificationDeclaration(outBuffer);
+        }
+        return CopySpanToMutableSpan(m_data.cert_dclrn, outBuffer);
+    }
+
+    CHIP_ERROR GetDeviceAttestationCert(MutableByteSpan &outBuffer) override
+    {
+        if (m_data.dac_cert.empty()) {
+            return ESP32FactoryDataProvider::GetDeviceAttestationCert(outBuffer);
+        }
+        return CopySpanToMutableSpan(m_data.dac_cert, outBuffer);
+    }
+
+    CHIP_ERROR GetProductAttestationIntermediateCert(MutableByteSpan &outBuffer) override
+    {
+        if (m_data.pai_cert.empty()) {
+            return ESP32FactoryDataProvider::GetProductAttestationIntermediateCert(outBuffer);
+        }
+        return CopySpanToMutableSpan(m_data.pai_cert, outBuffer);
+    }
+
+    CHIP_ERROR SignWithDeviceAttestationKey(const ByteSpan &messageToSign, MutableByteSpan &outSignBuffer) override
+    {
+        if (m_data.dac_key.empty() || m_data.dac_pub_key.empty()) {
+            return ESP32FactoryDataProvider::SignWithDeviceAttestationKey(messageToSign, outSignBuffer);
+        }
+        Crypto::P256ECDSASignature signature;
+        VerifyOrReturnError(IsSpanUsable(outSignBuffer) && IsSpanUsable(messageToSign), CHIP_ERROR_INVALID_ARGUMENT);
+        VerifyOrReturnError(outSignBuffer.size() >= signature.Capacity(), CHIP_ERROR_BUFFER_TOO_SMALL);
+
+        /* The keypair is only deserialized from the mapped key for the signature, nothing keeps it in RAM */
+        Crypto::P256SerializedKeypair serialized;
+        size_t pub_key_size = m_data.dac_pub_key.size();
+        VerifyOrReturnError(pub_key_size + m_data.dac_key.size() <= serialized.Capacity(), CHIP_ERROR_INTERNAL);
+        ReturnErrorOnFailure(serialized.SetLength(pub_key_size + m_data.dac_key.size()));
+        memcpy(serialized.Bytes(), m_data.dac_pub_key.data(), pub_key_size);
+        memcpy(serialized.Bytes() + pub_key_size, m_data.dac_key.data(), m_data.dac_key.size());
+
+        Crypto::P256Keypair keypair;
+        CHIP_ERROR err = keypair.Deserialize(serialized);
+        Crypto::ClearSecretData(serialized.Bytes(), serialized.Length());
+        ReturnErrorOnFailure(err);
+        ReturnErrorOnFailure(keypair.ECDSA_sign_msg(messageToSign.data(), messageToSign.size(), signature));
+        return CopySpanToMutableSpan(ByteSpan{ signature.ConstBytes(), signature.Length() }, outSignBuffer);
+    }
+
+private:
+    factory_data_t m_data = {};
+};
+
+static factory_data_provider s_provider;
+static esp_partition_mmap_handle_t s_mmap_handle;
+
+static uint32_t rom_crc32(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    return esp_rom_crc32_le(crc, buf, len);
+}
+
+static bool find_span(const uint8_t *image, size_t size, const char *key, uint8_t type, ByteSpan *span)
+{
+    app_factory_nvs_item_t item;
+    if (!app_factory_nvs_find(image, size, FACTORY_NAMESPACE, key, type, rom_crc32, &item)) {
+        return false;
+    }
+    *span = ByteSpan(item.data, item.size);
+    return true;
+}
+
+static bool find_u32(const uint8_t *image, size_t size, const char *key, uint32_t *value)
+{
+    app_factory_nvs_item_t item;
+    if (!app_factory_nvs_find(image, size, FACTORY_NAMESPACE, key, APP_FACTORY_NVS_TYPE_U32, rom_crc32, &item)) {
+        return false;
+    }
+    *value = item.value;
+    return true;
+}
+
+/* Looks the items up once, the partition is never written at runtime, so the spans stay valid */
+static esp_err_t map_factory_partition(factory_data_t *data)
+{
+    /* The partition nvs_flash works on moves items between pages during garbage collection */
+    if (strcmp(CONFIG_APP_FACTORY_DATA_PARTITION_LABEL, CONFIG_ESP_MATTER_NVS_PART_NAME) == 0) {
+        ESP_LOGE(TAG, "Partition %s is written at runtime and cannot be mapped",
+                 CONFIG_APP_FACTORY_DATA_PARTITION_LABEL);
+        return ESP_ERR_INVALID_ARG;
+    }
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_NVS,
+                                                                CONFIG_APP_FACTORY_DATA_PARTITION_LABEL);
+    if (!partition) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    const void *mapped;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &mapped,
+                                       &s_mmap_handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    const uint8_t *image = static_cast<const uint8_t *>(mapped);
+    size_t size = partition->size;
+    int found = 0;
+    found += find_span(image, size, "dac-cert", APP_FACTORY_NVS_TYPE_BLOB, &data->dac_cert);
+    found += find_span(image, size, "dac-key", APP_FACTORY_NVS_TYPE_BLOB, &data->dac_key);
+    found += find_span(image, size, "dac-pub-key", APP_FACTORY_NVS_TYPE_BLOB, &data->dac_pub_key);
+    found += find_span(image, size, "pai-cert", APP_FACTORY_NVS_TYPE_BLOB, &data->pai_cert);
+    found += find_span(image, size, "cert-dclrn", APP_FACTORY_NVS_TYPE_BLOB, &data->cert_dclrn);
+    found += find_span(image, size, "salt", APP_FACTORY_NVS_TYPE_STR, &data->salt);
+    found += find_span(image, size, "verifier", APP_FACTORY_NVS_TYPE_STR, &data->verifier);
+    data->has_discriminator = find_u32(image, size, "discriminator", &data->discriminator);
+    data->has_iteration_count = find_u32(image, size, "iteration-count", &data->iteration_count);
+    found += data->has_discriminator + data->has_iteration_count;
+    if (found == 0) {
+        esp_partition_munmap(s_mmap_handle);
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_LOGI(TAG, "%d factory data items mapped from %s", found, CONFIG_APP_FACTORY_DATA_PARTITION_LABEL);
+    return ESP_OK;
+}
+
+esp_err_t app_factory_data_init()
+{
+    factory_data_t data = {};
+    esp_err_t err = map_factory_partition(&data);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "No factory data in %s, reading it from NVS partition %s: %d",
+                 CONFIG_APP_FACTORY_DATA_PARTITION_LABEL, CONFIG_CHIP_FACTORY_NAMESPACE_PARTITION_LABEL, err);
+        data = {};
+    }
+    s_provider.set_data(data);
+    esp_matter::set_custom_dac_provider(&s_provider);
+    esp_matter::set_custom_commissionable_data_provider(&s_provider);
+    return ESP_OK;
+}
+
+#else
+
+#if CONFIG_ENABLE_ESP32_FACTORY_DATA_PROVIDER
+/* esp_matter registers no provider of its own for a custom one, without the mapping the NVS API serves it */
+static DeviceLayer::ESP32FactoryDataProvider s_provider;
+#endif
+
+esp_err_t app_factory_data_init()
+{
+#if CONFIG_ENABLE_ESP32_FACTORY_DATA_PROVIDER
+#if CONFIG_CUSTOM_DAC_PROVIDER
+    esp_matter::set_custom_dac_provider(&s_provider);
+#endif
+#if CONFIG_CUSTOM_COMMISSIONABLE_DATA_PROVIDER
+    esp_matter::set_custom_commissionable_data_provider(&s_provider);
+#endif
+    ESP_LOGI(TAG, "Factory data is read through the NVS API from %s", CONFIG_CHIP_FACTORY_NAMESPACE_PARTITION_LABEL);
+#endif
+    return ESP_OK;
+}
+
+#endif // CONFIG_APP_FACTORY_DATA_MMAP
@@ -0,0 +1,28 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+/** Install the factory data providers
+ *
+ * Maps the `CONFIG_APP_FACTORY_DATA_PARTITION_LABEL` partition read-only and registers itself as the custom DAC
+ * and commissionable data provider. The certificates, the certification declaration, the DAC key and the
+ * SPAKE2+ parameters of the `chip-factory` namespace are looked up once and then served from the mapping,
+ * without going through the NVS API. Items the mapping does not hold are read through the NVS API from
+ * `CONFIG_CHIP_FACTORY_NAMESPACE_PARTITION_LABEL` as before, so devices flashed with the factory data in `nvs`
+ * keep working. Without `CONFIG_APP_FACTORY_DATA_MMAP` a plain `ESP32FactoryDataProvider` is registered for the
+ * custom providers the sdkconfig selects.
+ *
+ * This must be called before `esp_matter::start()`.
+ *
+ * @return ESP_OK if the providers are registered, also if nothing could be mapped.
+ * @return error in case of failure.
+ */
+esp_err_t app_factory_data_init();
@@ -0,0 +1,165 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Read-only lookup of items in an NVS partition image in memory, e.g. a flash mapping, without the nvs_flash API.
+ * Only depends on a CRC32 function, so tools/mfg runs the same lookup on the generated partition images.
+ *
+ * Items are found the way nvs_flash finds them in a partition nobody writes to: pages that are neither active
+ * nor full or fail their header CRC are skipped, as are entries that are not marked written or fail their CRC.
+ */
+
+#define APP_FACTORY_NVS_PAGE_SIZE       4096
+#define APP_FACTORY_NVS_ENTRY_SIZE      32
+#define APP_FACTORY_NVS_ENTRY_COUNT     126
+#define APP_FACTORY_NVS_KEY_SIZE        16
+
+#define APP_FACTORY_NVS_TYPE_U8         0x01
+#define APP_FACTORY_NVS_TYPE_U16        0x02
+#define APP_FACTORY_NVS_TYPE_U32        0x04
+#define APP_FACTORY_NVS_TYPE_STR        0x21
+#define APP_FACTORY_NVS_TYPE_BLOB       0x42 // Data chunk, looked up through its index entry
+#define APP_FACTORY_NVS_TYPE_BLOB_IDX   0x48
+
+/** CRC32 as computed by esp_rom_crc32_le(), NVS seeds it with 0xFFFFFFFF */
+typedef uint32_t (*app_factory_nvs_crc32_t)(uint32_t crc, const uint8_t *buf, uint32_t len);
+
+typedef struct {
+    uint32_t value; // Unsigned integer types
+    const uint8_t *data; // Strings without the NUL and blobs, points into the image
+    size_t size;
+} app_factory_nvs_item_t;
+
+static inline uint32_t app_factory_nvs_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline bool app_factory_nvs_page_valid(const uint8_t *page, app_factory_nvs_crc32_t crc32)
+{
+    uint32_t state = app_factory_nvs_le32(page);
+    if (state != 0xFFFFFFFE && state != 0xFFFFFFFC) { // Active or full
+        return false;
+    }
+    return page[8] == 0xFE && crc32(0xFFFFFFFF, page + 4, 24) == app_factory_nvs_le32(page + 28);
+}
+
+/* The entry CRC leaves out the CRC field at bytes 4..8 */
+static inline bool app_factory_nvs_entry_valid(const uint8_t *entry, app_factory_nvs_crc32_t crc32)
+{
+    uint8_t buf[APP_FACTORY_NVS_ENTRY_SIZE - 4];
+    memcpy(buf, entry, 4);
+    memcpy(buf + 4, entry + 8, sizeof(buf) - 4);
+    return crc32(0xFFFFFFFF, buf, sizeof(buf)) == app_factory_nvs_le32(entry + 4);
+}
+
+/* First written entry with a valid CRC that matches namespace, type, chunk index (0xFF for any) and key */
+static inline const uint8_t *app_factory_nvs_find_entry(const uint8_t *image, size_t size, uint8_t ns, uint8_t type,
+                                                        uint8_t chunk_index, const char *key,
+                                                        app_factory_nvs_crc32_t crc32)
+{
+    for (size_t offset = 0; offset + APP_FACTORY_NVS_PAGE_SIZE <= size; offset += APP_FACTORY_NVS_PAGE_SIZE) {
+        const uint8_t *page = image + offset;
+        if (!app_factory_nvs_page_valid(page, crc32)) {
+            continue;
+        }
+        unsigned index = 0;
+        while (index < APP_FACTORY_NVS_ENTRY_COUNT) {
+            const uint8_t *entry = page + 2 * APP_FACTORY_NVS_ENTRY_SIZE + index * APP_FACTORY_NVS_ENTRY_SIZE;
+            unsigned state = (page[APP_FACTORY_NVS_ENTRY_SIZE + index / 4] >> ((index % 4) * 2)) & 3;
+            if (state != 2 || !app_factory_nvs_entry_valid(entry, crc32)) {
+                index++;
+                continue;
+            }
+            unsigned span = entry[2] ? entry[2] : 1;
+            if (entry[0] == ns && entry[1] == type && (chunk_index == 0xFF || entry[3] == chunk_index) &&
+                strncmp((const char *)entry + 8, key, APP_FACTORY_NVS_KEY_SIZE) == 0) {
+                return index + span <= APP_FACTORY_NVS_ENTRY_COUNT ? entry : NULL;
+            }
+            index += span;
+        }
+    }
+    return NULL;
+}
+
+/* Data of a string or blob chunk entry, checked against its data CRC */
+static inline bool app_factory_nvs_entry_data(const uint8_t *entry, app_factory_nvs_crc32_t crc32,
+                                              app_factory_nvs_item_t *item)
+{
+    size_t size = entry[24] | (entry[25] << 8);
+    if (entry[2] < 2 || size > (size_t)(entry[2] - 1) * APP_FACTORY_NVS_ENTRY_SIZE) {
+        return false;
+    }
+    const uint8_t *data = entry + APP_FACTORY_NVS_ENTRY_SIZE;
+    if (crc32(0xFFFFFFFF, data, size) != app_factory_nvs_le32(entry + 28)) {
+        return false;
+    }
+    item->data = data;
+    item->size = size;
+    return true;
+}
+
+/** Find an item of the image
+ *
+ * Blobs are only found if they are stored in a single chunk, so they are contiguous in the image. nvs_flash
+ * only splits blobs that do not fit the rest of a page, which the factory partitions of tools/mfg never need.
+ *
+ * @param[in] image NVS partition image, a whole number of pages.
+ * @param[in] size Size of the image.
+ * @param[in] ns Namespace name.
+ * @param[in] key Key of the item.
+ * @param[in] type APP_FACTORY_NVS_TYPE_U8/U16/U32, APP_FACTORY_NVS_TYPE_STR or APP_FACTORY_NVS_TYPE_BLOB.
+ * @param[in] crc32 CRC32 function.
+ * @param[out] item Value or data of the item.
+ *
+ * @return true if the item was found.
+ */
+static inline bool app_factory_nvs_find(const uint8_t *image, size_t size, const char *ns, const char *key,
+                                        uint8_t type, app_factory_nvs_crc32_t crc32, app_factory_nvs_item_t *item)
+{
+    const uint8_t *entry = app_factory_nvs_find_entry(image, size, 0, APP_FACTORY_NVS_TYPE_U8, 0xFF, ns, crc32);
+    if (!entry) {
+        return false;
+    }
+    uint8_t ns_index = entry[24];
+
+    item->value = 0;
+    item->data = NULL;
+    item->size = 0;
+    if (type == APP_FACTORY_NVS_TYPE_STR) {
+        entry = app_factory_nvs_find_entry(image, size, ns_index, type, 0xFF, key, crc32);
+        if (!entry || !app_factory_nvs_entry_data(entry, crc32, item) || item->size == 0) {
+            return false;
+        }
+        item->size--;
+        return true;
+    }
+    if (type == APP_FACTORY_NVS_TYPE_BLOB) {
+        entry = app_factory_nvs_find_entry(image, size, ns_index, APP_FACTORY_NVS_TYPE_BLOB_IDX, 0xFF, key, crc32);
+        if (!entry || entry[28] != 1) { // Chunk count
+            return false;
+        }
+        uint32_t blob_size = app_factory_nvs_le32(entry + 24);
+        entry = app_factory_nvs_find_entry(image, size, ns_index, type, entry[29], key, crc32);
+        return entry && app_factory_nvs_entry_data(entry, crc32, item) && item->size == blob_size;
+    }
+    entry = app_factory_nvs_find_entry(image, size, ns_index, type, 0xFF, key, crc32);
+    if (!entry) {
+        return false;
+    }
+    uint32_t value = app_factory_nvs_le32(entry + 24);
+    item->value = type == APP_FACTORY_NVS_TYPE_U8    ? value & 0xFF
+                  : type == APP_FACTORY_NVS_TYPE_U16 ? value & 0xFFFF
+                                                     : value;
+    return true;
+}
@@ -0,0 +1,117 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_matter.h>
+
+#include <app_fan_auto.h>
+
+#if CONFIG_FAN_AUTO_LOCAL_SENSOR
+#include <esp_timer.h>
+#include <platform/CHIPDeviceLayer.h>
+#include "driver/temperature_sensor.h"
+
+using namespace chip::app::Clusters;
+using namespace esp_matter;
+#endif
+
+static const char *TAG = "app_fan_auto";
+
+bool app_fan_auto_update(const app_fan_auto_config_t *config, app_fan_auto_state_t *state, int16_t temperature)
+{
+    if (state->valid) {
+        int32_t delta = (int32_t)temperature - state->temperature;
+        if (delta <= config->hysteresis && delta >= -config->hysteresis) {
+            return false;
+        }
+    }
+
+    uint8_t percent;
+    if (temperature <= config->temp_min) {
+        percent = config->percent_min;
+    } else if (temperature >= config->temp_max) {
+        percent = config->percent_max;
+    } else {
+        int32_t span = config->percent_max - config->percent_min;
+        percent = config->percent_min +
+                  (span * (temperature - config->temp_min)) / (config->temp_max - config->temp_min);
+    }
+
+    bool changed = !state->valid || percent != state->percent;
+    state->temperature = temperature;
+    state->percent = percent;
+    state->valid = true;
+    return changed;
+}
+
+#if CONFIG_FAN_AUTO_LOCAL_SENSOR
+
+static temperature_sensor_handle_t s_sensor;
+static esp_timer_handle_t s_sample_timer;
+static uint16_t s_endpoint_id;
+static int16_t s_sample;
+
+/* Runs on the CHIP thread, the update callback of MeasuredValue drives the Auto mode controller */
+static void publish_sample(intptr_t arg)
+{
+    esp_matter_attr_val_t val = esp_matter_nullable_int16(s_sample);
+    attribute::update(s_endpoint_id, TemperatureMeasurement::Id, TemperatureMeasurement::Attributes::MeasuredValue::Id,
+                      &val);
+}
+
+static void sample_timer_cb(void *arg)
+{
+    float celsius = 0;
+    if (temperature_sensor_get_celsius(s_sensor, &celsius) != ESP_OK) {
+        return;
+    }
+    int16_t sample = (int16_t)(celsius * 100);
+    /* Only changed samples are handed to the CHIP thread */
+    if (sample != s_sample) {
+        s_sample = sample;
+        chip::DeviceLayer::PlatformMgr().ScheduleWork(publish_sample, 0);
+    }
+}
+
+esp_err_t app_fan_auto_sensor_init(uint16_t endpoint_id)
+{
+    temperature_sensor_config_t sensor_config = TEMPERATURE_SENSOR_CONFIG_DEFAULT(-10, 80);
+    esp_err_t err = temperature_sensor_install(&sensor_config, &s_sensor);
+    if (err == ESP_OK) {
+        err = temperature_sensor_enable(s_sensor);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to enable temperature sensor: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    s_endpoint_id = endpoint_id;
+    s_sample = INT16_MIN;
+    esp_timer_create_args_t timer_args = {
+        .callback = sample_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "fan_auto_sensor",
+        .skip_unhandled_events = true,
+    };
+    err = esp_timer_create(&timer_args, &s_sample_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return esp_timer_start_periodic(s_sample_timer, CONFIG_FAN_AUTO_SAMPLE_INTERVAL_MS * 1000);
+}
+
+#else
+
+esp_err_t app_fan_auto_sensor_init(uint16_t endpoint_id)
+{
+    ESP_LOGW(TAG, "No local temperature sensor configured");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_FAN_AUTO_LOCAL_SENSOR
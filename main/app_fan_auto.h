@@ -0,0 +1,52 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_err.h>
+
+typedef struct {
+    int16_t temp_min;       /* 0.01 °C, PercentSetting is percent_min at and below */
+    int16_t temp_max;       /* 0.01 °C, PercentSetting is percent_max at and above */
+    int16_t hysteresis;     /* 0.01 °C, smaller changes of the input are ignored */
+    uint8_t percent_min;
+    uint8_t percent_max;
+} app_fan_auto_config_t;
+
+typedef struct {
+    int16_t temperature;    /* input the current percent was computed from */
+    uint8_t percent;
+    bool valid;
+} app_fan_auto_state_t;
+
+/** Feed a new temperature into the Auto mode controller
+ *
+ * The fan percent is recomputed only if the temperature moved by more than the hysteresis band since
+ * the last recomputation, so a noisy sensor does not re-program the PWM or trigger reports.
+ *
+ * @param[in] config Controller configuration.
+ * @param[inout] state Controller state.
+ * @param[in] temperature Temperature in 0.01 °C, as in TemperatureMeasurement::MeasuredValue.
+ *
+ * @return true if `state->percent` changed.
+ */
+bool app_fan_auto_update(const app_fan_auto_config_t *config, app_fan_auto_state_t *state, int16_t temperature);
+
+/** Start sampling the on-chip temperature sensor
+ *
+ * The samples are published as MeasuredValue of the TemperatureMeasurement cluster on the given
+ * endpoint, the attribute update callback feeds them into the Auto mode controller.
+ *
+ * @param[in] endpoint_id Endpoint with the TemperatureMeasurement cluster.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_fan_auto_sensor_init(uint16_t endpoint_id);
@@ -0,0 +1,172 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+#include <esp_log.h>
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "freertos/FreeRTOS.h"
+
+#define FAN_BANK_SPEED_MODE     LEDC_LOW_SPEED_MODE
+#define FAN_BANK_TIMER          LEDC_TIMER_0
+#define FAN_BANK_FREQUENCY      (25000) // 25 kHz is above the audible range and the 4-pin fan PWM standard
+#define FAN_BANK_DUTY_RES       LEDC_TIMER_11_BIT // 80 MHz / 25 kHz leaves 11 bits of resolution
+#define FAN_BANK_DUTY_MAX       (1 << 11)
+
+/** PWM bank driving N fans
+ *
+ * All channels share one LEDC timer, so every fan runs at the same frequency and phase. New duties are
+ * staged per channel and applied together by `commit()`: immediate changes are latched by the hardware at
+ * the same PWM period boundary, slewed changes are handed to the LEDC fade unit.
+ */
+template <size_t N>
+class fan_bank {
+public:
+    static_assert(N > 0 && N <= LEDC_CHANNEL_MAX, "Fan count exceeds the LEDC channels of this target");
+
+    static constexpr size_t channel_count = N;
+
+    static constexpr uint32_t percent_to_duty(uint8_t percent)
+    {
+        return ((uint32_t)(percent > 100 ? 100 : percent) * (FAN_BANK_DUTY_MAX - 1)) / 100;
+    }
+
+    esp_err_t init(const gpio_num_t (&gpios)[N], uint32_t slew_percent_per_sec)
+    {
+        ledc_timer_config_t ledc_timer = {
+            .speed_mode = FAN_BANK_SPEED_MODE,
+            .duty_resolution = FAN_BANK_DUTY_RES,
+            .timer_num = FAN_BANK_TIMER,
+            .freq_hz = FAN_BANK_FREQUENCY,
+            .clk_cfg = LEDC_AUTO_CLK
+        };
+        esp_err_t err = ledc_timer_config(&ledc_timer);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to configure timer: %s", esp_err_to_name(err));
+            return err;
+        }
+
+        for (size_t i = 0; i < N; i++) {
+            ledc_channel_config_t ledc_channel = {
+                .gpio_num = gpios[i],
+                .speed_mode = FAN_BANK_SPEED_MODE,
+                .channel = channel(i),
+                .intr_type = LEDC_INTR_DISABLE,
+                .timer_sel = FAN_BANK_TIMER,
+                .duty = 0,
+                .hpoint = 0
+            };
+            err = ledc_channel_config(&ledc_channel);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to configure channel %d: %s", (int)i, esp_err_to_name(err));
+                return err;
+            }
+            m_slew_percent_per_sec[i] = slew_percent_per_sec;
+        }
+        return ledc_fade_func_install(0);
+    }
+
+    void set_slew_rate(size_t index, uint32_t percent_per_sec)
+    {
+        m_slew_percent_per_sec[index] = percent_per_sec;
+    }
+
+    /* Stage a new target duty, it is applied by the next commit(). An immediate change skips the slew rate. */
+    void stage(size_t index, uint32_t duty, bool immediate = false)
+    {
+        if (duty >= FAN_BANK_DUTY_MAX) {
+            duty = FAN_BANK_DUTY_MAX - 1;
+        }
+        if (duty != m_target[index]) {
+            m_target[index] = duty;
+            m_dirty |= (1u << index);
+            if (immediate) {
+                m_immediate |= (1u << index);
+            }
+        }
+    }
+
+    uint32_t target(size_t index) const { return m_target[index]; }
+
+    /* Duty currently output by the hardware, this differs from target() while a ramp is running */
+    uint32_t duty(size_t index) const { return ledc_get_duty(FAN_BANK_SPEED_MODE, channel(index)); }
+
+    esp_err_t commit()
+    {
+        uint32_t dirty = m_dirty;
+        uint32_t skip_slew = m_immediate;
+        uint32_t immediate = 0;
+        m_dirty = 0;
+        m_immediate = 0;
+
+        for (size_t i = 0; i < N; i++) {
+            if (!(dirty & (1u << i))) {
+                continue;
+            }
+            /* A fade that is still running is stopped where it is and retargeted from there. Starting a new
+               fade on top of it would block until the running one has finished. */
+            esp_err_t err = ledc_fade_stop(FAN_BANK_SPEED_MODE, channel(i));
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to stop fade: %s (channel: %d)", esp_err_to_name(err), (int)i);
+                return err;
+            }
+
+            uint32_t fade_ms = (skip_slew & (1u << i)) ? 0 : fade_time_ms(i, duty(i), m_target[i]);
+            if (fade_ms == 0) {
+                ledc_set_duty(FAN_BANK_SPEED_MODE, channel(i), m_target[i]);
+                immediate |= (1u << i);
+                continue;
+            }
+            /* Let the LEDC fade unit ramp the duty, the CPU is not involved until the fade has finished */
+            err = ledc_set_fade_with_time(FAN_BANK_SPEED_MODE, channel(i), m_target[i], fade_ms);
+            if (err == ESP_OK) {
+                err = ledc_fade_start(FAN_BANK_SPEED_MODE, channel(i), LEDC_FADE_NO_WAIT);
+            }
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to start fade: %s (channel: %d)", esp_err_to_name(err), (int)i);
+                return err;
+            }
+        }
+
+        /* The duty registers are latched at the next overflow of the shared timer. Updating all channels
+           back to back without being preempted makes them switch in the same PWM period. */
+        if (immediate) {
+            portENTER_CRITICAL(&m_commit_lock);
+            for (size_t i = 0; i < N; i++) {
+                if (immediate & (1u << i)) {
+                    ledc_update_duty(FAN_BANK_SPEED_MODE, channel(i));
+                }
+            }
+            portEXIT_CRITICAL(&m_commit_lock);
+        }
+        return ESP_OK;
+    }
+
+private:
+    static constexpr const char *TAG = "fan_bank";
+
+    static constexpr ledc_channel_t channel(size_t index) { return (ledc_channel_t)(LEDC_CHANNEL_0 + index); }
+
+    uint32_t fade_time_ms(size_t index, uint32_t from, uint32_t to) const
+    {
+        uint32_t delta = to > from ? to - from : from - to;
+        uint32_t duty_per_sec = (m_slew_percent_per_sec[index] * (FAN_BANK_DUTY_MAX - 1)) / 100;
+        return duty_per_sec > 0 ? (delta * 1000) / duty_per_sec : 0;
+    }
+
+    uint32_t m_target[N] = {};
+    uint32_t m_slew_percent_per_sec[N] = {};
+    uint32_t m_dirty = 0;
+    uint32_t m_immediate = 0;
+    portMUX_TYPE m_commit_lock = portMUX_INITIALIZER_UNLOCKED;
+};
@@ -0,0 +1,198 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <app_fan_curve.h>
+
+#define SWEEP_STOP_WINDOWS_MAX  30  // A fan still turning after this many windows at duty 0 never stalls
+
+void app_fan_curve_linear(uint16_t duty_max, app_fan_curve_t *curve)
+{
+    curve->duty_max = duty_max;
+    curve->start_duty = 0;
+    curve->span = {};
+    for (uint32_t percent = 0; percent < APP_FAN_CURVE_POINTS; percent++) {
+        curve->duty[percent] = (uint16_t)((percent * duty_max) / 100);
+    }
+}
+
+uint32_t app_fan_curve_percent_to_rpm(app_fan_curve_span_t span, uint8_t percent, uint32_t max_rpm)
+{
+    if (span.rpm_max <= span.rpm_min) {
+        return ((uint32_t)percent * max_rpm) / 100;
+    }
+    if (percent == 0) {
+        return 0;
+    }
+    uint32_t rise = span.rpm_max - span.rpm_min;
+    return span.rpm_min + ((uint32_t)(percent - 1) * rise + 49) / 99;
+}
+
+uint8_t app_fan_curve_rpm_to_percent(app_fan_curve_span_t span, uint32_t rpm, uint32_t max_rpm)
+{
+    uint32_t percent;
+    if (span.rpm_max <= span.rpm_min) {
+        percent = max_rpm ? (rpm * 100) / max_rpm : 0;
+    } else if (rpm == 0) {
+        percent = 0;
+    } else if (rpm <= span.rpm_min) {
+        percent = 1;
+    } else {
+        uint32_t rise = span.rpm_max - span.rpm_min;
+        percent = 1 + ((rpm - span.rpm_min) * 99 + rise / 2) / rise;
+    }
+    return percent > 100 ? 100 : (uint8_t)percent;
+}
+
+static uint16_t set_duty(app_fan_sweep_t *sweep, uint16_t duty)
+{
+    sweep->duty = duty;
+    sweep->windows = 0;
+    return duty;
+}
+
+static bool settled(app_fan_sweep_t *sweep, uint32_t rpm)
+{
+    uint32_t delta = rpm > sweep->prev_rpm ? rpm - sweep->prev_rpm : sweep->prev_rpm - rpm;
+    sweep->prev_rpm = rpm;
+    sweep->windows++;
+    if (sweep->windows < sweep->settle_windows) {
+        return false;
+    }
+    return delta <= rpm / 32 || sweep->windows >= 4 * sweep->settle_windows;
+}
+
+uint16_t app_fan_sweep_begin(app_fan_sweep_t *sweep, uint16_t duty_max, uint8_t settle_windows)
+{
+    sweep->phase = APP_FAN_SWEEP_RUN_DOWN;
+    sweep->settle_windows = settle_windows > 0 ? settle_windows : 1;
+    sweep->duty_max = duty_max;
+    sweep->prev_rpm = 0;
+    sweep->start_duty = 0;
+    sweep->count = 0;
+    return set_duty(sweep, duty_max);
+}
+
+uint16_t app_fan_sweep_step(app_fan_sweep_t *sweep, uint32_t rpm)
+{
+    switch (sweep->phase) {
+    case APP_FAN_SWEEP_RUN_DOWN: {
+        if (!settled(sweep, rpm)) {
+            break;
+        }
+        if (rpm > 0 && sweep->count < APP_FAN_SWEEP_MAX_SAMPLES) {
+            sweep->samples[sweep->count].duty = sweep->duty;
+            sweep->samples[sweep->count].rpm = rpm > UINT16_MAX ? UINT16_MAX : (uint16_t)rpm;
+            sweep->count++;
+        }
+        uint16_t step = sweep->duty_max / APP_FAN_SWEEP_DOWN_STEPS;
+        if (rpm == 0 || sweep->duty == 0) {
+            sweep->phase = APP_FAN_SWEEP_STOP;
+            return set_duty(sweep, 0);
+        }
+        return set_duty(sweep, sweep->duty > step ? sweep->duty - step : 0);
+    }
+
+    case APP_FAN_SWEEP_STOP: {
+        sweep->windows++;
+        if (sweep->count < 2) {
+            sweep->phase = APP_FAN_SWEEP_FAILED;
+            break;
+        }
+        if (rpm > 0) {
+            if (sweep->windows >= SWEEP_STOP_WINDOWS_MAX) {
+                sweep->start_duty = 0;
+                sweep->phase = APP_FAN_SWEEP_DONE;
+            }
+            break;
+        }
+        /* The fan stalled one run-down step below the lowest running sample, it cannot start lower than that */
+        uint16_t fine = sweep->duty_max / APP_FAN_SWEEP_START_STEPS;
+        uint16_t lowest = sweep->samples[sweep->count - 1].duty;
+        uint16_t step = sweep->duty_max / APP_FAN_SWEEP_DOWN_STEPS;
+        sweep->phase = APP_FAN_SWEEP_START;
+        sweep->prev_rpm = 0;
+        return set_duty(sweep, lowest > step ? lowest - step + fine : fine);
+    }
+
+    case APP_FAN_SWEEP_START:
+        /* Any speed counts, a fan that starts slowly is not settled yet but has started */
+        if (rpm > 0) {
+            sweep->start_duty = sweep->duty;
+            sweep->phase = APP_FAN_SWEEP_DONE;
+            break;
+        }
+        if (!settled(sweep, rpm)) {
+            break;
+        }
+        if (sweep->duty >= sweep->duty_max) {
+            sweep->phase = APP_FAN_SWEEP_FAILED;
+            break;
+        }
+        {
+            uint32_t next = sweep->duty + sweep->duty_max / APP_FAN_SWEEP_START_STEPS;
+            return set_duty(sweep, next > sweep->duty_max ? sweep->duty_max : (uint16_t)next);
+        }
+
+    default:
+        break;
+    }
+    return sweep->duty;
+}
+
+bool app_fan_curve_fit(const app_fan_curve_sample_t *samples, size_t count, uint16_t duty_max, uint16_t start_duty,
+                       app_fan_curve_t *curve)
+{
+    /* Running samples in ascending duty */
+    app_fan_curve_sample_t points[APP_FAN_SWEEP_MAX_SAMPLES];
+    size_t n = 0;
+    for (size_t i = 0; i < count && n < APP_FAN_SWEEP_MAX_SAMPLES; i++) {
+        if (samples[i].rpm == 0 || samples[i].duty > duty_max) {
+            continue;
+        }
+        size_t j = n++;
+        while (j > 0 && points[j - 1].duty > samples[i].duty) {
+            points[j] = points[j - 1];
+            j--;
+        }
+        points[j] = samples[i];
+    }
+    if (n < 2) {
+        return false;
+    }
+    /* Measurement noise must not make a higher duty map to a lower speed */
+    for (size_t i = 1; i < n; i++) {
+        if (points[i].rpm < points[i - 1].rpm) {
+            points[i].rpm = points[i - 1].rpm;
+        }
+    }
+    app_fan_curve_span_t span = { points[0].rpm, points[n - 1].rpm };
+    if (span.rpm_max <= span.rpm_min) {
+        return false;
+    }
+
+    curve->duty_max = duty_max;
+    curve->start_duty = start_duty;
+    curve->span = span;
+    curve->duty[0] = 0;
+    size_t segment = 0;
+    for (uint8_t percent = 1; percent < APP_FAN_CURVE_POINTS; percent++) {
+        uint32_t target = app_fan_curve_percent_to_rpm(span, percent, 0);
+        while (segment + 2 < n && points[segment + 1].rpm < target) {
+            segment++;
+        }
+        const app_fan_curve_sample_t &a = points[segment];
+        const app_fan_curve_sample_t &b = points[segment + 1];
+        uint32_t duty = a.duty;
+        if (b.rpm > a.rpm && target > a.rpm) {
+            uint32_t rise = b.rpm - a.rpm;
+            duty += ((target - a.rpm) * (uint32_t)(b.duty - a.duty) + rise / 2) / rise;
+        }
+        curve->duty[percent] = (uint16_t)(duty > duty_max ? duty_max : duty);
+    }
+    return true;
+}
@@ -0,0 +1,119 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define APP_FAN_CURVE_POINTS        101 // 0 to 100 percent
+#define APP_FAN_SWEEP_DOWN_STEPS    32  // The run-down sweep samples every 1/32 of the duty range
+#define APP_FAN_SWEEP_START_STEPS   100 // The start probe raises the duty by 1/100 of the range
+#define APP_FAN_SWEEP_MAX_SAMPLES   (APP_FAN_SWEEP_DOWN_STEPS + 1)
+
+/* Measured speeds percent 1 and 100 stand for */
+typedef struct {
+    uint16_t rpm_min;       /* 0 for an uncalibrated fan */
+    uint16_t rpm_max;
+} app_fan_curve_span_t;
+
+/* Duty of every percent step of a fan. Percent 1 is the lowest speed the fan keeps running at and 100 its full
+   speed, the steps in between are evenly spaced in RPM. */
+typedef struct {
+    uint16_t duty_max;      /* duty of full output the table was made for */
+    uint16_t start_duty;    /* lowest duty that starts the fan from standstill, 0 if it needs no kick */
+    app_fan_curve_span_t span;
+    uint16_t duty[APP_FAN_CURVE_POINTS];
+} app_fan_curve_t;
+
+typedef struct {
+    uint16_t duty;
+    uint16_t rpm;
+} app_fan_curve_sample_t;
+
+typedef enum {
+    APP_FAN_SWEEP_RUN_DOWN,     /* stepping down from full duty and recording the speed of every step */
+    APP_FAN_SWEEP_STOP,         /* waiting for the fan to stop at duty 0 */
+    APP_FAN_SWEEP_START,        /* raising the duty from standstill until the fan starts */
+    APP_FAN_SWEEP_DONE,
+    APP_FAN_SWEEP_FAILED,
+} app_fan_sweep_phase_t;
+
+typedef struct {
+    uint8_t phase;
+    uint8_t settle_windows;     /* minimum measurement windows per step */
+    uint16_t windows;           /* windows since the last duty change */
+    uint16_t duty_max;
+    uint16_t duty;
+    uint32_t prev_rpm;
+    uint16_t start_duty;
+    uint16_t count;
+    app_fan_curve_sample_t samples[APP_FAN_SWEEP_MAX_SAMPLES];  /* in descending duty */
+} app_fan_sweep_t;
+
+/** Fill a curve with the linear mapping of an uncalibrated fan */
+void app_fan_curve_linear(uint16_t duty_max, app_fan_curve_t *curve);
+
+/** Speed a percent step stands for
+ *
+ * @param[in] span Span of the fan's curve.
+ * @param[in] percent Percent step.
+ * @param[in] max_rpm Full speed assumed for an uncalibrated fan, which is linear in the percent.
+ *
+ * @return speed in RPM, evenly spaced between the measured speeds of a calibrated curve.
+ */
+uint32_t app_fan_curve_percent_to_rpm(app_fan_curve_span_t span, uint8_t percent, uint32_t max_rpm);
+
+/** Percent step of a measured speed, the inverse of `app_fan_curve_percent_to_rpm()` rounded to the nearest step
+ *
+ * A calibrated fan that turns slower than its 1 % speed, e.g. while it spins down, is at 1 %.
+ */
+uint8_t app_fan_curve_rpm_to_percent(app_fan_curve_span_t span, uint32_t rpm, uint32_t max_rpm);
+
+/** Start a calibration sweep
+ *
+ * @param[out] sweep Sweep state of the fan.
+ * @param[in] duty_max Duty of full output.
+ * @param[in] settle_windows Minimum tach windows the fan gets to settle after every duty change.
+ *
+ * @return duty to output until the next measurement window.
+ */
+uint16_t app_fan_sweep_begin(app_fan_sweep_t *sweep, uint16_t duty_max, uint8_t settle_windows);
+
+/** Advance a calibration sweep by one measurement window
+ *
+ * The sweep steps the duty down from full output and records the settled speed of every step until the fan
+ * stalls. It then waits for the fan to stop and raises the duty from standstill until it starts again, which
+ * gives the start duty. A step counts as settled once `settle_windows` have passed and the speed changed by
+ * less than 1/32 between two windows, or after four times `settle_windows`. A fan that keeps running at duty 0
+ * needs no kick and gets a start duty of 0.
+ *
+ * @param[inout] sweep Sweep state of the fan.
+ * @param[in] rpm Speed measured in the last window.
+ *
+ * @return duty to output until the next measurement window.
+ */
+uint16_t app_fan_sweep_step(app_fan_sweep_t *sweep, uint32_t rpm);
+
+/** Build the percent to duty table from a sweep
+ *
+ * Samples without speed are ignored and the speeds are made monotonic in the duty. The slowest and fastest
+ * speed become the span of the curve, the duty of every percent step is interpolated linearly between the two
+ * samples around the speed `app_fan_curve_percent_to_rpm()` gives for it.
+ *
+ * @param[in] samples Recorded samples in any order.
+ * @param[in] count Number of samples, at most `APP_FAN_SWEEP_MAX_SAMPLES` are used.
+ * @param[in] duty_max Duty of full output.
+ * @param[in] start_duty Lowest duty that starts the fan from standstill.
+ * @param[out] curve Curve of the fan.
+ *
+ * @return true on success.
+ * @return false if the samples have fewer than two running speeds or the speed does not rise with the duty.
+ */
+bool app_fan_curve_fit(const app_fan_curve_sample_t *samples, size_t count, uint16_t duty_max, uint16_t start_duty,
+                       app_fan_curve_t *curve);
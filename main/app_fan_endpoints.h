@@ -0,0 +1,75 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "app_fan_mode.h"
+
+#if CONFIG_FAN_TACH_SOURCE_PCNT
+#define APP_FAN_TACH_GPIO(n) ((gpio_num_t)CONFIG_FAN##n##_TACH_GPIO)
+#else
+#define APP_FAN_TACH_GPIO(n) GPIO_NUM_NC
+#endif
+
+/* One fan endpoint: the PWM output and bank channel driving it and the FanModeSequence it announces */
+typedef struct {
+    uint8_t channel;            /* channel in the fan bank */
+    gpio_num_t gpio;
+    gpio_num_t tach_gpio;       /* GPIO_NUM_NC unless the PCNT tach source is selected */
+    uint8_t fan_mode_sequence;
+} app_fan_endpoint_config_t;
+
+/* Fan endpoints of the node in creation order. app_main() creates one FanControl endpoint per entry and the
+   driver dispatches attribute updates to the entry's channel through a table indexed by endpoint ID. */
+static constexpr app_fan_endpoint_config_t k_fan_endpoints[] = {
+    { 0, (gpio_num_t)CONFIG_EXAMPLE_FAN_GPIO, APP_FAN_TACH_GPIO(1), FAN_MODE_SEQUEBCE_VALUE },
+#if CONFIG_FAN_COUNT >= 2
+    { 1, (gpio_num_t)CONFIG_EXAMPLE_FAN2_GPIO, APP_FAN_TACH_GPIO(2), FAN_MODE_SEQUEBCE_VALUE },
+#endif
+#if CONFIG_FAN_COUNT >= 3
+    { 2, (gpio_num_t)CONFIG_EXAMPLE_FAN3_GPIO, APP_FAN_TACH_GPIO(3), FAN_MODE_SEQUEBCE_VALUE },
+#endif
+#if CONFIG_FAN_COUNT >= 4
+    { 3, (gpio_num_t)CONFIG_EXAMPLE_FAN4_GPIO, APP_FAN_TACH_GPIO(4), FAN_MODE_SEQUEBCE_VALUE },
+#endif
+#if CONFIG_FAN_COUNT >= 5
+    { 4, (gpio_num_t)CONFIG_EXAMPLE_FAN5_GPIO, APP_FAN_TACH_GPIO(5), FAN_MODE_SEQUEBCE_VALUE },
+#endif
+#if CONFIG_FAN_COUNT >= 6
+    { 5, (gpio_num_t)CONFIG_EXAMPLE_FAN6_GPIO, APP_FAN_TACH_GPIO(6), FAN_MODE_SEQUEBCE_VALUE },
+#endif
+#if CONFIG_FAN_COUNT >= 7
+    { 6, (gpio_num_t)CONFIG_EXAMPLE_FAN7_GPIO, APP_FAN_TACH_GPIO(7), FAN_MODE_SEQUEBCE_VALUE },
+#endif
+#if CONFIG_FAN_COUNT >= 8
+    { 7, (gpio_num_t)CONFIG_EXAMPLE_FAN8_GPIO, APP_FAN_TACH_GPIO(8), FAN_MODE_SEQUEBCE_VALUE },
+#endif
+};
+
+constexpr size_t k_fan_endpoint_count = sizeof(k_fan_endpoints) / sizeof(k_fan_endpoints[0]);
+
+static constexpr bool fan_endpoints_valid()
+{
+    uint32_t channels = 0;
+    for (size_t i = 0; i < k_fan_endpoint_count; i++) {
+        const app_fan_endpoint_config_t &fan = k_fan_endpoints[i];
+        if (fan.channel >= k_fan_endpoint_count || (channels & (1u << fan.channel)) ||
+            fan.fan_mode_sequence > APP_FAN_MODE_SEQUENCE_OFF_HIGH) {
+            return false;
+        }
+        channels |= 1u << fan.channel;
+    }
+    return true;
+}
+
+static_assert(k_fan_endpoint_count == CONFIG_FAN_COUNT, "One fan endpoint entry per fan");
+static_assert(fan_endpoints_valid(), "Every fan endpoint needs its own bank channel and a valid FanModeSequence");
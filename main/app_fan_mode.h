@@ -0,0 +1,188 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+/* FanMode <-> PercentSetting logic of the FanControl cluster. This header only depends on the C library, so the
+   mapping can be compiled and exercised outside of ESP-IDF. */
+
+#define FAN_MODE_SEQUEBCE_VALUE 2
+#define LOW_MODE_PERCENT_MIN 1
+#define LOW_MODE_PERCENT_MAX 33
+#define MED_MODE_PERCENT_MIN 34
+#define MED_MODE_PERCENT_MAX 66
+#define HIGH_MODE_PERCENT_MIN 67
+#define HIGH_MODE_PERCENT_MAX 100
+
+/* Values of FanControl::FanModeEnum */
+#define APP_FAN_MODE_OFF        0
+#define APP_FAN_MODE_LOW        1
+#define APP_FAN_MODE_MEDIUM     2
+#define APP_FAN_MODE_HIGH       3
+#define APP_FAN_MODE_ON         4
+#define APP_FAN_MODE_AUTO       5
+#define APP_FAN_MODE_SMART      6
+
+/* Values of FanControl::FanModeSequenceEnum */
+#define APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH          0
+#define APP_FAN_MODE_SEQUENCE_OFF_LOW_HIGH              1
+#define APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH_AUTO     2
+#define APP_FAN_MODE_SEQUENCE_OFF_LOW_HIGH_AUTO         3
+#define APP_FAN_MODE_SEQUENCE_OFF_HIGH_AUTO             4
+#define APP_FAN_MODE_SEQUENCE_OFF_HIGH                  5
+
+typedef struct {
+    uint8_t percent_min;
+    uint8_t percent_max;
+    bool adjusts_percent;   /* false for modes like Auto that leave PercentSetting untouched */
+    uint8_t mode;           /* mode a write of this mode is reconciled to, itself if it is part of the sequence */
+} fan_mode_range_t;
+
+constexpr uint8_t k_fan_mode_count = APP_FAN_MODE_SMART + 1;
+constexpr uint8_t k_percent_count = 101;
+
+typedef struct {
+    fan_mode_range_t range[k_fan_mode_count];
+    uint8_t percent_to_mode[k_percent_count];
+} fan_mode_table_t;
+
+static constexpr bool sequence_has_low(uint8_t sequence)
+{
+    return sequence != APP_FAN_MODE_SEQUENCE_OFF_HIGH_AUTO && sequence != APP_FAN_MODE_SEQUENCE_OFF_HIGH;
+}
+
+static constexpr bool sequence_has_medium(uint8_t sequence)
+{
+    return sequence == APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH ||
+           sequence == APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH_AUTO;
+}
+
+static constexpr bool sequence_has_auto(uint8_t sequence)
+{
+    return sequence == APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH_AUTO ||
+           sequence == APP_FAN_MODE_SEQUENCE_OFF_LOW_HIGH_AUTO || sequence == APP_FAN_MODE_SEQUENCE_OFF_HIGH_AUTO;
+}
+
+/* Build the FanMode <-> PercentSetting mapping for a FanModeSequence. Bands of modes which are not part of the
+   sequence are folded into the next higher mode, so every percent value maps to exactly one supported mode. A write
+   of an unsupported mode gets the band of that higher mode and is reconciled to it. Smart is never announced and
+   becomes Auto, both become High in a sequence without Auto. */
+static constexpr fan_mode_table_t make_fan_mode_table(uint8_t sequence)
+{
+    fan_mode_table_t table = {};
+    bool has_low = sequence_has_low(sequence);
+    bool has_medium = sequence_has_medium(sequence);
+
+    uint8_t high_min = has_medium ? HIGH_MODE_PERCENT_MIN : (has_low ? MED_MODE_PERCENT_MIN : LOW_MODE_PERCENT_MIN);
+    uint8_t medium_min = has_low ? MED_MODE_PERCENT_MIN : LOW_MODE_PERCENT_MIN;
+
+    table.range[APP_FAN_MODE_OFF] = { 0, 0, true, APP_FAN_MODE_OFF };
+    table.range[APP_FAN_MODE_HIGH] = { high_min, HIGH_MODE_PERCENT_MAX, true, APP_FAN_MODE_HIGH };
+    table.range[APP_FAN_MODE_MEDIUM] = has_medium ? fan_mode_range_t{ MED_MODE_PERCENT_MIN, MED_MODE_PERCENT_MAX, true,
+                                                                      APP_FAN_MODE_MEDIUM }
+                                                  : table.range[APP_FAN_MODE_HIGH];
+    table.range[APP_FAN_MODE_LOW] = has_low ? fan_mode_range_t{ LOW_MODE_PERCENT_MIN, LOW_MODE_PERCENT_MAX, true,
+                                                                APP_FAN_MODE_LOW }
+                                            : table.range[APP_FAN_MODE_MEDIUM];
+    /* On is equivalent to High */
+    table.range[APP_FAN_MODE_ON] = table.range[APP_FAN_MODE_HIGH];
+    table.range[APP_FAN_MODE_AUTO] = sequence_has_auto(sequence) ? fan_mode_range_t{ 1, 0, false, APP_FAN_MODE_AUTO }
+                                                                 : table.range[APP_FAN_MODE_HIGH];
+    table.range[APP_FAN_MODE_SMART] = table.range[APP_FAN_MODE_AUTO];
+
+    for (uint8_t percent = 0; percent < k_percent_count; percent++) {
+        if (percent == 0) {
+            table.percent_to_mode[percent] = APP_FAN_MODE_OFF;
+        } else if (percent >= high_min) {
+            table.percent_to_mode[percent] = APP_FAN_MODE_HIGH;
+        } else if (percent >= medium_min) {
+            table.percent_to_mode[percent] = APP_FAN_MODE_MEDIUM;
+        } else {
+            table.percent_to_mode[percent] = APP_FAN_MODE_LOW;
+        }
+    }
+    return table;
+}
+
+static_assert(LOW_MODE_PERCENT_MIN == 1 && LOW_MODE_PERCENT_MAX + 1 == MED_MODE_PERCENT_MIN &&
+              MED_MODE_PERCENT_MAX + 1 == HIGH_MODE_PERCENT_MIN && HIGH_MODE_PERCENT_MAX == 100,
+              "Fan mode percent bands must cover 1..100 without gaps");
+static_assert(make_fan_mode_table(FAN_MODE_SEQUEBCE_VALUE).percent_to_mode[0] == APP_FAN_MODE_OFF,
+              "0% must be Off");
+static_assert(make_fan_mode_table(FAN_MODE_SEQUEBCE_VALUE).percent_to_mode[100] == APP_FAN_MODE_HIGH,
+              "100% must be High");
+static_assert(make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_LOW_HIGH).range[APP_FAN_MODE_MEDIUM].mode ==
+                  APP_FAN_MODE_HIGH &&
+              make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_LOW_HIGH).range[APP_FAN_MODE_MEDIUM].percent_min ==
+                  MED_MODE_PERCENT_MIN,
+              "Medium must fold into High without a Medium mode");
+static_assert(make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_HIGH).range[APP_FAN_MODE_LOW].mode == APP_FAN_MODE_HIGH &&
+              make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_HIGH).range[APP_FAN_MODE_LOW].percent_min ==
+                  LOW_MODE_PERCENT_MIN,
+              "Low must fold into High without a Low mode");
+static_assert(make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH).range[APP_FAN_MODE_AUTO].mode ==
+                  APP_FAN_MODE_HIGH &&
+              make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH_AUTO).range[APP_FAN_MODE_SMART].mode ==
+                  APP_FAN_MODE_AUTO,
+              "Auto must fold into High without an Auto mode, Smart into Auto");
+
+static inline bool fan_mode_range_contains(const fan_mode_range_t &range, uint8_t percent)
+{
+    return percent >= range.percent_min && percent <= range.percent_max;
+}
+
+/* Result of reconciling a FanMode or PercentSetting write with the other attribute */
+typedef struct {
+    uint8_t fan_mode;
+    uint8_t percent;
+    bool fan_mode_changed;  /* FanMode differs from the written or stored value and has to be written back */
+    bool percent_changed;   /* PercentSetting differs from the stored value and has to be written back */
+} fan_mode_reconcile_t;
+
+/* A FanMode write. The percent setting must lie inside the band of the new mode, otherwise it is moved to the max
+   value of the band. A mode the sequence does not support is replaced by the mode whose band it was given. The mode
+   must be below k_fan_mode_count. */
+static inline fan_mode_reconcile_t fan_mode_reconcile_mode_write(const fan_mode_table_t &table, uint8_t fan_mode,
+                                                                 uint8_t percent)
+{
+    const fan_mode_range_t &range = table.range[fan_mode];
+    fan_mode_reconcile_t result = { range.mode, percent, range.mode != fan_mode, false };
+    if (range.adjusts_percent && !fan_mode_range_contains(range, percent)) {
+        result.percent = range.percent_max;
+        result.percent_changed = true;
+    }
+    return result;
+}
+
+/* A PercentSetting write. The FanMode is kept if the percent lies inside its band, otherwise it is moved to the mode
+   the percent maps to. */
+static inline fan_mode_reconcile_t fan_mode_reconcile_percent_write(const fan_mode_table_t &table, uint8_t fan_mode,
+                                                                    uint8_t percent)
+{
+    fan_mode_reconcile_t result = { fan_mode, percent > 100 ? (uint8_t)100 : percent, false, false };
+    if (fan_mode >= k_fan_mode_count || table.range[fan_mode].mode != fan_mode ||
+        !fan_mode_range_contains(table.range[fan_mode], result.percent)) {
+        result.fan_mode = table.percent_to_mode[result.percent];
+        result.fan_mode_changed = true;
+    }
+    return result;
+}
+
+/* SpeedSetting = ceil(SpeedMax * PercentSetting / 100) */
+static inline uint8_t app_fan_percent_to_speed(uint8_t percent, uint8_t speed_max)
+{
+    return (uint8_t)(((uint32_t)percent * speed_max + 99) / 100);
+}
+
+/* PercentSetting = floor(SpeedSetting / SpeedMax * 100) */
+static inline uint8_t app_fan_speed_to_percent(uint8_t speed, uint8_t speed_max)
+{
+    return (uint8_t)(((uint32_t)speed * 100) / speed_max);
+}
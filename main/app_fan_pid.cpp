@@ -0,0 +1,46 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <app_fan_pid.h>
+
+static int64_t clamp(int64_t value, int64_t min, int64_t max)
+{
+    return value < min ? min : (value > max ? max : value);
+}
+
+void app_fan_pid_reset(app_fan_pid_state_t *state, int32_t measurement)
+{
+    state->integral = 0;
+    state->prev_measurement = measurement;
+}
+
+/* The terms are computed in 64 bit: with the largest gains and a speed error of 20000 RPM, kp * error alone is
+   beyond the range of int32_t */
+int32_t app_fan_pid_step(const app_fan_pid_gains_t *gains, app_fan_pid_state_t *state, int32_t setpoint,
+                         int32_t measurement, int32_t feedforward)
+{
+    int64_t error = (int64_t)setpoint - measurement;
+    int64_t p = gains->kp * error;
+    int64_t d = gains->kd * ((int64_t)state->prev_measurement - measurement);
+    state->prev_measurement = measurement;
+
+    int64_t range = (int64_t)(gains->out_max - gains->out_min) << APP_FAN_PID_Q;
+    int64_t integral = clamp(state->integral + gains->ki * error, -range, range);
+
+    int64_t unclamped = feedforward + ((p + integral + d) >> APP_FAN_PID_Q);
+    int32_t output = (int32_t)clamp(unclamped, gains->out_min, gains->out_max);
+
+    /* Only keep the new integrator value if it does not drive an already saturated output further */
+    bool saturated_high = unclamped > gains->out_max && error > 0;
+    bool saturated_low = unclamped < gains->out_min && error < 0;
+    if (!saturated_high && !saturated_low) {
+        /* Clamped to the output range, which fits int32_t for any output range below 2^23 */
+        state->integral = (int32_t)integral;
+    }
+    return output;
+}
@@ -0,0 +1,47 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#define APP_FAN_PID_Q 8    // gains and the integrator are Q24.8 fixed point
+
+typedef struct {
+    int32_t kp;         /* Q24.8, output units per RPM of error */
+    int32_t ki;         /* Q24.8, output units per RPM of error and tick */
+    int32_t kd;         /* Q24.8, output units per RPM of change per tick */
+    int32_t out_min;
+    int32_t out_max;
+} app_fan_pid_gains_t;
+
+typedef struct {
+    int32_t integral;   /* Q24.8, already scaled by ki */
+    int32_t prev_measurement;
+} app_fan_pid_state_t;
+
+/** Reset the controller, e.g. when the fan is switched off */
+void app_fan_pid_reset(app_fan_pid_state_t *state, int32_t measurement);
+
+/** Run one control tick
+ *
+ * Computes `feedforward + P + I + D`, clamped to the output range. The derivative acts on the
+ * measurement to avoid a kick on setpoint changes. The integrator is clamped so that it can never
+ * push the output beyond its range on its own, and it stops integrating while the output is saturated
+ * in the direction of the error (anti-windup).
+ *
+ * @param[in] gains Controller gains and output range.
+ * @param[inout] state Controller state of the fan.
+ * @param[in] setpoint Target speed in RPM.
+ * @param[in] measurement Measured speed in RPM.
+ * @param[in] feedforward Open-loop output for the setpoint.
+ *
+ * @return controller output.
+ */
+int32_t app_fan_pid_step(const app_fan_pid_gains_t *gains, app_fan_pid_state_t *state, int32_t setpoint,
+                         int32_t measurement, int32_t feedforward);
@@ -0,0 +1,200 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_matter.h>
+#include <esp_matter_console.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <app/clusters/scenes-server/SceneHandlerImpl.h>
+#include <app/clusters/scenes-server/scenes-server.h>
+
+#include <app_fan_mode.h>
+#include <app_fan_scenes.h>
+
+using namespace chip;
+using namespace chip::app::Clusters;
+using namespace esp_matter;
+
+typedef struct {
+    const char *name;
+    uint8_t percent;
+} fan_preset_t;
+
+static const fan_preset_t k_fan_presets[] = {
+    { "off", 0 },
+    { "quiet", 25 },
+    { "normal", 50 },
+    { "boost", 100 },
+};
+
+static const char *TAG = "app_fan_scenes";
+static uint16_t s_fan_endpoints[CONFIG_FAN_COUNT];
+static size_t s_fan_endpoint_count;
+
+static uint8_t read_u8(EndpointId endpoint, AttributeId attribute_id, uint8_t fallback)
+{
+    attribute_t *attribute = attribute::get(endpoint, FanControl::Id, attribute_id);
+    esp_matter_attr_val_t val = esp_matter_invalid(NULL);
+    if (!attribute || attribute::get_val(attribute, &val) != ESP_OK) {
+        return fallback;
+    }
+    return val.val.u8;
+}
+
+/* FanControl has no scene handler in the SDK. The default implementation encodes and decodes the attribute value
+   pairs, this class saves and applies them. */
+class fan_scene_handler : public scenes::DefaultSceneHandlerImpl {
+public:
+    void GetSupportedClusters(EndpointId endpoint, Span<ClusterId> &clusterBuffer) override
+    {
+        if (clusterBuffer.size() >= 1 && SupportsCluster(endpoint, FanControl::Id)) {
+            clusterBuffer[0] = FanControl::Id;
+            clusterBuffer.reduce_size(1);
+        } else {
+            clusterBuffer.reduce_size(0);
+        }
+    }
+
+    bool SupportsCluster(EndpointId endpoint, ClusterId cluster) override
+    {
+        return cluster == FanControl::Id && cluster::get(endpoint::get(node::get(), endpoint), FanControl::Id);
+    }
+
+    CHIP_ERROR SerializeSave(EndpointId endpoint, ClusterId cluster, MutableByteSpan &serializedBytes) override
+    {
+        using AttributeValuePair = ScenesManagement::Structs::AttributeValuePairStruct::Type;
+
+        AttributeValuePair pairs[2];
+        pairs[0].attributeID = FanControl::Attributes::FanMode::Id;
+        pairs[0].valueUnsigned8.SetValue(read_u8(endpoint, FanControl::Attributes::FanMode::Id, APP_FAN_MODE_OFF));
+        pairs[1].attributeID = FanControl::Attributes::PercentSetting::Id;
+        pairs[1].valueUnsigned8.SetValue(read_u8(endpoint, FanControl::Attributes::PercentSetting::Id, 0));
+
+        app::DataModel::List<AttributeValuePair> list(pairs);
+        return EncodeAttributeValueList(list, serializedBytes);
+    }
+
+    /* The writes go through the data model, so the driver reconciles and reports them as for a controller write.
+       The transition time is not used, the fans ramp at their slew rate. */
+    CHIP_ERROR ApplyScene(EndpointId endpoint, ClusterId cluster, const ByteSpan &serializedBytes,
+                          scenes::TransitionTimeMs timeMs) override
+    {
+        app::DataModel::DecodableList<ScenesManagement::Structs::AttributeValuePairStruct::DecodableType> list;
+        ReturnErrorOnFailure(DecodeAttributeValueList(serializedBytes, list));
+
+        uint8_t fan_mode = UINT8_MAX;
+        uint8_t percent = UINT8_MAX;
+        auto pair = list.begin();
+        while (pair.Next()) {
+            const auto &value = pair.GetValue();
+            if (!value.valueUnsigned8.HasValue()) {
+                continue;
+            }
+            if (value.attributeID == FanControl::Attributes::FanMode::Id) {
+                fan_mode = value.valueUnsigned8.Value();
+            } else if (value.attributeID == FanControl::Attributes::PercentSetting::Id) {
+                percent = value.valueUnsigned8.Value();
+            }
+        }
+        ReturnErrorOnFailure(pair.GetStatus());
+
+        if (fan_mode < k_fan_mode_count) {
+            esp_matter_attr_val_t val = esp_matter_enum8(fan_mode);
+            attribute::update(endpoint, FanControl::Id, FanControl::Attributes::FanMode::Id, &val);
+        }
+        /* In Auto mode the speed comes from the temperature input, not from the scene */
+        if (percent <= 100 && fan_mode != APP_FAN_MODE_AUTO) {
+            esp_matter_attr_val_t val = esp_matter_nullable_uint8(percent);
+            attribute::update(endpoint, FanControl::Id, FanControl::Attributes::PercentSetting::Id, &val);
+        }
+        return CHIP_NO_ERROR;
+    }
+};
+
+static fan_scene_handler s_scene_handler;
+
+esp_err_t app_fan_scenes_register(uint16_t endpoint_id)
+{
+    if (s_fan_endpoint_count >= CONFIG_FAN_COUNT) {
+        return ESP_ERR_NO_MEM;
+    }
+    ScenesManagement::ScenesServer::Instance().RegisterSceneHandler(endpoint_id, &s_scene_handler);
+    s_fan_endpoints[s_fan_endpoint_count++] = endpoint_id;
+    return ESP_OK;
+}
+
+static esp_err_t preset_apply(const fan_preset_t *preset)
+{
+    /* All writes happen in one CHIP event, the driver commits them together */
+    esp_err_t err = ESP_OK;
+    for (size_t i = 0; i < s_fan_endpoint_count; i++) {
+        esp_matter_attr_val_t val = esp_matter_nullable_uint8(preset->percent);
+        err |= attribute::update(s_fan_endpoints[i], FanControl::Id, FanControl::Attributes::PercentSetting::Id,
+                                 &val);
+    }
+    return err;
+}
+
+esp_err_t app_fan_preset_recall(const char *name)
+{
+    for (size_t i = 0; i < sizeof(k_fan_presets) / sizeof(k_fan_presets[0]); i++) {
+        if (strcmp(k_fan_presets[i].name, name) == 0) {
+            return preset_apply(&k_fan_presets[i]);
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static void preset_recall_work(intptr_t arg)
+{
+    preset_apply(&k_fan_presets[arg]);
+}
+
+static esp_err_t preset_command_handler(int argc, char **argv)
+{
+    if (argc == 1 && strcmp(argv[0], "list") == 0) {
+        printf("preset,percent\n");
+        for (size_t i = 0; i < sizeof(k_fan_presets) / sizeof(k_fan_presets[0]); i++) {
+            printf("%s,%u\n", k_fan_presets[i].name, k_fan_presets[i].percent);
+        }
+        return ESP_OK;
+    }
+    if (argc == 1) {
+        for (size_t i = 0; i < sizeof(k_fan_presets) / sizeof(k_fan_presets[0]); i++) {
+            if (strcmp(k_fan_presets[i].name, argv[0]) == 0) {
+                DeviceLayer::PlatformMgr().ScheduleWork(preset_recall_work, (intptr_t)i);
+                return ESP_OK;
+            }
+        }
+    }
+    ESP_LOGE(TAG, "Usage: preset list|<name>");
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t app_fan_preset_register_commands()
+{
+    static const esp_matter::console::command_t command = {
+        .name = "preset",
+        .description = "Recall a fan preset on all fans. Usage: matter esp preset list|<name>",
+        .handler = preset_command_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+}
+
+#else
+
+esp_err_t app_fan_preset_register_commands()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_ENABLE_CHIP_SHELL
@@ -0,0 +1,47 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_err.h>
+
+/** Register the FanControl scene handler on a fan endpoint
+ *
+ * Scenes stored on the endpoint save FanMode and PercentSetting, a recall writes them back through the
+ * data model. A group scene recall reaches all fans in one CHIP event, the driver applies it with a single
+ * PWM commit. Must be called on the CHIP thread after `esp_matter::start()`.
+ *
+ * @param[in] endpoint_id Endpoint ID of the fan, it must have the Scenes Management cluster.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_fan_scenes_register(uint16_t endpoint_id);
+
+/** Recall a built-in preset on all fans
+ *
+ * Presets are a constant table in RAM, recalling one does not touch the scene table or the flash. All
+ * fans change in the same PWM commit. Must be called on the CHIP thread.
+ *
+ * @param[in] name Preset name, e.g. "quiet" or "boost".
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_FOUND if there is no such preset.
+ */
+esp_err_t app_fan_preset_recall(const char *name);
+
+/** Register the `preset` console command
+ *
+ * `matter esp preset <name>` recalls a built-in preset, `matter esp preset list` prints them.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_fan_preset_register_commands();
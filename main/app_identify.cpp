@@ -0,0 +1,266 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include "driver/ledc.h"
+#include "freertos/FreeRTOS.h"
+#include "soc/soc_caps.h"
+
+#include <app_identify.h>
+
+/* The fans take the first CONFIG_FAN_COUNT LEDC channels, the LED gets the next one if there is one left */
+#define IDENTIFY_USE_LEDC       (CONFIG_FAN_COUNT < SOC_LEDC_CHANNEL_NUM)
+#define IDENTIFY_SPEED_MODE     LEDC_LOW_SPEED_MODE
+#define IDENTIFY_TIMER          LEDC_TIMER_1
+#define IDENTIFY_CHANNEL        ((ledc_channel_t)(LEDC_CHANNEL_0 + CONFIG_FAN_COUNT))
+#define IDENTIFY_FREQUENCY      (5000)
+#define IDENTIFY_DUTY_RES       LEDC_TIMER_10_BIT
+#define IDENTIFY_DUTY_MAX       (1 << 10)
+
+/* One step of an effect: move to `level` in permille, fading over `time_ms` if the pattern fades, then hold until
+   the step time is over. A step time of 0 holds the level until the next change. */
+typedef struct {
+    uint16_t level;
+    uint16_t time_ms;
+} identify_step_t;
+
+typedef struct {
+    const identify_step_t *steps;
+    uint8_t step_count;
+    uint8_t repeat;         /* cycles of the steps, 0 repeats until replaced */
+    bool fade;
+} identify_pattern_t;
+
+static const identify_step_t k_blink_steps[] = { { 1000, 500 }, { 0, 500 } };
+static const identify_step_t k_identify_steps[] = { { 1000, 250 }, { 0, 250 } };
+static const identify_step_t k_okay_steps[] = { { 1000, 250 }, { 0, 250 }, { 1000, 250 }, { 0, 250 } };
+static const identify_step_t k_channel_change_steps[] = { { 1000, 500 }, { 50, 7500 } };
+static const identify_step_t k_on_steps[] = { { 1000, 0 } };
+static const identify_step_t k_off_steps[] = { { 0, 0 } };
+
+static const identify_pattern_t k_blink = { k_blink_steps, 2, 1, false };
+static const identify_pattern_t k_breathe = { k_blink_steps, 2, 15, true };
+static const identify_pattern_t k_okay = { k_okay_steps, 4, 1, false };
+static const identify_pattern_t k_channel_change = { k_channel_change_steps, 2, 1, false };
+static const identify_pattern_t k_identify = { k_identify_steps, 2, 0, false };
+static const identify_pattern_t k_commissioning = { k_blink_steps, 2, 0, false };
+static const identify_pattern_t k_on = { k_on_steps, 1, 1, false };
+static const identify_pattern_t k_off = { k_off_steps, 1, 1, false };
+
+static const char *TAG = "app_identify";
+static gpio_num_t s_led_gpio = GPIO_NUM_NC;
+static esp_timer_handle_t s_step_timer;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Protected by s_lock */
+static const identify_pattern_t *s_effect;
+static uint8_t s_step;
+static uint8_t s_cycle;
+static bool s_finish;
+static bool s_commissioned;
+static bool s_reset_pending;
+
+static const identify_pattern_t *active_pattern()
+{
+    if (s_reset_pending) {
+        return &k_on;
+    }
+    if (s_effect) {
+        return s_effect;
+    }
+    return s_commissioned ? &k_off : &k_commissioning;
+}
+
+static void led_output(uint16_t level, uint32_t fade_ms)
+{
+#if IDENTIFY_USE_LEDC
+    uint32_t duty = ((uint32_t)level * (IDENTIFY_DUTY_MAX - 1)) / 1000;
+    ledc_fade_stop(IDENTIFY_SPEED_MODE, IDENTIFY_CHANNEL);
+    if (fade_ms > 0 && ledc_set_fade_with_time(IDENTIFY_SPEED_MODE, IDENTIFY_CHANNEL, duty, fade_ms) == ESP_OK) {
+        ledc_fade_start(IDENTIFY_SPEED_MODE, IDENTIFY_CHANNEL, LEDC_FADE_NO_WAIT);
+        return;
+    }
+    ledc_set_duty(IDENTIFY_SPEED_MODE, IDENTIFY_CHANNEL, duty);
+    ledc_update_duty(IDENTIFY_SPEED_MODE, IDENTIFY_CHANNEL);
+#else
+    gpio_set_level(s_led_gpio, level >= 500 ? 1 : 0);
+#endif
+}
+
+/* Runs in the esp_timer task, outputs the next step of the active pattern and arms the timer for the one after */
+static void identify_step_cb(void *arg)
+{
+    portENTER_CRITICAL(&s_lock);
+    const identify_pattern_t *pattern = active_pattern();
+    if (s_step >= pattern->step_count) {
+        s_step = 0;
+        s_cycle++;
+        if (pattern == s_effect && (s_finish || (pattern->repeat && s_cycle >= pattern->repeat))) {
+            s_effect = NULL;
+            s_finish = false;
+            s_cycle = 0;
+            pattern = active_pattern();
+        }
+    }
+    identify_step_t step = pattern->steps[s_step++];
+    bool fade = pattern->fade;
+    portEXIT_CRITICAL(&s_lock);
+
+    led_output(step.level, fade ? step.time_ms : 0);
+    if (step.time_ms > 0) {
+        esp_timer_start_once(s_step_timer, (uint64_t)step.time_ms * 1000);
+    }
+}
+
+/* Called after the pattern selection changed, the new pattern starts from its first step */
+static void identify_restart()
+{
+    if (!s_step_timer) {
+        return;
+    }
+    esp_timer_stop(s_step_timer);
+    esp_timer_start_once(s_step_timer, 0);
+}
+
+static void identify_select(const identify_pattern_t *effect)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_effect = effect;
+    s_step = 0;
+    s_cycle = 0;
+    s_finish = false;
+    portEXIT_CRITICAL(&s_lock);
+    identify_restart();
+}
+
+esp_err_t app_identify_init(gpio_num_t led_gpio)
+{
+    s_led_gpio = led_gpio;
+#if IDENTIFY_USE_LEDC
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode = IDENTIFY_SPEED_MODE,
+        .duty_resolution = IDENTIFY_DUTY_RES,
+        .timer_num = IDENTIFY_TIMER,
+        .freq_hz = IDENTIFY_FREQUENCY,
+        .clk_cfg = LEDC_AUTO_CLK
+    };
+    esp_err_t err = ledc_timer_config(&ledc_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure timer: %s", esp_err_to_name(err));
+        return err;
+    }
+    ledc_channel_config_t ledc_channel = {
+        .gpio_num = led_gpio,
+        .speed_mode = IDENTIFY_SPEED_MODE,
+        .channel = IDENTIFY_CHANNEL,
+        .intr_type = LEDC_INTR_DISABLE,
+        .timer_sel = IDENTIFY_TIMER,
+        .duty = 0,
+        .hpoint = 0
+    };
+    err = ledc_channel_config(&ledc_channel);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure channel: %s", esp_err_to_name(err));
+        return err;
+    }
+    /* Already installed if the fan bank was initialized first */
+    err = ledc_fade_func_install(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return err;
+    }
+#else
+    gpio_config_t io_conf = {};
+    io_conf.intr_type = GPIO_INTR_DISABLE;
+    io_conf.mode = GPIO_MODE_OUTPUT;
+    io_conf.pin_bit_mask = (1ULL << led_gpio);
+    io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
+    esp_err_t err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        return err;
+    }
+    ESP_LOGW(TAG, "No LEDC channel left for the LED, fading effects are shown as steps");
+#endif
+
+    esp_timer_create_args_t timer_args = {
+        .callback = identify_step_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "identify",
+        .skip_unhandled_events = true,
+    };
+    err = esp_timer_create(&timer_args, &s_step_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    identify_restart();
+    return ESP_OK;
+}
+
+void app_identify_set_commissioned(bool commissioned)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool changed = s_commissioned != commissioned;
+    s_commissioned = commissioned;
+    bool idle = !s_effect && !s_reset_pending;
+    if (changed && idle) {
+        s_step = 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    if (changed && idle) {
+        identify_restart();
+    }
+}
+
+void app_identify_set_factory_reset(bool pending)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_reset_pending = pending;
+    s_step = 0;
+    s_cycle = 0;
+    portEXIT_CRITICAL(&s_lock);
+    identify_restart();
+}
+
+void app_identify_start()
+{
+    identify_select(&k_identify);
+}
+
+void app_identify_stop()
+{
+    identify_select(NULL);
+}
+
+void app_identify_effect(uint8_t effect_id)
+{
+    switch (effect_id) {
+    case APP_IDENTIFY_EFFECT_BREATHE:
+        identify_select(&k_breathe);
+        break;
+    case APP_IDENTIFY_EFFECT_OKAY:
+        identify_select(&k_okay);
+        break;
+    case APP_IDENTIFY_EFFECT_CHANNEL_CHANGE:
+        identify_select(&k_channel_change);
+        break;
+    case APP_IDENTIFY_EFFECT_FINISH:
+        portENTER_CRITICAL(&s_lock);
+        s_finish = true;
+        portEXIT_CRITICAL(&s_lock);
+        break;
+    case APP_IDENTIFY_EFFECT_STOP:
+        identify_select(NULL);
+        break;
+    case APP_IDENTIFY_EFFECT_BLINK:
+    default:
+        identify_select(&k_blink);
+        break;
+    }
+}
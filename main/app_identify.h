@@ -0,0 +1,55 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_err.h>
+#include "driver/gpio.h"
+
+/* Values of Identify::EffectIdentifierEnum */
+#define APP_IDENTIFY_EFFECT_BLINK           0x00
+#define APP_IDENTIFY_EFFECT_BREATHE         0x01
+#define APP_IDENTIFY_EFFECT_OKAY            0x02
+#define APP_IDENTIFY_EFFECT_CHANNEL_CHANGE  0x0b
+#define APP_IDENTIFY_EFFECT_FINISH          0xfe
+#define APP_IDENTIFY_EFFECT_STOP            0xff
+
+/** Initialize the status LED effects engine
+ *
+ * The LED is driven by a LEDC channel, fades run in the LEDC fade unit and the steps of an effect are
+ * sequenced by a one-shot esp_timer. No task polls the LED, with nothing to show no timer is armed.
+ * If all LEDC channels are taken by fans, the LED falls back to plain GPIO levels and fades become steps.
+ *
+ * @param[in] led_gpio GPIO of the status LED.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_identify_init(gpio_num_t led_gpio);
+
+/** Select the idle indication: slow blinking while the device is not commissioned, off otherwise */
+void app_identify_set_commissioned(bool commissioned);
+
+/** Keep the LED on while a factory reset is pending, overrides every other effect */
+void app_identify_set_factory_reset(bool pending);
+
+/** Blink until `app_identify_stop()`, used while IdentifyTime is running */
+void app_identify_start();
+
+void app_identify_stop();
+
+/** Run an effect of the Identify cluster TriggerEffect command
+ *
+ * Finish lets the running effect complete its current cycle, Stop ends it at once. Unknown effects
+ * are run as Blink.
+ *
+ * @param[in] effect_id One of the `APP_IDENTIFY_EFFECT_*` values.
+ */
+void app_identify_effect(uint8_t effect_id);
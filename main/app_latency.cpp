@@ -0,0 +1,146 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <esp_rom_sys.h>
+
+#include <app_latency.h>
+
+static const char *TAG = "app_latency";
+
+#if CONFIG_APP_LATENCY_ENABLE
+
+/* Endpoint 0 plus the fan endpoints, all other endpoints share the last slot */
+#define LATENCY_ENDPOINT_SLOTS  (CONFIG_FAN_COUNT + 2)
+/* Bucket n holds durations of [2^(n-1), 2^n) cycles */
+#define LATENCY_BUCKETS         33
+
+typedef struct {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t max;
+} latency_histogram_t;
+
+static latency_histogram_t s_histograms[APP_LATENCY_STAGE_COUNT][LATENCY_ENDPOINT_SLOTS];
+
+void app_latency_record(app_latency_stage_t stage, uint16_t endpoint_id, uint32_t start)
+{
+    uint32_t cycles = esp_cpu_get_cycle_count() - start;
+    uint16_t slot = endpoint_id < LATENCY_ENDPOINT_SLOTS ? endpoint_id : LATENCY_ENDPOINT_SLOTS - 1;
+    latency_histogram_t *histogram = &s_histograms[stage][slot];
+
+    uint32_t bucket = cycles ? 32 - __builtin_clz(cycles) : 0;
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    if (cycles > histogram->max) {
+        histogram->max = cycles;
+    }
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static const char *stage_name(int stage)
+{
+    switch (stage) {
+    case APP_LATENCY_UPDATE_CB:
+        return "update_cb";
+    case APP_LATENCY_DRIVER_UPDATE:
+        return "driver_update";
+    case APP_LATENCY_ATTRIBUTE_ACCESS:
+        return "attribute_access";
+    case APP_LATENCY_SET_FAN_SPEED:
+        return "set_fan_speed";
+    case APP_LATENCY_FAN_COMMIT:
+        return "fan_commit";
+    case APP_LATENCY_LOCAL_CONTROL:
+        return "local_control";
+    default:
+        return "unknown";
+    }
+}
+
+/* Upper bound of the bucket that contains the given percentile, in cycles */
+static uint32_t percentile(const latency_histogram_t *histogram, uint32_t percent)
+{
+    uint32_t rank = (histogram->count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            return i == 0 ? 0 : (i >= 32 ? UINT32_MAX : (1u << i) - 1);
+        }
+    }
+    return histogram->max;
+}
+
+static uint32_t cycles_to_ns(uint32_t cycles)
+{
+    return (uint32_t)(((uint64_t)cycles * 1000) / esp_rom_get_cpu_ticks_per_us());
+}
+
+static void latency_dump()
+{
+    printf("stage,endpoint,count,p50_ns,p99_ns,max_ns\n");
+    for (int stage = 0; stage < APP_LATENCY_STAGE_COUNT; stage++) {
+        for (int slot = 0; slot < LATENCY_ENDPOINT_SLOTS; slot++) {
+            const latency_histogram_t *histogram = &s_histograms[stage][slot];
+            if (histogram->count == 0) {
+                continue;
+            }
+            printf("%s,%d,%lu,%lu,%lu,%lu\n", stage_name(stage), slot, histogram->count,
+                   cycles_to_ns(percentile(histogram, 50)), cycles_to_ns(percentile(histogram, 99)),
+                   cycles_to_ns(histogram->max));
+        }
+    }
+}
+
+static esp_err_t latency_command_handler(int argc, char **argv)
+{
+    if (argc == 1 && strcmp(argv[0], "dump") == 0) {
+        latency_dump();
+        return ESP_OK;
+    }
+    if (argc == 1 && strcmp(argv[0], "reset") == 0) {
+        memset(s_histograms, 0, sizeof(s_histograms));
+        return ESP_OK;
+    }
+    ESP_LOGE(TAG, "Usage: latency dump|reset");
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t app_latency_register_commands()
+{
+    static const esp_matter::console::command_t command = {
+        .name = "latency",
+        .description = "Attribute update latency histograms. Usage: matter esp latency dump|reset",
+        .handler = latency_command_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+}
+
+#else
+
+esp_err_t app_latency_register_commands()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_ENABLE_CHIP_SHELL
+
+#else
+
+esp_err_t app_latency_register_commands()
+{
+    ESP_LOGW(TAG, "Latency instrumentation is disabled");
+    return ESP_OK;
+}
+
+#endif // CONFIG_APP_LATENCY_ENABLE
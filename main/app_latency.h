@@ -0,0 +1,62 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_err.h>
+#if CONFIG_APP_LATENCY_ENABLE
+#include "esp_cpu.h"
+#endif
+
+typedef enum {
+    APP_LATENCY_UPDATE_CB = 0,      /* app_attribute_update_cb() */
+    APP_LATENCY_DRIVER_UPDATE,      /* app_driver_attribute_update() */
+    APP_LATENCY_ATTRIBUTE_ACCESS,   /* one get or set of a cached attribute value */
+    APP_LATENCY_SET_FAN_SPEED,      /* hand over of a new target to the driver task */
+    APP_LATENCY_FAN_COMMIT,         /* driver task: apply the pending targets and commit the bank */
+    APP_LATENCY_LOCAL_CONTROL,      /* button gesture until the new target is handed to the driver task */
+    APP_LATENCY_STAGE_COUNT,
+} app_latency_stage_t;
+
+#if CONFIG_APP_LATENCY_ENABLE
+
+/* Cycle counter of the current core. The counters of the two ESP32 cores are not synchronized, a measurement
+   whose task migrated to the other core in between ends up in a wrong bucket. The stages are short, so this
+   is rare. */
+static inline uint32_t app_latency_now()
+{
+    return esp_cpu_get_cycle_count();
+}
+
+/** Add the cycles elapsed since `start` to the histogram of the stage for the endpoint */
+void app_latency_record(app_latency_stage_t stage, uint16_t endpoint_id, uint32_t start);
+
+#else
+
+static inline uint32_t app_latency_now()
+{
+    return 0;
+}
+
+static inline void app_latency_record(app_latency_stage_t stage, uint16_t endpoint_id, uint32_t start)
+{
+}
+
+#endif // CONFIG_APP_LATENCY_ENABLE
+
+/** Register the `latency` console command
+ *
+ * `matter esp latency dump` prints count, p50, p99 and max per stage and endpoint.
+ * `matter esp latency reset` clears all histograms.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_latency_register_commands();
@@ -8,15 +8,24 @@
 
 #include <esp_err.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <nvs_flash.h>
-#include <nvs.h>
 
 #include <esp_matter.h>
 #include <esp_matter_console.h>
 #include <esp_matter_ota.h>
 
 #include <app_priv.h>
+#include <app_fan_endpoints.h>
 #include <app_reset.h>
+#include <app_fan_auto.h>
+#include <app_trace.h>
+#include <app_latency.h>
+#include <app_persist.h>
+#include <app_identify.h>
+#include <app_mem.h>
+#include <app_fan_scenes.h>
+#include <app_factory_data.h>
 #if CHIP_DEVICE_CONFIG_ENABLE_THREAD
 #include <platform/ESP32/OpenthreadLauncher.h>
 #endif
@@ -27,12 +36,11 @@
 #include "driver/gpio.h"
 
 #define PRODUCT_NAME "Lüfter-Device"
-#define NVS_NAMESPACE "storage"
-#define COMMISSIONED_KEY "commissioned"
 
 static const char *TAG = "app_main";
 uint16_t fan_endpoint_id = 0;
-uint16_t fan_endpoint_id_1 = 0;
+static uint16_t s_fan_endpoint_ids[CONFIG_FAN_COUNT];
+static size_t s_fan_endpoint_id_count;
 
 using namespace esp_matter;
 using namespace esp_matter::attribute;
@@ -41,6 +49,15 @@ using namespace chip::app::Clusters;
 
 constexpr auto k_timeout_seconds = 300;
 
+static_assert(APP_IDENTIFY_EFFECT_BLINK == chip::to_underlying(Identify::EffectIdentifierEnum::kBlink) &&
+              APP_IDENTIFY_EFFECT_BREATHE == chip::to_underlying(Identify::EffectIdentifierEnum::kBreathe) &&
+              APP_IDENTIFY_EFFECT_OKAY == chip::to_underlying(Identify::EffectIdentifierEnum::kOkay) &&
+              APP_IDENTIFY_EFFECT_CHANNEL_CHANGE ==
+                  chip::to_underlying(Identify::EffectIdentifierEnum::kChannelChange) &&
+              APP_IDENTIFY_EFFECT_FINISH == chip::to_underlying(Identify::EffectIdentifierEnum::kFinishEffect) &&
+              APP_IDENTIFY_EFFECT_STOP == chip::to_underlying(Identify::EffectIdentifierEnum::kStopEffect),
+              "EffectIdentifierEnum mismatch");
+
 #if CONFIG_ENABLE_ENCRYPTED_OTA
 extern const char decryption_key_start[] asm("_binary_esp_image_encryption_key_pem_start");
 extern const char decryption_key_end[] asm("_binary_esp_image_encryption_key_pem_end");
@@ -53,53 +70,53 @@ static const uint16_t s_decryption_key_len = decryption_key_end - decryption_key
 static gpio_num_t reset_gpio = gpio_num_t::GPIO_NUM_NC;
 bool commissioned = false;
 
+// Start times of the running OTA download and apply, reported per release by tools/ota/local_provider.sh
+static int64_t s_ota_download_start_us;
+static int64_t s_ota_apply_start_us;
+
+static void ota_state_changed(chip::DeviceLayer::OtaState state)
+{
+    using chip::DeviceLayer::OtaState;
+    int64_t now_us = esp_timer_get_time();
+    switch (state) {
+    case OtaState::kOtaDownloadInProgress:
+        s_ota_download_start_us = now_us;
+        ESP_LOGI(TAG, "OTA download started");
+        break;
+    case OtaState::kOtaDownloadComplete:
+        /* With delta OTA the patch is applied to the inactive slot while it streams in, so this covers patching */
+        ESP_LOGI(TAG, "OTA download complete in %lld ms", (now_us - s_ota_download_start_us) / 1000);
+        break;
+    case OtaState::kOtaDownloadFailed:
+    case OtaState::kOtaDownloadAborted:
+        ESP_LOGW(TAG, "OTA download stopped after %lld ms", (now_us - s_ota_download_start_us) / 1000);
+        break;
+    case OtaState::kOtaApplyInProgress:
+        s_ota_apply_start_us = now_us;
+        ESP_LOGI(TAG, "OTA apply started");
+        break;
+    case OtaState::kOtaApplyComplete:
+        ESP_LOGI(TAG, "OTA apply complete in %lld ms, %lld ms since download start",
+                 (now_us - s_ota_apply_start_us) / 1000, (now_us - s_ota_download_start_us) / 1000);
+        break;
+    case OtaState::kOtaApplyFailed:
+        ESP_LOGE(TAG, "OTA apply failed after %lld ms", (now_us - s_ota_apply_start_us) / 1000);
+        break;
+    default:
+        break;
+    }
+}
+
 // Funktion zum Speichern des Kommissionierungsstatus
+// Only updates the RAM copy, the write to NVS is done by the persist task so the CHIP thread never waits for flash
 void save_commissioned_status(bool status) {
-    nvs_handle_t nvs_handle;
-    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle) == ESP_OK) {
-        nvs_set_u8(nvs_handle, COMMISSIONED_KEY, status ? 1 : 0);
-        nvs_commit(nvs_handle);
-        nvs_close(nvs_handle);
-    } else {
-        ESP_LOGE(TAG, "Failed to open NVS for writing");
-    }
+    app_persist_set_commissioned(status);
 }
 
 // Funktion zum Laden des Kommissionierungsstatus
 bool load_commissioned_status() {
-    nvs_handle_t nvs_handle;
-    uint8_t commissioned_status = 0; // Standardwert: nicht kommissioniert
-
-    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) == ESP_OK) {
-        nvs_get_u8(nvs_handle, COMMISSIONED_KEY, &commissioned_status);
-        nvs_close(nvs_handle);
-    } else {
-        ESP_LOGW(TAG, "Failed to open NVS for reading");
-    }
-
-    return commissioned_status == 1;
-}
-///////////////////////////////////////////// led
-void led_blink_task(void *pvParameter)
-{
-    while (true) {
-
-        if (!commissioned) {
-            // Blinken: LED an
-            gpio_set_level((gpio_num_t)CONFIG_LED_PIN, 1);
-            vTaskDelay(pdMS_TO_TICKS(500)); // 500 ms warten
-
-            // Blinken: LED aus
-            gpio_set_level((gpio_num_t)CONFIG_LED_PIN, 0);
-            vTaskDelay(pdMS_TO_TICKS(500)); // 500 ms warten
-        } else {
-            gpio_set_level((gpio_num_t)CONFIG_LED_PIN, 0);
-            vTaskDelay(pdMS_TO_TICKS(1000));
-        }
-    }
+    return app_persist_get_commissioned();
 }
-///////////////////////////////////////////// led
-
 static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
 {
     switch (event->Type) {
@@ -111,6 +128,12 @@ static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
         ESP_LOGI(TAG, "Commissioning complete");
         commissioned = true;
         save_commissioned_status(commissioned);
+        app_identify_set_commissioned(commissioned);
+#if CONFIG_FAN_CALIBRATE_ON_COMMISSIONING
+        for (size_t i = 0; i < s_fan_endpoint_id_count; i++) {
+            app_driver_fan_calibrate(NULL, s_fan_endpoint_ids[i], false);
+        }
+#endif
         break;
 
     case chip::DeviceLayer::DeviceEventType::kFailSafeTimerExpired:
@@ -172,6 +195,10 @@ static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
         ESP_LOGI(TAG, "BLE deinitialized and memory reclaimed");
         break;
 
+    case chip::DeviceLayer::DeviceEventType::kOtaStateChanged:
+        ota_state_changed(event->OtaStateChanged.newState);
+        break;
+
     default:
         break;
     }
@@ -183,6 +210,25 @@ static esp_err_t app_identification_cb(identification::callback_type_t type, uin
                                        uint8_t effect_variant, void *priv_data)
 {
     ESP_LOGI(TAG, "Identification callback: type: %u, effect: %u, variant: %u", type, effect_id, effect_variant);
+    app_driver_handle_t driver_handle = (app_driver_handle_t)priv_data;
+
+    switch (type) {
+    case identification::START:
+        app_identify_start();
+        app_driver_fan_identify_pulse(driver_handle, endpoint_id);
+        break;
+    case identification::STOP:
+        app_identify_stop();
+        break;
+    case identification::EFFECT:
+        app_identify_effect(effect_id);
+        if (effect_id != APP_IDENTIFY_EFFECT_FINISH && effect_id != APP_IDENTIFY_EFFECT_STOP) {
+            app_driver_fan_identify_pulse(driver_handle, endpoint_id);
+        }
+        break;
+    default:
+        break;
+    }
     return ESP_OK;
 }
 
@@ -193,6 +239,7 @@ static esp_err_t app_attribute_update_cb(attribute::callback_type_t type, uint16
                                          uint32_t attribute_id, esp_matter_attr_val_t *val, void *priv_data)
 {
     esp_err_t err = ESP_OK;
+    uint32_t start = app_latency_now();
 
     if (type == PRE_UPDATE) {
         /* Driver update */
@@ -200,45 +247,109 @@ static esp_err_t app_attribute_update_cb(attribute::callback_type_t type, uint16
         err = app_driver_attribute_update(driver_handle, endpoint_id, cluster_id, attribute_id, val);
     }
 
+    app_latency_record(APP_LATENCY_UPDATE_CB, endpoint_id, start);
     return err;
 }
 
+static void register_scene_handlers(intptr_t arg)
+{
+    for (size_t i = 0; i < s_fan_endpoint_id_count; i++) {
+        if (app_fan_scenes_register(s_fan_endpoint_ids[i]) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register the scene handler of endpoint %d", s_fan_endpoint_ids[i]);
+        }
+    }
+}
+
 extern "C" void app_main()
 {
     esp_err_t err = ESP_OK;
+    app_mem_mark("boot");
 
     /* Initialize the ESP NVS layer */
     nvs_flash_init();
+    app_mem_mark("nvs");
 
-    /* Initialize driver */
+    /* Initialize driver. The fans are restored to their last state first, before anything slow runs. */
+    app_driver_handle_t fan_handle = app_driver_fan_init();
+    app_mem_mark("fan_driver");
+    err = app_persist_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start the persistent state store: %d", err);
+    }
+    app_mem_mark("persist");
     commissioned = load_commissioned_status();
 
-    led_init();
+    err = app_identify_init((gpio_num_t)CONFIG_LED_PIN);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize the status LED: %d", err);
+    }
+    app_identify_set_commissioned(commissioned);
+    app_mem_mark("identify");
     // app_driver_handle_t button_handle = app_driver_button_init();
     // app_reset_button_register(button_handle);
-    /* Can ininialize Fan driver here */
-    app_driver_handle_t fan_handle = app_driver_fan_init();
 
     /* Create a Matter node and add the mandatory Root Node device type on endpoint 0 */
     node::config_t node_config;
     snprintf(node_config.root_node.basic_information.node_label, sizeof(node_config.root_node.basic_information.node_label),"%s", PRODUCT_NAME);
     node_t *node = node::create(&node_config, app_attribute_update_cb, app_identification_cb);
+    app_mem_mark("node");
+
+    endpoint_t *endpoint = NULL;
+    for (size_t i = 0; i < k_fan_endpoint_count; i++) {
+        fan::config_t fan_config;
+        fan_config.fan_control.fan_mode_sequence = k_fan_endpoints[i].fan_mode_sequence;
+        fan_config.fan_control.percent_current = 0;
+        fan_config.fan_control.percent_setting = static_cast<uint8_t>(0);
+        cluster::fan_control::feature::multi_speed::config_t multi_speed_config;
+        multi_speed_config.speed_max = CONFIG_FAN_SPEED_MAX;
+
+        /* Seed the data model with the state the driver restored the fan to, so both agree from the start */
+        app_persist_fan_t restored;
+        if (app_persist_get_fan(k_fan_endpoints[i].channel, &restored) == ESP_OK && restored.percent <= 100 &&
+            restored.fan_mode < k_fan_mode_count) {
+            uint8_t speed = app_fan_percent_to_speed(restored.percent, CONFIG_FAN_SPEED_MAX);
+            fan_config.fan_control.fan_mode = restored.fan_mode;
+            fan_config.fan_control.percent_setting = restored.percent;
+            fan_config.fan_control.percent_current = restored.percent;
+            multi_speed_config.speed_setting = speed;
+            multi_speed_config.speed_current = speed;
+        }
 
-    fan::config_t fan_config;
-    fan_config.fan_control.fan_mode_sequence = FAN_MODE_SEQUEBCE_VALUE;
-    fan_config.fan_control.percent_current = 0;
-    fan_config.fan_control.percent_setting = static_cast<uint8_t>(0);
-
-    endpoint_t *endpoint = fan::create(node, &fan_config, ENDPOINT_FLAG_NONE, fan_handle);
-
-    fan_endpoint_id = endpoint::get_id(endpoint);
-
-    endpoint_t *endpoint_1 = fan::create(node, &fan_config, ENDPOINT_FLAG_NONE, fan_handle);
-    fan_endpoint_id_1 = endpoint::get_id(endpoint_1);
-
-    ESP_LOGI(TAG, "Light created with endpoint_id %d", fan_endpoint_id);
-    ESP_LOGI(TAG, "Light created with endpoint_id %d", fan_endpoint_id_1);
-
+        endpoint_t *fan_endpoint = fan::create(node, &fan_config, ENDPOINT_FLAG_NONE, fan_handle);
+        if (!fan_endpoint) {
+            ESP_LOGE(TAG, "Failed to create fan endpoint %d", (int)i);
+            continue;
+        }
+        cluster::fan_control::feature::multi_speed::add(cluster::get(fan_endpoint, FanControl::Id),
+                                                        &multi_speed_config);
+        /* Groups and Scenes let one multicast write or scene recall set every fan */
+        if (!cluster::get(fan_endpoint, Groups::Id)) {
+            cluster::groups::config_t groups_config;
+            cluster::groups::create(fan_endpoint, &groups_config, CLUSTER_FLAG_SERVER);
+        }
+        cluster::scenes_management::config_t scenes_config;
+        cluster::scenes_management::create(fan_endpoint, &scenes_config, CLUSTER_FLAG_SERVER);
+        s_fan_endpoint_ids[s_fan_endpoint_id_count++] = endpoint::get_id(fan_endpoint);
+        if (!endpoint) {
+            endpoint = fan_endpoint;
+            fan_endpoint_id = endpoint::get_id(endpoint);
+        }
+        app_driver_fan_bind_endpoint(fan_handle, i, endpoint::get_id(fan_endpoint));
+        ESP_LOGI(TAG, "Fan %d created with endpoint_id %d on channel %d", (int)i + 1, endpoint::get_id(fan_endpoint),
+                 k_fan_endpoints[i].channel);
+    }
+    app_mem_mark("fan_endpoints");
+
+#if CONFIG_FAN_AUTO_LOCAL_SENSOR
+    /* Temperature input of the Auto fan mode */
+    temperature_sensor::config_t temperature_config;
+    endpoint_t *temperature_endpoint = temperature_sensor::create(node, &temperature_config, ENDPOINT_FLAG_NONE,
+                                                                  fan_handle);
+    if (temperature_endpoint) {
+        app_fan_auto_sensor_init(endpoint::get_id(temperature_endpoint));
+    }
+    app_mem_mark("temperature_sensor");
+#endif
 
     /* These node and endpoint handles can be used to create/add other endpoints and clusters. */
     if (!node || !endpoint) {
@@ -247,14 +358,14 @@ extern "C" void app_main()
 
     ESP_LOGI(TAG, "Fan created with endpoint_id %d", fan_endpoint_id);
 
-    xTaskCreate(led_blink_task, "blink_led_task", 2048, NULL, 5, NULL);
-
 
     // Initialize factory reset button
     app_driver_handle_t button_handle = app_driver_button_init(&reset_gpio);
     if (button_handle) {
         app_reset_button_register(button_handle);
+        app_driver_button_register_local_control(button_handle);
     }
+    app_mem_mark("button");
     //
 
 
@@ -268,11 +379,21 @@ extern "C" void app_main()
     set_openthread_platform_config(&config);
 #endif
 
+    err = app_factory_data_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install the factory data providers: %d", err);
+    }
+    app_mem_mark("factory_data");
+
     /* Matter start */
     err = esp_matter::start(app_event_cb);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Matter start failed: %d", err);
     }
+    app_mem_mark("matter_start");
+
+    /* The scene table exists once the server is up, the work runs after the server init scheduled by start() */
+    chip::DeviceLayer::PlatformMgr().ScheduleWork(register_scene_handlers, 0);
 
 #if CONFIG_ENABLE_ENCRYPTED_OTA
     err = esp_matter_ota_requestor_encrypted_init(s_decryption_key, s_decryption_key_len);
@@ -283,7 +404,13 @@ extern "C" void app_main()
 
 #if CONFIG_ENABLE_CHIP_SHELL
     esp_matter::console::diagnostics_register_commands();
+    app_trace_register_commands();
+    app_latency_register_commands();
+    app_mem_register_commands();
+    app_fan_preset_register_commands();
+    app_driver_fan_register_commands();
     esp_matter::console::wifi_register_commands();
     esp_matter::console::init();
+    app_mem_mark("console");
 #endif
 }
@@ -0,0 +1,161 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <esp_system.h>
+
+#include <app_mem.h>
+
+static const char *TAG = "app_mem";
+
+#if CONFIG_APP_MEM_PROFILE_ENABLE
+
+#define MEM_MAX_PHASES  24
+#define MEM_MAX_TASKS   8
+
+typedef struct {
+    const char *phase;
+    uint32_t free_internal;
+    uint32_t free_total;
+    uint32_t largest_internal;
+} mem_phase_t;
+
+typedef struct {
+    TaskHandle_t task;
+    uint32_t stack_size;
+} mem_task_t;
+
+/* Tasks created by ESP-IDF and the Matter stack, looked up by name when the report is printed */
+static const char *const k_system_tasks[] = {
+    "CHIP", "esp_timer", "tiT", "wifi", "nimble_host", "btController", "ot_task", "sys_evt", "ipc0", "ipc1",
+};
+
+static mem_phase_t s_phases[MEM_MAX_PHASES];
+static size_t s_phase_count;
+static mem_task_t s_tasks[MEM_MAX_TASKS];
+static size_t s_task_count;
+
+void app_mem_mark(const char *phase)
+{
+    if (s_phase_count >= MEM_MAX_PHASES) {
+        ESP_LOGW(TAG, "No room to record phase %s", phase);
+        return;
+    }
+    mem_phase_t *mark = &s_phases[s_phase_count++];
+    mark->phase = phase;
+    mark->free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    mark->free_total = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    mark->largest_internal = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+
+void app_mem_register_task(TaskHandle_t task, uint32_t stack_size)
+{
+    if (!task || s_task_count >= MEM_MAX_TASKS) {
+        return;
+    }
+    s_tasks[s_task_count].task = task;
+    s_tasks[s_task_count].stack_size = stack_size;
+    s_task_count++;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static void mem_dump_phases()
+{
+    printf("phase,free_internal,used_internal,free_total,largest_internal\n");
+    for (size_t i = 0; i < s_phase_count; i++) {
+        const mem_phase_t *mark = &s_phases[i];
+        int32_t used = i == 0 ? 0 : (int32_t)s_phases[i - 1].free_internal - (int32_t)mark->free_internal;
+        printf("%s,%lu,%ld,%lu,%lu\n", mark->phase, mark->free_internal, used, mark->free_total,
+               mark->largest_internal);
+    }
+}
+
+/* The high-water mark of ESP-IDF tasks is in bytes, it is the least free stack the task ever had */
+static void mem_dump_tasks()
+{
+    printf("task,stack_size,min_free_stack\n");
+    for (size_t i = 0; i < s_task_count; i++) {
+        printf("%s,%lu,%u\n", pcTaskGetName(s_tasks[i].task), s_tasks[i].stack_size,
+               (unsigned)uxTaskGetStackHighWaterMark(s_tasks[i].task));
+    }
+    for (size_t i = 0; i < sizeof(k_system_tasks) / sizeof(k_system_tasks[0]); i++) {
+        TaskHandle_t task = xTaskGetHandle(k_system_tasks[i]);
+        if (task) {
+            printf("%s,,%u\n", k_system_tasks[i], (unsigned)uxTaskGetStackHighWaterMark(task));
+        }
+    }
+}
+
+static void mem_dump_heap()
+{
+    printf("heap,free,min_free,largest_block\n");
+    printf("internal,%u,%u,%u\n", (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT),
+           (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT),
+           (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    printf("total,%lu,%lu,%u\n", esp_get_free_heap_size(), esp_get_minimum_free_heap_size(),
+           (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+}
+
+static esp_err_t mem_command_handler(int argc, char **argv)
+{
+    if (argc == 1 && strcmp(argv[0], "dump") == 0) {
+        mem_dump_phases();
+        mem_dump_tasks();
+        mem_dump_heap();
+        return ESP_OK;
+    }
+    if (argc == 1 && strcmp(argv[0], "phases") == 0) {
+        mem_dump_phases();
+        return ESP_OK;
+    }
+    if (argc == 1 && strcmp(argv[0], "tasks") == 0) {
+        mem_dump_tasks();
+        return ESP_OK;
+    }
+    if (argc == 1 && strcmp(argv[0], "heap") == 0) {
+        mem_dump_heap();
+        return ESP_OK;
+    }
+    ESP_LOGE(TAG, "Usage: mem dump|phases|tasks|heap");
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t app_mem_register_commands()
+{
+    static const esp_matter::console::command_t command = {
+        .name = "mem",
+        .description = "Heap per init phase, task stack high-water marks and heap minimum. "
+                       "Usage: matter esp mem dump|phases|tasks|heap",
+        .handler = mem_command_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+}
+
+#else
+
+esp_err_t app_mem_register_commands()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_ENABLE_CHIP_SHELL
+
+#else
+
+esp_err_t app_mem_register_commands()
+{
+    ESP_LOGW(TAG, "Memory profiling is disabled");
+    return ESP_OK;
+}
+
+#endif // CONFIG_APP_MEM_PROFILE_ENABLE
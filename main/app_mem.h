@@ -0,0 +1,48 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_err.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#if CONFIG_APP_MEM_PROFILE_ENABLE
+
+/** Record the heap state at the end of an init phase
+ *
+ * Stores free internal heap, free total heap and the largest free internal block. The difference to the
+ * previous mark is the memory the phase took. `phase` must be a string literal.
+ */
+void app_mem_mark(const char *phase);
+
+/** Register an application task for the stack report
+ *
+ * Tasks of ESP-IDF and the Matter stack are looked up by name, tasks of the application are registered
+ * with their stack size, so the report can show how much of the stack was ever used.
+ */
+void app_mem_register_task(TaskHandle_t task, uint32_t stack_size);
+
+#else
+
+static inline void app_mem_mark(const char *phase) {}
+static inline void app_mem_register_task(TaskHandle_t task, uint32_t stack_size) {}
+
+#endif // CONFIG_APP_MEM_PROFILE_ENABLE
+
+/** Register the `mem` console command
+ *
+ * `matter esp mem dump` prints the init phases, the stack high-water mark of every known task and the
+ * current and minimum-ever free heap as CSV sections.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_mem_register_commands();
@@ -0,0 +1,381 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <esp_system.h>
+#include <nvs.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include <app_persist.h>
+#include <app_mem.h>
+
+#define PERSIST_NVS_NAMESPACE   "storage"
+#define PERSIST_COMMISSIONED_KEY "commissioned"
+#define PERSIST_FANS_KEY        "fans"
+#define PERSIST_CURVE_KEY       "curve%u"
+
+#define PERSIST_TASK_STACK_SIZE 3072
+#define PERSIST_TASK_PRIORITY   1
+
+/* A failed write is retried after 2, 4, 8 and 16 debounce periods, then only on the next change */
+#define PERSIST_RETRY_LIMIT     5
+
+/* How long a restart waits for a write of the persist task to finish before it flushes the rest */
+#define PERSIST_SHUTDOWN_WAIT_MS 1000
+
+#define PERSIST_RTC_MAGIC       0x46414e53  /* "FANS" */
+
+#define PERSIST_DIRTY_COMMISSIONED  (1 << 0)
+#define PERSIST_DIRTY_FANS          (1 << 1)
+#define PERSIST_DIRTY_CURVE(fan)    (1 << (8 + (fan)))
+
+/* RAM copy of everything kept in NVS. All fans are stored as one blob, so a change of several fans costs a
+   single write. */
+typedef struct {
+    uint8_t valid;          /* bit per fan with a stored state */
+    app_persist_fan_t fans[APP_PERSIST_MAX_FANS];
+} persist_fans_t;
+
+/* commissioned and fans are guarded by s_lock and copied whole. The curves are too large to copy in a critical
+   section, they are guarded by s_mutex and written to NVS straight from here. */
+typedef struct {
+    uint8_t commissioned;
+    persist_fans_t fans;
+    uint8_t curves_valid;   /* bit per fan with a calibrated curve, every curve is a blob of its own */
+    app_fan_curve_t curves[APP_PERSIST_MAX_FANS];
+} persist_state_t;
+
+/* Copy of the fan state and the commissioning status in RTC memory. It survives software resets, watchdog and
+   brownout resets, and is written synchronously on every change, so it is never older than the write-behind copy
+   in NVS. It is only trusted after a crash-class reset: esp_restart() flushes the pending writes from the shutdown
+   handler, and a factory reset must not bring back the state it just erased. */
+typedef struct {
+    uint32_t magic;
+    uint8_t commissioned;
+    persist_fans_t fans;
+    uint32_t crc;
+} persist_rtc_mirror_t;
+
+static const char *TAG = "app_persist";
+static RTC_NOINIT_ATTR persist_rtc_mirror_t s_rtc_mirror;
+static persist_state_t s_state;
+static bool s_loaded;
+static uint32_t s_dirty;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t s_persist_task;
+/* Held while the state is written to NVS, so the shutdown handler does not race the persist task, and while
+   the curves are accessed */
+static SemaphoreHandle_t s_mutex;
+static StaticSemaphore_t s_mutex_buffer;
+
+static uint32_t rtc_mirror_crc(const persist_rtc_mirror_t *mirror)
+{
+    uint32_t crc = esp_rom_crc32_le(0, &mirror->commissioned, sizeof(mirror->commissioned));
+    return esp_rom_crc32_le(crc, (const uint8_t *)&mirror->fans, sizeof(mirror->fans));
+}
+
+/* Called with s_lock held, or from persist_load() before any other task uses the store */
+static void rtc_mirror_update()
+{
+    s_rtc_mirror.magic = PERSIST_RTC_MAGIC;
+    s_rtc_mirror.commissioned = s_state.commissioned;
+    s_rtc_mirror.fans = s_state.fans;
+    s_rtc_mirror.crc = rtc_mirror_crc(&s_rtc_mirror);
+}
+
+/* Resets that may have cut off a pending write-behind */
+static bool rtc_mirror_trusted()
+{
+    switch (esp_reset_reason()) {
+    case ESP_RST_PANIC:
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+    case ESP_RST_BROWNOUT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void persist_load()
+{
+    if (s_loaded) {
+        return;
+    }
+    s_loaded = true;
+    s_mutex = xSemaphoreCreateMutexStatic(&s_mutex_buffer);
+
+    nvs_handle_t handle;
+    if (nvs_open(PERSIST_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        nvs_get_u8(handle, PERSIST_COMMISSIONED_KEY, &s_state.commissioned);
+        size_t length = sizeof(s_state.fans);
+        if (nvs_get_blob(handle, PERSIST_FANS_KEY, &s_state.fans, &length) != ESP_OK ||
+            length != sizeof(s_state.fans)) {
+            memset(&s_state.fans, 0, sizeof(s_state.fans));
+        }
+        for (size_t i = 0; i < APP_PERSIST_MAX_FANS; i++) {
+            char key[sizeof(PERSIST_CURVE_KEY)];
+            snprintf(key, sizeof(key), PERSIST_CURVE_KEY, (unsigned)i);
+            length = sizeof(s_state.curves[i]);
+            if (nvs_get_blob(handle, key, &s_state.curves[i], &length) == ESP_OK &&
+                length == sizeof(s_state.curves[i])) {
+                s_state.curves_valid |= (1u << i);
+            }
+        }
+        nvs_close(handle);
+    } else {
+        ESP_LOGW(TAG, "Failed to open NVS for reading");
+    }
+
+    if (rtc_mirror_trusted() && s_rtc_mirror.magic == PERSIST_RTC_MAGIC &&
+        s_rtc_mirror.crc == rtc_mirror_crc(&s_rtc_mirror)) {
+        /* A change that did not reach NVS before the reset is only in the mirror */
+        if (s_state.commissioned != s_rtc_mirror.commissioned) {
+            s_state.commissioned = s_rtc_mirror.commissioned;
+            s_dirty |= PERSIST_DIRTY_COMMISSIONED;
+        }
+        if (memcmp(&s_state.fans, &s_rtc_mirror.fans, sizeof(s_state.fans)) != 0) {
+            s_state.fans = s_rtc_mirror.fans;
+            s_dirty |= PERSIST_DIRTY_FANS;
+        }
+    } else {
+        rtc_mirror_update();
+    }
+}
+
+/* Called with s_lock held */
+static void mark_dirty(uint32_t dirty)
+{
+    s_dirty |= dirty;
+}
+
+static void wake_persist_task()
+{
+    if (s_persist_task) {
+        xTaskNotifyGive(s_persist_task);
+    }
+}
+
+/* Called with s_mutex held. commissioned and fans are a copy taken with s_lock held, the curves are read from
+   s_state. */
+static esp_err_t persist_write(uint8_t commissioned, const persist_fans_t *fans, uint32_t dirty)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(PERSIST_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (dirty & PERSIST_DIRTY_COMMISSIONED) {
+        err = nvs_set_u8(handle, PERSIST_COMMISSIONED_KEY, commissioned);
+    }
+    if (err == ESP_OK && (dirty & PERSIST_DIRTY_FANS)) {
+        err = nvs_set_blob(handle, PERSIST_FANS_KEY, fans, sizeof(*fans));
+    }
+    for (size_t i = 0; err == ESP_OK && i < APP_PERSIST_MAX_FANS; i++) {
+        if (dirty & PERSIST_DIRTY_CURVE(i)) {
+            char key[sizeof(PERSIST_CURVE_KEY)];
+            snprintf(key, sizeof(key), PERSIST_CURVE_KEY, (unsigned)i);
+            err = nvs_set_blob(handle, key, &s_state.curves[i], sizeof(s_state.curves[i]));
+        }
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return err;
+}
+
+/* Writes what is dirty, called with s_mutex held. Returns the dirty bits that were written or failed. */
+static uint32_t persist_flush(esp_err_t *err)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint32_t dirty = s_dirty;
+    s_dirty = 0;
+    uint8_t commissioned = s_state.commissioned;
+    persist_fans_t fans = s_state.fans;
+    portEXIT_CRITICAL(&s_lock);
+    *err = dirty ? persist_write(commissioned, &fans, dirty) : ESP_OK;
+    if (*err != ESP_OK) {
+        portENTER_CRITICAL(&s_lock);
+        s_dirty |= dirty;
+        portEXIT_CRITICAL(&s_lock);
+    }
+    return dirty;
+}
+
+/* esp_restart() runs this before the reset, so an OTA, console or Matter reboot does not lose the changes of the
+   last debounce period */
+static void persist_shutdown()
+{
+    if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(PERSIST_SHUTDOWN_WAIT_MS)) != pdTRUE) {
+        return;
+    }
+    /* The namespace is gone after a factory reset erased NVS, the state must not come back into it */
+    nvs_handle_t handle;
+    if (nvs_open(PERSIST_NVS_NAMESPACE, NVS_READONLY, &handle) == ESP_OK) {
+        nvs_close(handle);
+        esp_err_t err;
+        if (persist_flush(&err) && err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to write state before the restart: %s", esp_err_to_name(err));
+        }
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+static void persist_task(void *arg)
+{
+    uint32_t failures = 0;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        /* Debounce: wait until the changes stop, but never hold them back longer than the maximum delay */
+        TickType_t first = xTaskGetTickCount();
+        while (xTaskGetTickCount() - first < pdMS_TO_TICKS(CONFIG_APP_PERSIST_MAX_DELAY_MS) &&
+               ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_APP_PERSIST_DEBOUNCE_MS)) > 0) {
+        }
+
+        esp_err_t err;
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        uint32_t dirty = persist_flush(&err);
+        xSemaphoreGive(s_mutex);
+        if (!dirty) {
+            continue;
+        }
+        if (err == ESP_OK) {
+            failures = 0;
+            continue;
+        }
+        ESP_LOGE(TAG, "Failed to write state: %s", esp_err_to_name(err));
+        if (++failures >= PERSIST_RETRY_LIMIT) {
+            /* A full or corrupted NVS must not keep the flash and this task busy, the next change tries again */
+            ESP_LOGE(TAG, "Giving up after %d attempts, the state is kept in RAM", (int)failures);
+            failures = 0;
+            continue;
+        }
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_APP_PERSIST_DEBOUNCE_MS) << failures);
+        xTaskNotifyGive(s_persist_task);
+    }
+}
+
+esp_err_t app_persist_init()
+{
+    persist_load();
+    BaseType_t created = xTaskCreate(persist_task, "persist", PERSIST_TASK_STACK_SIZE, NULL, PERSIST_TASK_PRIORITY,
+                                     &s_persist_task);
+    if (created != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    app_mem_register_task(s_persist_task, PERSIST_TASK_STACK_SIZE);
+    esp_err_t err = esp_register_shutdown_handler(persist_shutdown);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Pending changes are lost on restart, no shutdown handler: %s", esp_err_to_name(err));
+    }
+    if (s_dirty) {
+        wake_persist_task();
+    }
+    return ESP_OK;
+}
+
+bool app_persist_get_commissioned()
+{
+    persist_load();
+    return s_state.commissioned == 1;
+}
+
+void app_persist_set_commissioned(bool commissioned)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool changed = s_state.commissioned != (commissioned ? 1 : 0);
+    if (changed) {
+        s_state.commissioned = commissioned ? 1 : 0;
+        rtc_mirror_update();
+        mark_dirty(PERSIST_DIRTY_COMMISSIONED);
+    }
+    portEXIT_CRITICAL(&s_lock);
+    if (changed) {
+        wake_persist_task();
+    }
+}
+
+void app_persist_invalidate_mirror()
+{
+    portENTER_CRITICAL(&s_lock);
+    s_rtc_mirror.magic = 0;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t app_persist_get_fan(size_t fan_index, app_persist_fan_t *state)
+{
+    if (fan_index >= APP_PERSIST_MAX_FANS || !state) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    persist_load();
+    portENTER_CRITICAL(&s_lock);
+    bool valid = s_state.fans.valid & (1u << fan_index);
+    *state = s_state.fans.fans[fan_index];
+    portEXIT_CRITICAL(&s_lock);
+    return valid ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+void app_persist_set_fan(size_t fan_index, uint8_t fan_mode, uint8_t percent)
+{
+    if (fan_index >= APP_PERSIST_MAX_FANS) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    app_persist_fan_t *fan = &s_state.fans.fans[fan_index];
+    bool changed = !(s_state.fans.valid & (1u << fan_index)) || fan->fan_mode != fan_mode || fan->percent != percent;
+    if (changed) {
+        fan->fan_mode = fan_mode;
+        fan->percent = percent;
+        s_state.fans.valid |= (1u << fan_index);
+        rtc_mirror_update();
+        mark_dirty(PERSIST_DIRTY_FANS);
+    }
+    portEXIT_CRITICAL(&s_lock);
+    if (changed) {
+        wake_persist_task();
+    }
+}
+
+esp_err_t app_persist_get_curve(size_t fan_index, app_fan_curve_t *curve)
+{
+    if (fan_index >= APP_PERSIST_MAX_FANS || !curve) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    persist_load();
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool valid = s_state.curves_valid & (1u << fan_index);
+    *curve = s_state.curves[fan_index];
+    xSemaphoreGive(s_mutex);
+    return valid ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+void app_persist_set_curve(size_t fan_index, const app_fan_curve_t *curve)
+{
+    if (fan_index >= APP_PERSIST_MAX_FANS || !curve) {
+        return;
+    }
+    persist_load();
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    s_state.curves[fan_index] = *curve;
+    s_state.curves_valid |= (1u << fan_index);
+    xSemaphoreGive(s_mutex);
+    portENTER_CRITICAL(&s_lock);
+    mark_dirty(PERSIST_DIRTY_CURVE(fan_index));
+    portEXIT_CRITICAL(&s_lock);
+    wake_persist_task();
+}
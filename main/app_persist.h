@@ -0,0 +1,80 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+
+#include <app_fan_curve.h>
+
+#define APP_PERSIST_MAX_FANS 8
+
+/* Persisted state of one fan */
+typedef struct {
+    uint8_t fan_mode;
+    uint8_t percent;
+} app_persist_fan_t;
+
+/** Initialize the persistent state store
+ *
+ * Loads the state from the `storage` NVS namespace into RAM and starts the write-behind task. Setters
+ * only update the RAM copy and mark it dirty, the task writes all dirty entries with one commit once no
+ * change arrived for `CONFIG_APP_PERSIST_DEBOUNCE_MS`, or at the latest after
+ * `CONFIG_APP_PERSIST_MAX_DELAY_MS`. A failed write is retried with an exponential backoff and given up
+ * after a few attempts until the next change arrives. Pending changes are written synchronously when
+ * `esp_restart()` is called. The fan state and the commissioning status are additionally mirrored in RTC
+ * memory on every change, after a panic, watchdog or brownout reset the mirror takes precedence over NVS.
+ *
+ * The getters load the state on first use, so they can be called before this. This must be called
+ * after `nvs_flash_init()`.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_persist_init();
+
+bool app_persist_get_commissioned();
+
+/** Record the commissioning state, safe to call from the CHIP thread */
+void app_persist_set_commissioned(bool commissioned);
+
+/** Drop the RTC memory copy of the fan state and the commissioning status
+ *
+ * Must be called before a factory reset, the restart that follows would otherwise restore the fan state
+ * from RTC memory into the erased NVS.
+ */
+void app_persist_invalidate_mirror();
+
+/** Persisted state of a fan
+ *
+ * @param[in] fan_index Bank channel of the fan.
+ * @param[out] state Fan state.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_FOUND if nothing was stored for the fan yet.
+ */
+esp_err_t app_persist_get_fan(size_t fan_index, app_persist_fan_t *state);
+
+/** Record the state of a fan, safe to call from the CHIP thread */
+void app_persist_set_fan(size_t fan_index, uint8_t fan_mode, uint8_t percent);
+
+/** Calibrated duty curve of a fan
+ *
+ * @param[in] fan_index Bank channel of the fan.
+ * @param[out] curve Curve of the fan.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_FOUND if the fan was not calibrated yet.
+ */
+esp_err_t app_persist_get_curve(size_t fan_index, app_fan_curve_t *curve);
+
+/** Record the calibrated duty curve of a fan, safe to call from any task */
+void app_persist_set_curve(size_t fan_index, const app_fan_curve_t *curve);
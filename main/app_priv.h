@@ -11,18 +11,12 @@
 #include <esp_err.h>
 #include <esp_matter.h>
 #include "driver/gpio.h"
+#include "app_fan_mode.h"
 
 #if CHIP_DEVICE_CONFIG_ENABLE_THREAD
 #include "esp_openthread_types.h"
 #endif
 
-#define FAN_MODE_SEQUEBCE_VALUE 2
-#define LOW_MODE_PERCENT_MIN 1
-#define LOW_MODE_PERCENT_MAX 33
-#define MED_MODE_PERCENT_MIN 34
-#define MED_MODE_PERCENT_MAX 66
-#define HIGH_MODE_PERCENT_MIN 67
-#define HIGH_MODE_PERCENT_MAX 100
 
 typedef void *app_driver_handle_t;
 
@@ -37,6 +31,96 @@ typedef void *app_driver_handle_t;
 app_driver_handle_t app_driver_fan_init();
 
 app_driver_handle_t app_driver_button_init(gpio_num_t * reset_gpio);
+
+/** Register the local fan control gestures on a button
+ *
+ * A single click steps the selected fan through Off, Low, Medium and High, a double click selects the
+ * next fan and pulses it. The PWM follows a click without a round trip through the CHIP thread, so local
+ * control works even without network. FanMode and PercentSetting are then updated through the data
+ * model, so subscribers see the change.
+ *
+ * @param[in] button_handle Handle returned by `app_driver_button_init()`.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_driver_button_register_local_control(app_driver_handle_t button_handle);
+
+/** Bind a fan endpoint to the driver
+ *
+ * Resolves the FanControl attribute handles of the endpoint once, so the attribute update path
+ * does not have to look up node, endpoint, cluster and attribute on every write.
+ * Attribute updates of the endpoint are then dispatched to the fan through a table indexed by endpoint ID.
+ * This must be called after the endpoint has been created and before `esp_matter::start()`.
+ *
+ * @param[in] driver_handle Handle returned by `app_driver_fan_init()`.
+ * @param[in] fan_index Index of the fan in `k_fan_endpoints`.
+ * @param[in] endpoint_id Endpoint ID of the fan.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_driver_fan_bind_endpoint(app_driver_handle_t driver_handle, size_t fan_index, uint16_t endpoint_id);
+
+/** Set the slew rate of a fan
+ *
+ * Speed changes of the fan are ramped by the LEDC fade unit at this rate. A new target that arrives
+ * while a ramp is running retargets the ramp from the current duty.
+ *
+ * @param[in] driver_handle Handle returned by `app_driver_fan_init()`.
+ * @param[in] endpoint_id Endpoint ID of the fan.
+ * @param[in] percent_per_sec Slew rate in percent per second, 0 applies new speeds at once.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_driver_fan_set_slew_rate(app_driver_handle_t driver_handle, uint16_t endpoint_id,
+                                       uint32_t percent_per_sec);
+
+/** Pulse a fan so the physical unit can be found
+ *
+ * The fan jumps to `CONFIG_FAN_IDENTIFY_PULSE_PERCENT` for `CONFIG_FAN_IDENTIFY_PULSE_MS`, or stops for
+ * that time if it already runs at that speed, and then returns to its current speed. Speed changes
+ * that arrive during the pulse take effect when it ends.
+ *
+ * @param[in] driver_handle Handle returned by `app_driver_fan_init()`.
+ * @param[in] endpoint_id Endpoint ID of the fan.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_FOUND if the endpoint is not a fan.
+ * @return error in case of failure.
+ */
+esp_err_t app_driver_fan_identify_pulse(app_driver_handle_t driver_handle, uint16_t endpoint_id);
+
+/** Calibrate the duty curve of a fan
+ *
+ * Sweeps the duty of the fan down from full speed and records the measured speed of every step, then finds
+ * the lowest duty that starts it from standstill. The 101 entry percent to duty table built from the sweep is
+ * stored in NVS and used for every later speed change. A fan that stands still and would get less than its
+ * start duty is kick-started at the start duty for `CONFIG_FAN_KICK_MS`. The sweep takes about a minute with
+ * the default tach window, speed changes that arrive meanwhile take effect when it ends. Must be called on
+ * the CHIP thread.
+ *
+ * @param[in] driver_handle Handle returned by `app_driver_fan_init()`.
+ * @param[in] endpoint_id Endpoint ID of the fan.
+ * @param[in] force Calibrate even if the fan already has a curve.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_NOT_FOUND if the endpoint is not a fan.
+ * @return ESP_ERR_NOT_SUPPORTED without `CONFIG_FAN_CALIBRATION`.
+ */
+esp_err_t app_driver_fan_calibrate(app_driver_handle_t driver_handle, uint16_t endpoint_id, bool force);
+
+/** Register the `curve` console command
+ *
+ * `matter esp curve calibrate <endpoint>|all` calibrates fans, `matter esp curve dump <endpoint>` prints the
+ * duty table of a fan and the samples of its last sweep.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_driver_fan_register_commands();
+
 /** Driver Update
  *
  * This API should be called to update the driver for the attribute being updated.
@@ -53,6 +137,21 @@ app_driver_handle_t app_driver_button_init(gpio_num_t * reset_gpio);
 esp_err_t app_driver_attribute_update(app_driver_handle_t driver_handle, uint16_t endpoint_id, uint32_t cluster_id,
                                       uint32_t attribute_id, esp_matter_attr_val_t *val);
 
+/** Feed the temperature input of the Auto fan mode
+ *
+ * All fans in FanMode Auto follow the temperature curve configured in `Fan Configurations`. The
+ * curve is only re-evaluated when the temperature moves by more than the hysteresis band.
+ * Updates of TemperatureMeasurement::MeasuredValue on any endpoint are fed in by
+ * `app_driver_attribute_update()`, other sources such as a value bound from another node can call
+ * this directly. Must be called with the CHIP stack lock held.
+ *
+ * @param[in] temperature Temperature in 0.01 °C.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_driver_fan_auto_temperature(int16_t temperature);
+
 #if CHIP_DEVICE_CONFIG_ENABLE_THREAD
 #define ESP_OPENTHREAD_DEFAULT_RADIO_CONFIG()                                           \
     {                                                                                   \
@@ -69,15 +168,3 @@ esp_err_t app_driver_attribute_update(app_driver_handle_t driver_handle, uint16_
         .storage_partition_name = "nvs", .netif_queue_size = 10, .task_queue_size = 10, \
     }
 #endif
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-// Deklaration der Funktion led_init
-void led_init(void);
-
-#ifdef __cplusplus
-}
-#endif
-
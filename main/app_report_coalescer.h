@@ -0,0 +1,50 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t min_delta;          /* changes of at least this size are reported once min_interval_ms has passed */
+    uint32_t min_interval_ms;   /* no two reports are closer than this */
+    uint32_t max_interval_ms;   /* smaller changes are reported after this time */
+} app_report_coalescer_config_t;
+
+typedef struct {
+    uint8_t reported;
+    uint32_t last_report_ms;
+} app_report_coalescer_t;
+
+/** Decide whether a sampled value is reported
+ *
+ * A value that differs from the last report is reported if the minimum interval has passed and it either moved by
+ * at least `min_delta`, has settled on its final value, or has been held back for `max_interval_ms`.
+ *
+ * @return true if `value` must be reported, it is then taken as the last reported value.
+ */
+static inline bool app_report_coalescer_update(const app_report_coalescer_config_t *config,
+                                               app_report_coalescer_t *state, uint8_t value, bool settled,
+                                               uint32_t now_ms)
+{
+    if (value == state->reported) {
+        return false;
+    }
+    uint32_t elapsed = now_ms - state->last_report_ms;
+    if (elapsed < config->min_interval_ms) {
+        return false;
+    }
+    uint8_t delta = value > state->reported ? value - state->reported : state->reported - value;
+    if (delta < config->min_delta && !settled && elapsed < config->max_interval_ms) {
+        return false;
+    }
+    state->reported = value;
+    state->last_report_ms = now_ms;
+    return true;
+}
@@ -2,6 +2,8 @@
 #include <esp_log.h>
 #include <esp_matter.h>
 #include "iot_button.h"
+#include <app_identify.h>
+#include <app_persist.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/gpio.h"
@@ -17,7 +19,7 @@ static void button_factory_reset_pressed_cb(void *arg, void *data)
         perform_factory_reset = true;
 
         // LED zum leuchten bringen
-        gpio_set_level((gpio_num_t)CONFIG_LED_PIN, 1);
+        app_identify_set_factory_reset(true);
     }
 }
 
@@ -26,12 +28,12 @@ static void button_factory_reset_released_cb(void *arg, void *data)
     if (perform_factory_reset) {
         ESP_LOGI(TAG, "Starting factory reset");
 
-        // LED zum leuchten bringen
-        gpio_set_level((gpio_num_t)CONFIG_LED_PIN, 0);
+        // LED ausschalten
+        app_identify_set_factory_reset(false);
 
         commissioned = false;
         save_commissioned_status(commissioned);
-
+        app_persist_invalidate_mirror();
 
         esp_matter::factory_reset();
         perform_factory_reset = false;
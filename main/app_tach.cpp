@@ -0,0 +1,194 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <string.h>
+
+#include <app_tach.h>
+
+#if CONFIG_FAN_TACH_ENABLE
+
+#if CONFIG_FAN_TACH_SOURCE_PCNT
+#include "driver/pulse_cnt.h"
+#include "soc/soc_caps.h"
+
+/* The counter wraps to 0 at this limit, pulses are taken as the difference between two reads so no pulse is
+   lost by clearing the counter */
+#define TACH_PCNT_HIGH_LIMIT    32767
+#define TACH_PCNT_GLITCH_NS     1000
+
+/* Every fan needs a PCNT unit of its own, e.g. the ESP32-C6 only has 4 */
+static_assert(CONFIG_FAN_COUNT <= SOC_PCNT_UNITS_PER_GROUP * SOC_PCNT_GROUPS,
+              "CONFIG_FAN_COUNT exceeds the PCNT units of the target, use fewer fans or the simulated tach source");
+#endif
+
+#define TACH_SIM_TIME_CONSTANT_MS 2000
+
+typedef struct {
+#if CONFIG_FAN_TACH_SOURCE_PCNT
+    pcnt_unit_handle_t unit;
+    int last_count;
+#else
+    uint32_t sim_rpm;
+    uint32_t sim_pulse_residual;    /* fraction of a pulse carried to the next window, in 1/60000 pulses */
+#endif
+    uint32_t rpm;
+} tach_channel_t;
+
+static const char *TAG = "app_tach";
+static tach_channel_t s_channels[APP_TACH_MAX_FANS];
+static app_tach_config_t s_config;
+static esp_timer_handle_t s_window_timer;
+
+#if CONFIG_FAN_TACH_SOURCE_PCNT
+static esp_err_t tach_channel_init(tach_channel_t *channel, gpio_num_t gpio)
+{
+    pcnt_unit_config_t unit_config = {
+        .low_limit = -1,
+        .high_limit = TACH_PCNT_HIGH_LIMIT,
+    };
+    esp_err_t err = pcnt_new_unit(&unit_config, &channel->unit);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    pcnt_glitch_filter_config_t filter_config = {
+        .max_glitch_ns = TACH_PCNT_GLITCH_NS,
+    };
+    err = pcnt_unit_set_glitch_filter(channel->unit, &filter_config);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    pcnt_chan_config_t chan_config = {
+        .edge_gpio_num = gpio,
+        .level_gpio_num = -1,
+    };
+    pcnt_channel_handle_t pcnt_channel = NULL;
+    err = pcnt_new_channel(channel->unit, &chan_config, &pcnt_channel);
+    if (err != ESP_OK) {
+        return err;
+    }
+    /* Tach outputs are open collector, count falling edges only */
+    err = pcnt_channel_set_edge_action(pcnt_channel, PCNT_CHANNEL_EDGE_ACTION_HOLD,
+                                       PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+    if (err != ESP_OK) {
+        return err;
+    }
+    gpio_pullup_en(gpio);
+
+    err = pcnt_unit_enable(channel->unit);
+    if (err == ESP_OK) {
+        err = pcnt_unit_clear_count(channel->unit);
+    }
+    if (err == ESP_OK) {
+        err = pcnt_unit_start(channel->unit);
+    }
+    return err;
+}
+
+static uint32_t tach_channel_read_pulses(size_t fan_index, tach_channel_t *channel)
+{
+    int count = 0;
+    pcnt_unit_get_count(channel->unit, &count);
+    int pulses = count - channel->last_count;
+    if (pulses < 0) {
+        pulses += TACH_PCNT_HIGH_LIMIT;
+    }
+    channel->last_count = count;
+    return (uint32_t)pulses;
+}
+#else
+static esp_err_t tach_channel_init(tach_channel_t *channel, gpio_num_t gpio)
+{
+    return ESP_OK;
+}
+
+/* First order fan model: the speed follows the duty with a time constant of TACH_SIM_TIME_CONSTANT_MS */
+static uint32_t tach_channel_read_pulses(size_t fan_index, tach_channel_t *channel)
+{
+    uint32_t duty_permille = s_config.get_duty_permille ? s_config.get_duty_permille(fan_index) : 0;
+    uint32_t target_rpm = (duty_permille * CONFIG_FAN_MAX_RPM) / 1000;
+    int32_t delta = (int32_t)target_rpm - (int32_t)channel->sim_rpm;
+    int32_t step = (delta * CONFIG_FAN_TACH_WINDOW_MS) / (TACH_SIM_TIME_CONSTANT_MS + CONFIG_FAN_TACH_WINDOW_MS);
+    /* The truncated step would stop short of the target, a stopped fan would keep spinning at a few RPM */
+    channel->sim_rpm += step != 0 ? step : delta;
+
+    uint32_t scaled = channel->sim_rpm * CONFIG_FAN_TACH_PULSES_PER_REV * CONFIG_FAN_TACH_WINDOW_MS +
+                      channel->sim_pulse_residual;
+    channel->sim_pulse_residual = scaled % 60000;
+    return scaled / 60000;
+}
+#endif
+
+static void tach_window_cb(void *arg)
+{
+    for (size_t i = 0; i < s_config.fan_count; i++) {
+        uint32_t pulses = tach_channel_read_pulses(i, &s_channels[i]);
+        uint32_t rpm = app_tach_pulses_to_rpm(pulses, CONFIG_FAN_TACH_PULSES_PER_REV, CONFIG_FAN_TACH_WINDOW_MS);
+        s_channels[i].rpm = app_tach_filter_rpm(s_channels[i].rpm, rpm);
+    }
+    if (s_config.window_cb) {
+        s_config.window_cb(s_config.window_cb_arg);
+    }
+}
+
+esp_err_t app_tach_init(const app_tach_config_t *config)
+{
+    if (!config || config->fan_count > APP_TACH_MAX_FANS) {
+        ESP_LOGE(TAG, "Invalid tach config");
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_config = *config;
+    memset(s_channels, 0, sizeof(s_channels));
+
+    for (size_t i = 0; i < s_config.fan_count; i++) {
+        gpio_num_t gpio = s_config.gpios ? s_config.gpios[i] : GPIO_NUM_NC;
+        esp_err_t err = tach_channel_init(&s_channels[i], gpio);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to init tach of fan %d: %s", (int)i, esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    esp_timer_create_args_t timer_args = {
+        .callback = tach_window_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "tach_window",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &s_window_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return esp_timer_start_periodic(s_window_timer, CONFIG_FAN_TACH_WINDOW_MS * 1000);
+}
+
+uint32_t app_tach_get_rpm(size_t fan_index)
+{
+    if (fan_index >= s_config.fan_count) {
+        return 0;
+    }
+    return s_channels[fan_index].rpm;
+}
+
+#else
+
+esp_err_t app_tach_init(const app_tach_config_t *config)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+uint32_t app_tach_get_rpm(size_t fan_index)
+{
+    return 0;
+}
+
+#endif // CONFIG_FAN_TACH_ENABLE
@@ -0,0 +1,63 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+#include "driver/gpio.h"
+
+#define APP_TACH_MAX_FANS 8
+
+/** Returns the duty of a fan in permille, used by the simulated tach source */
+typedef uint32_t (*app_tach_duty_fn_t)(size_t fan_index);
+
+/** Called from the esp_timer task after every measurement window */
+typedef void (*app_tach_window_cb_t)(void *arg);
+
+typedef struct {
+    const gpio_num_t *gpios;            /* tach input per fan, unused by the simulated source */
+    size_t fan_count;
+    app_tach_duty_fn_t get_duty_permille;
+    app_tach_window_cb_t window_cb;
+    void *window_cb_arg;
+} app_tach_config_t;
+
+/** Initialize the tachometer capture
+ *
+ * Counts the tach pulses of every fan with a PCNT unit, or with the simulated source if
+ * `CONFIG_FAN_TACH_SOURCE_SIMULATED` is set, and converts them to a filtered RPM value once
+ * per `CONFIG_FAN_TACH_WINDOW_MS`.
+ *
+ * @param[in] config Tach configuration.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_tach_init(const app_tach_config_t *config);
+
+/** Filtered fan speed of the last measurement window in RPM */
+uint32_t app_tach_get_rpm(size_t fan_index);
+
+/** Convert a number of tach pulses counted in a window to RPM */
+static inline uint32_t app_tach_pulses_to_rpm(uint32_t pulses, uint32_t pulses_per_rev, uint32_t window_ms)
+{
+    return (uint32_t)(((uint64_t)pulses * 60000) / ((uint64_t)pulses_per_rev * window_ms));
+}
+
+/** Exponential moving average with a weight of 1/4 for the new sample, settles exactly on a constant input */
+static inline uint32_t app_tach_filter_rpm(uint32_t filtered, uint32_t sample)
+{
+    int32_t delta = (int32_t)sample - (int32_t)filtered;
+    if (delta > -4 && delta < 4) {
+        return sample;
+    }
+    return (uint32_t)((int32_t)filtered + delta / 4);
+}
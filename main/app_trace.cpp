@@ -0,0 +1,119 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+#include <esp_log.h>
+#include <esp_matter_console.h>
+#include <esp_timer.h>
+
+#include <app_trace.h>
+
+static const char *TAG = "app_trace";
+
+#if CONFIG_APP_TRACE_ENABLE
+
+static_assert(sizeof(app_trace_event_t) == 24, "Trace events must stay fixed size");
+static_assert((CONFIG_APP_TRACE_EVENT_COUNT & (CONFIG_APP_TRACE_EVENT_COUNT - 1)) == 0,
+              "Trace ring size must be a power of two");
+
+static app_trace_event_t s_events[CONFIG_APP_TRACE_EVENT_COUNT];
+/* Total number of events ever recorded, writers claim their slot with one atomic increment */
+static std::atomic<uint32_t> s_recorded{0};
+
+void app_trace_record(app_trace_event_type_t type, uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id,
+                      uint32_t old_value, uint32_t new_value)
+{
+    uint32_t index = s_recorded.fetch_add(1, std::memory_order_relaxed) & (CONFIG_APP_TRACE_EVENT_COUNT - 1);
+    app_trace_event_t *event = &s_events[index];
+    event->timestamp_us = (uint32_t)esp_timer_get_time();
+    event->cluster_id = cluster_id;
+    event->attribute_id = attribute_id;
+    event->old_value = old_value;
+    event->new_value = new_value;
+    event->endpoint_id = endpoint_id;
+    event->type = type;
+}
+
+#if CONFIG_ENABLE_CHIP_SHELL
+static const char *event_name(uint8_t type)
+{
+    switch (type) {
+    case APP_TRACE_ATTRIBUTE_WRITE:
+        return "write";
+    case APP_TRACE_RECONCILE:
+        return "reconcile";
+    case APP_TRACE_FAN_APPLY:
+        return "fan_apply";
+    case APP_TRACE_AUTO_RECOMPUTE:
+        return "auto";
+    case APP_TRACE_COMMAND_DROPPED:
+        return "dropped";
+    default:
+        return "unknown";
+    }
+}
+
+static void trace_dump()
+{
+    uint32_t recorded = s_recorded.load(std::memory_order_relaxed);
+    uint32_t count = recorded < CONFIG_APP_TRACE_EVENT_COUNT ? recorded : CONFIG_APP_TRACE_EVENT_COUNT;
+    printf("timestamp_us,event,endpoint,cluster,attribute,old,new\n");
+    for (uint32_t i = recorded - count; i != recorded; i++) {
+        const app_trace_event_t *event = &s_events[i & (CONFIG_APP_TRACE_EVENT_COUNT - 1)];
+        printf("%lu,%s,%u,0x%08lx,0x%08lx,%lu,%lu\n", event->timestamp_us, event_name(event->type),
+               event->endpoint_id, event->cluster_id, event->attribute_id, event->old_value, event->new_value);
+    }
+    printf("%lu events recorded, %lu shown\n", recorded, count);
+}
+
+static esp_err_t trace_command_handler(int argc, char **argv)
+{
+    if (argc == 1 && strcmp(argv[0], "dump") == 0) {
+        trace_dump();
+        return ESP_OK;
+    }
+    if (argc == 1 && strcmp(argv[0], "clear") == 0) {
+        s_recorded.store(0, std::memory_order_relaxed);
+        memset(s_events, 0, sizeof(s_events));
+        return ESP_OK;
+    }
+    ESP_LOGE(TAG, "Usage: trace dump|clear");
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t app_trace_register_commands()
+{
+    static const esp_matter::console::command_t command = {
+        .name = "trace",
+        .description = "Attribute update trace. Usage: matter esp trace dump|clear",
+        .handler = trace_command_handler,
+    };
+    return esp_matter::console::add_commands(&command, 1);
+}
+
+#else
+
+esp_err_t app_trace_register_commands()
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_ENABLE_CHIP_SHELL
+
+#else
+
+esp_err_t app_trace_register_commands()
+{
+    ESP_LOGW(TAG, "Tracing is disabled");
+    return ESP_OK;
+}
+
+#endif // CONFIG_APP_TRACE_ENABLE
@@ -0,0 +1,58 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_err.h>
+
+typedef enum : uint8_t {
+    APP_TRACE_ATTRIBUTE_WRITE = 1,  /* endpoint, cluster, attribute, old and new value of a write */
+    APP_TRACE_RECONCILE,            /* attribute changed by the FanMode/PercentSetting reconciliation */
+    APP_TRACE_FAN_APPLY,            /* endpoint = fan index, old and new target duty */
+    APP_TRACE_AUTO_RECOMPUTE,       /* old = temperature in 0.01 °C, new = percent */
+    APP_TRACE_COMMAND_DROPPED,      /* endpoint = fan index, new = percent */
+} app_trace_event_type_t;
+
+/* Fixed-size binary record, no formatting happens when it is recorded */
+typedef struct {
+    uint32_t timestamp_us;
+    uint32_t cluster_id;
+    uint32_t attribute_id;
+    uint32_t old_value;
+    uint32_t new_value;
+    uint16_t endpoint_id;
+    uint8_t type;
+    uint8_t reserved;
+} app_trace_event_t;
+
+#if CONFIG_APP_TRACE_ENABLE
+
+/** Record an event into the RAM trace ring, the oldest event is overwritten when the ring is full */
+void app_trace_record(app_trace_event_type_t type, uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id,
+                      uint32_t old_value, uint32_t new_value);
+
+#define APP_TRACE(type, endpoint_id, cluster_id, attribute_id, old_value, new_value) \
+    app_trace_record(type, endpoint_id, cluster_id, attribute_id, old_value, new_value)
+
+#else
+
+#define APP_TRACE(type, endpoint_id, cluster_id, attribute_id, old_value, new_value) do { } while (0)
+
+#endif // CONFIG_APP_TRACE_ENABLE
+
+/** Register the `trace` console command
+ *
+ * `matter esp trace dump` prints the recorded events oldest first, one CSV line per event.
+ * `matter esp trace clear` empties the ring.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_trace_register_commands();
@@ -0,0 +1,109 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Benchmark of FanControl attribute access: resolving the handle by walking node -> endpoint -> cluster ->
+ * attribute on every access, as the driver did before app_driver_fan_bind_endpoint(), against the handles cached
+ * once per fan endpoint. Every iteration does the accesses of one PercentSetting write: read PercentSetting and
+ * FanMode, write FanMode and SpeedSetting.
+ *
+ * Usage: bench_attribute_handles [--quick] [--iterations N]
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_node.h"
+
+using namespace chip::app::Clusters;
+using namespace esp_matter;
+
+typedef struct {
+    attribute_t *fan_mode;
+    attribute_t *percent_setting;
+    attribute_t *speed_setting;
+} handles_t;
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static handles_t resolve(uint16_t endpoint_id)
+{
+    return {
+        attribute::get(endpoint_id, FanControl::Id, FanControl::Attributes::FanMode::Id),
+        attribute::get(endpoint_id, FanControl::Id, FanControl::Attributes::PercentSetting::Id),
+        attribute::get(endpoint_id, FanControl::Id, FanControl::Attributes::SpeedSetting::Id),
+    };
+}
+
+static uint32_t write_accesses(const handles_t &handles, uint8_t percent)
+{
+    esp_matter_attr_val_t percent_val = esp_matter_invalid(NULL);
+    esp_matter_attr_val_t mode_val = esp_matter_invalid(NULL);
+    attribute::get_val(handles.percent_setting, &percent_val);
+    attribute::get_val(handles.fan_mode, &mode_val);
+    mode_val.val.u8 = percent > 66 ? 3 : percent > 33 ? 2 : percent > 0 ? 1 : 0;
+    attribute::set_val(handles.fan_mode, &mode_val);
+    esp_matter_attr_val_t speed_val = esp_matter_nullable_uint8(app_fan_percent_to_speed(percent, 10));
+    attribute::set_val(handles.speed_setting, &speed_val);
+    return percent_val.val.u8 + mode_val.val.u8;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 1000000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            iterations = 10000;
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--iterations N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (host_node_init() != ESP_OK) {
+        fprintf(stderr, "Failed to create the node\n");
+        return 1;
+    }
+
+    handles_t cache[CONFIG_FAN_COUNT];
+    for (size_t i = 0; i < CONFIG_FAN_COUNT; i++) {
+        cache[i] = resolve(host_node_fan_endpoint(i));
+        if (!cache[i].fan_mode || !cache[i].percent_setting || !cache[i].speed_setting) {
+            fprintf(stderr, "Endpoint %d has no complete FanControl cluster\n", host_node_fan_endpoint(i));
+            return 1;
+        }
+    }
+
+    volatile uint32_t sink = 0;
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        size_t fan = i % CONFIG_FAN_COUNT;
+        sink += write_accesses(resolve(host_node_fan_endpoint(fan)), (uint8_t)(i % 101));
+    }
+    uint64_t walk_ns = now_ns() - start;
+
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        size_t fan = i % CONFIG_FAN_COUNT;
+        sink += write_accesses(cache[fan], (uint8_t)(i % 101));
+    }
+    uint64_t cache_ns = now_ns() - start;
+
+    printf("%u writes to %d fans, 4 attribute accesses each\n", iterations, CONFIG_FAN_COUNT);
+    printf("walk   %8.2f ns/write\n", (double)walk_ns / iterations);
+    printf("cache  %8.2f ns/write  %.1fx\n", (double)cache_ns / iterations,
+           cache_ns ? (double)walk_ns / cache_ns : 0.0);
+    return 0;
+}
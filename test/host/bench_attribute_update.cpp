@@ -0,0 +1,144 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Benchmark of the attribute write path of main/app_driver.cpp
+ *
+ * Every iteration writes PercentSetting or FanMode of one fan like a Matter client and measures
+ *   - callback: attribute::update() on the CHIP thread, the time a write blocks the Matter event loop
+ *   - commit:   from the write until the driver task has staged and committed the new duty
+ * and counts the heap allocations of both. The write path must not allocate, any allocation fails the run.
+ *
+ * Usage: bench_attribute_update [--quick] [--iterations N]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <platform/CHIPDeviceLayer.h>
+
+#include "host_node.h"
+
+using namespace chip::app::Clusters;
+
+static std::atomic<uint64_t> s_allocations{0};
+
+void *operator new(size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t size) noexcept
+{
+    free(ptr);
+}
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+typedef struct {
+    const char *name;
+    std::vector<uint32_t> latency_ns;
+    uint64_t total_ns;
+    uint64_t allocations;
+} bench_stage_t;
+
+static void print_stage(bench_stage_t *stage, uint32_t iterations)
+{
+    std::sort(stage->latency_ns.begin(), stage->latency_ns.end());
+    double p50 = stage->latency_ns[iterations / 2] / 1000.0;
+    double p99 = stage->latency_ns[(uint64_t)iterations * 99 / 100] / 1000.0;
+    double max = stage->latency_ns.back() / 1000.0;
+    double per_sec = stage->total_ns ? iterations * 1e9 / stage->total_ns : 0;
+    printf("%-8s %10.0f updates/s  %6.3f allocations/update  p50 %8.2f us  p99 %8.2f us  max %8.2f us\n",
+           stage->name, per_sec, (double)stage->allocations / iterations, p50, p99, max);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 200000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            iterations = 2000;
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--iterations N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations < 100) {
+        iterations = 100;
+    }
+    if (host_node_init() != ESP_OK) {
+        fprintf(stderr, "Failed to create the node\n");
+        return 1;
+    }
+
+    bench_stage_t callback = { "callback", std::vector<uint32_t>(iterations), 0, 0 };
+    bench_stage_t commit = { "commit", std::vector<uint32_t>(iterations), 0, 0 };
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        size_t fan = i % CONFIG_FAN_COUNT;
+        /* Mostly PercentSetting writes, every 8th write switches the mode */
+        uint32_t attribute_id = FanControl::Attributes::PercentSetting::Id;
+        esp_matter_attr_val_t val = esp_matter_nullable_uint8((uint8_t)((i * 37) % 101));
+        if (i % 8 == 7) {
+            attribute_id = FanControl::Attributes::FanMode::Id;
+            val = esp_matter_enum8((uint8_t)(i / 8 % 4));
+        }
+
+        uint64_t allocations = s_allocations.load(std::memory_order_relaxed);
+        uint64_t start = now_ns();
+        esp_err_t err = esp_matter::attribute::update(host_node_fan_endpoint(fan), FanControl::Id, attribute_id,
+                                                      &val);
+        uint64_t updated = now_ns();
+        callback.allocations += s_allocations.load(std::memory_order_relaxed) - allocations;
+        host_node_settle();
+        uint64_t committed = now_ns();
+        commit.allocations += s_allocations.load(std::memory_order_relaxed) - allocations;
+
+        errors += err != ESP_OK;
+        callback.latency_ns[i] = (uint32_t)std::min<uint64_t>(updated - start, UINT32_MAX);
+        commit.latency_ns[i] = (uint32_t)std::min<uint64_t>(committed - start, UINT32_MAX);
+        callback.total_ns += updated - start;
+        commit.total_ns += committed - start;
+    }
+
+    printf("%u writes to %d fans\n", iterations, CONFIG_FAN_COUNT);
+    print_stage(&callback, iterations);
+    print_stage(&commit, iterations);
+    if (errors) {
+        fprintf(stderr, "%u writes failed\n", errors);
+        return 1;
+    }
+    if (commit.allocations) {
+        fprintf(stderr, "The write path allocated %llu times\n", (unsigned long long)commit.allocations);
+        return 1;
+    }
+    return 0;
+}
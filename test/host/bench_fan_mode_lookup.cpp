@@ -0,0 +1,133 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Benchmark of the FanMode <-> PercentSetting reconciliation: the table lookups of app_fan_mode.h against the
+ * switch and if-chain the driver used before, for OffLowMedHigh where both agree.
+ *
+ * Usage: bench_fan_mode_lookup [--quick] [--iterations N]
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <app_fan_mode.h>
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static bool switch_mode_percent_match(uint8_t fan_mode, uint8_t percent)
+{
+    switch (fan_mode) {
+    case APP_FAN_MODE_HIGH:
+        return percent >= HIGH_MODE_PERCENT_MIN;
+    case APP_FAN_MODE_MEDIUM:
+        return percent >= MED_MODE_PERCENT_MIN && percent <= MED_MODE_PERCENT_MAX;
+    case APP_FAN_MODE_LOW:
+        return percent >= LOW_MODE_PERCENT_MIN && percent <= LOW_MODE_PERCENT_MAX;
+    default:
+        return false;
+    }
+}
+
+static uint8_t switch_percent_write(uint8_t fan_mode, uint8_t percent)
+{
+    if (switch_mode_percent_match(fan_mode, percent)) {
+        return fan_mode;
+    }
+    if (percent >= HIGH_MODE_PERCENT_MIN) {
+        return APP_FAN_MODE_HIGH;
+    } else if (percent >= MED_MODE_PERCENT_MIN) {
+        return APP_FAN_MODE_MEDIUM;
+    } else if (percent >= LOW_MODE_PERCENT_MIN) {
+        return APP_FAN_MODE_LOW;
+    }
+    return APP_FAN_MODE_OFF;
+}
+
+static uint8_t switch_mode_write(uint8_t fan_mode, uint8_t percent)
+{
+    if (switch_mode_percent_match(fan_mode, percent)) {
+        return percent;
+    }
+    switch (fan_mode) {
+    case APP_FAN_MODE_HIGH:
+        return HIGH_MODE_PERCENT_MAX;
+    case APP_FAN_MODE_MEDIUM:
+        return MED_MODE_PERCENT_MAX;
+    case APP_FAN_MODE_LOW:
+        return LOW_MODE_PERCENT_MAX;
+    default:
+        return 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 20000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            iterations = 200;
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--iterations N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    static const fan_mode_table_t table = make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH);
+    const uint32_t lookups = iterations * 4 * k_percent_count * 2;
+    volatile uint32_t sink = 0;
+
+    /* Both agree on every in-range write, so the comparison times the same work */
+    for (uint8_t mode = APP_FAN_MODE_OFF; mode <= APP_FAN_MODE_HIGH; mode++) {
+        for (uint8_t percent = 0; percent < k_percent_count; percent++) {
+            if (fan_mode_reconcile_percent_write(table, mode, percent).fan_mode != switch_percent_write(mode, percent) ||
+                (mode != APP_FAN_MODE_OFF &&
+                 fan_mode_reconcile_mode_write(table, mode, percent).percent != switch_mode_write(mode, percent))) {
+                fprintf(stderr, "Table and switch disagree for mode %d, percent %d\n", mode, percent);
+                return 1;
+            }
+        }
+    }
+
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        for (uint8_t mode = APP_FAN_MODE_OFF; mode <= APP_FAN_MODE_HIGH; mode++) {
+            for (uint8_t percent = 0; percent < k_percent_count; percent++) {
+                uint8_t written = (uint8_t)(percent ^ (i & 1));
+                sink += fan_mode_reconcile_percent_write(table, mode, written).fan_mode;
+                sink += fan_mode_reconcile_mode_write(table, mode, written).percent;
+            }
+        }
+    }
+    uint64_t table_ns = now_ns() - start;
+
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        for (uint8_t mode = APP_FAN_MODE_OFF; mode <= APP_FAN_MODE_HIGH; mode++) {
+            for (uint8_t percent = 0; percent < k_percent_count; percent++) {
+                uint8_t written = (uint8_t)(percent ^ (i & 1));
+                sink += switch_percent_write(mode, written);
+                sink += switch_mode_write(mode, written);
+            }
+        }
+    }
+    uint64_t switch_ns = now_ns() - start;
+
+    printf("%u lookups\n", lookups);
+    printf("table   %8.2f ns/lookup\n", (double)table_ns / lookups);
+    printf("switch  %8.2f ns/lookup\n", (double)switch_ns / lookups);
+    return sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Cost of one PID control tick of app_fan_pid.cpp, fan_control_tick() runs one per fan and tach window
+ *
+ * Usage: bench_fan_pid [--quick] [--iterations N]
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <app_fan_bank.h>
+#include <app_fan_pid.h>
+
+static uint64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 10000000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            iterations = 100000;
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--iterations N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const app_fan_pid_gains_t gains = {
+        .kp = CONFIG_FAN_PID_KP_Q8,
+        .ki = CONFIG_FAN_PID_KI_Q8,
+        .kd = CONFIG_FAN_PID_KD_Q8,
+        .out_min = 0,
+        .out_max = FAN_BANK_DUTY_MAX - 1,
+    };
+    app_fan_pid_state_t state[CONFIG_FAN_COUNT];
+    for (app_fan_pid_state_t &fan : state) {
+        app_fan_pid_reset(&fan, 0);
+    }
+
+    volatile int64_t sink = 0;
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        int32_t measurement = (int32_t)((i * 7919u) % CONFIG_FAN_MAX_RPM);
+        sink += app_fan_pid_step(&gains, &state[i % CONFIG_FAN_COUNT], CONFIG_FAN_MAX_RPM / 2, measurement,
+                                 (FAN_BANK_DUTY_MAX - 1) / 2);
+    }
+    uint64_t elapsed = now_ns() - start;
+    printf("%u ticks\n", iterations);
+    printf("pid_step  %6.2f ns/tick\n", (double)elapsed / iterations);
+    return 0;
+}
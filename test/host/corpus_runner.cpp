@@ -0,0 +1,147 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Replays a recorded sequence of FanControl writes against the driver and checks the resulting state
+ *
+ * One command per line, '#' starts a comment:
+ *   fan <index>                    fan the following lines address, 0 at the start
+ *   mode <FanMode>                 FanMode write
+ *   percent <0..100|null>          PercentSetting write
+ *   speed <0..SpeedMax|null>       SpeedSetting write
+ *   temperature <0.01 °C|null>     MeasuredValue of the temperature endpoint
+ *   wait <ms>                      let time pass, ramps, pulses and reports run
+ *   expect mode|percent|speed <value>      stored attribute of the fan
+ *   expect duty <percent>          duty the fan's LEDC channel ends up at, in percent of the full scale
+ *
+ * Usage: corpus_runner <file>...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/ledc.h"
+
+#include <app_fan_bank.h>
+
+#include "host_node.h"
+
+using namespace chip::app::Clusters;
+
+static bool parse_value(const char *text, long min, long max, long *value)
+{
+    if (strcmp(text, "null") == 0) {
+        return false;
+    }
+    char *end = NULL;
+    *value = strtol(text, &end, 0);
+    return *end == '\0' && *value >= min && *value <= max;
+}
+
+static uint8_t read_fan_u8(size_t fan, uint32_t attribute_id)
+{
+    return host_node_read(host_node_fan_endpoint(fan), FanControl::Id, attribute_id).val.u8;
+}
+
+/* Returns the number of failed expectations, -1 if the file cannot be replayed */
+static int run_corpus(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return -1;
+    }
+    int failures = 0;
+    int line_number = 0;
+    size_t fan = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        char command[32] = "";
+        char arg[32] = "";
+        char value_text[32] = "";
+        int fields = sscanf(line, "%31s %31s %31s", command, arg, value_text);
+        if (fields <= 0) {
+            continue;
+        }
+        long value = 0;
+        bool valid = fields >= 2 && parse_value(arg, INT16_MIN, INT16_MAX, &value);
+        bool is_null = fields >= 2 && strcmp(arg, "null") == 0;
+
+        if (strcmp(command, "fan") == 0 && valid && value >= 0 && value < CONFIG_FAN_COUNT) {
+            fan = (size_t)value;
+        } else if (strcmp(command, "mode") == 0 && valid && value >= 0 && value <= UINT8_MAX) {
+            host_node_write(host_node_fan_endpoint(fan), FanControl::Id, FanControl::Attributes::FanMode::Id,
+                            esp_matter_enum8((uint8_t)value));
+        } else if ((strcmp(command, "percent") == 0 || strcmp(command, "speed") == 0) &&
+                   ((valid && value >= 0 && value < UINT8_MAX) || is_null)) {
+            uint32_t attribute_id = command[0] == 'p' ? FanControl::Attributes::PercentSetting::Id
+                                                      : FanControl::Attributes::SpeedSetting::Id;
+            host_node_write(host_node_fan_endpoint(fan), FanControl::Id, attribute_id,
+                            esp_matter_nullable_uint8(is_null ? UINT8_MAX : (uint8_t)value));
+        } else if (strcmp(command, "temperature") == 0 && (valid || is_null)) {
+            host_node_write(host_node_temperature_endpoint(), TemperatureMeasurement::Id,
+                            TemperatureMeasurement::Attributes::MeasuredValue::Id,
+                            esp_matter_nullable_int16(is_null ? INT16_MIN : (int16_t)value));
+        } else if (strcmp(command, "wait") == 0 && valid && value >= 0) {
+            host_node_advance_ms((uint32_t)value);
+        } else if (strcmp(command, "expect") == 0 && fields == 3 && parse_value(value_text, 0, 100, &value)) {
+            long actual;
+            if (strcmp(arg, "mode") == 0) {
+                actual = read_fan_u8(fan, FanControl::Attributes::FanMode::Id);
+            } else if (strcmp(arg, "percent") == 0) {
+                actual = read_fan_u8(fan, FanControl::Attributes::PercentSetting::Id);
+            } else if (strcmp(arg, "speed") == 0) {
+                actual = read_fan_u8(fan, FanControl::Attributes::SpeedSetting::Id);
+            } else if (strcmp(arg, "duty") == 0) {
+                actual = host_node_fan_duty(fan);
+                value = (value * (FAN_BANK_DUTY_MAX - 1)) / 100;
+            } else {
+                fprintf(stderr, "%s:%d: unknown expectation '%s'\n", path, line_number, arg);
+                fclose(file);
+                return -1;
+            }
+            if (actual != value) {
+                fprintf(stderr, "%s:%d: fan %d %s is %ld, expected %ld\n", path, line_number, (int)fan, arg, actual,
+                        value);
+                failures++;
+            }
+        } else {
+            fprintf(stderr, "%s:%d: cannot parse '%s'\n", path, line_number, command);
+            fclose(file);
+            return -1;
+        }
+    }
+    fclose(file);
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <file>...\n", argv[0]);
+        return 2;
+    }
+    if (host_node_init() != ESP_OK) {
+        fprintf(stderr, "Failed to create the node\n");
+        return 1;
+    }
+    int result = 0;
+    for (int i = 1; i < argc; i++) {
+        int failures = run_corpus(argv[i]);
+        printf("%s %s\n", failures == 0 ? "PASS" : "FAIL", argv[i]);
+        if (failures != 0) {
+            result = 1;
+        }
+    }
+    return result;
+}
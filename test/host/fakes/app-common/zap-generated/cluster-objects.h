@@ -0,0 +1,102 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* The IDs and enums of the clusters main/ uses, values as in the Matter 1.4 data model */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <type_traits>
+
+namespace chip {
+
+typedef uint16_t EndpointId;
+typedef uint32_t ClusterId;
+typedef uint32_t AttributeId;
+
+template <typename T>
+constexpr typename std::underlying_type<T>::type to_underlying(T e)
+{
+    return static_cast<typename std::underlying_type<T>::type>(e);
+}
+
+namespace app {
+namespace Clusters {
+
+namespace Globals {
+namespace Attributes {
+namespace FeatureMap { static constexpr AttributeId Id = 0xFFFC; }
+namespace ClusterRevision { static constexpr AttributeId Id = 0xFFFD; }
+} // namespace Attributes
+} // namespace Globals
+
+namespace Identify {
+static constexpr ClusterId Id = 0x0003;
+} // namespace Identify
+
+namespace Groups {
+static constexpr ClusterId Id = 0x0004;
+} // namespace Groups
+
+namespace Descriptor {
+static constexpr ClusterId Id = 0x001D;
+} // namespace Descriptor
+
+namespace ScenesManagement {
+static constexpr ClusterId Id = 0x0062;
+} // namespace ScenesManagement
+
+namespace OnOff {
+static constexpr ClusterId Id = 0x0006;
+} // namespace OnOff
+
+namespace FanControl {
+static constexpr ClusterId Id = 0x0202;
+
+enum class FanModeEnum : uint8_t {
+    kOff = 0,
+    kLow = 1,
+    kMedium = 2,
+    kHigh = 3,
+    kOn = 4,
+    kAuto = 5,
+    kSmart = 6,
+};
+
+enum class FanModeSequenceEnum : uint8_t {
+    kOffLowMedHigh = 0,
+    kOffLowHigh = 1,
+    kOffLowMedHighAuto = 2,
+    kOffLowHighAuto = 3,
+    kOffHighAuto = 4,
+    kOffHigh = 5,
+};
+
+namespace Attributes {
+namespace FanMode { static constexpr AttributeId Id = 0x0000; }
+namespace FanModeSequence { static constexpr AttributeId Id = 0x0001; }
+namespace PercentSetting { static constexpr AttributeId Id = 0x0002; }
+namespace PercentCurrent { static constexpr AttributeId Id = 0x0003; }
+namespace SpeedMax { static constexpr AttributeId Id = 0x0004; }
+namespace SpeedSetting { static constexpr AttributeId Id = 0x0005; }
+namespace SpeedCurrent { static constexpr AttributeId Id = 0x0006; }
+} // namespace Attributes
+} // namespace FanControl
+
+namespace TemperatureMeasurement {
+static constexpr ClusterId Id = 0x0402;
+
+namespace Attributes {
+namespace MeasuredValue { static constexpr AttributeId Id = 0x0000; }
+} // namespace Attributes
+} // namespace TemperatureMeasurement
+
+} // namespace Clusters
+} // namespace app
+} // namespace chip
@@ -0,0 +1,14 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <app-common/zap-generated/cluster-objects.h>
+
+void MatterReportingAttributeChangeCallback(chip::EndpointId endpoint, chip::ClusterId cluster,
+                                            chip::AttributeId attribute);
@@ -0,0 +1,23 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdio.h>
+
+/* Errors and warnings go to stderr, everything else is dropped so benchmarks do not measure the console */
+void fake_esp_log(char level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+#define ESP_LOGE(tag, format, ...) fake_esp_log('E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) fake_esp_log('W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) do { if (0) fake_esp_log('I', tag, format, ##__VA_ARGS__); } while (0)
+#define ESP_LOGD(tag, format, ...) do { if (0) fake_esp_log('D', tag, format, ##__VA_ARGS__); } while (0)
+#define ESP_LOGV(tag, format, ...) do { if (0) fake_esp_log('V', tag, format, ##__VA_ARGS__); } while (0)
+
+/* Number of errors and warnings logged so far */
+unsigned fake_esp_log_count();
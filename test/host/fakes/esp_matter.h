@@ -0,0 +1,133 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* The esp-matter data model as main/ uses it: nodes, endpoints, clusters and attributes in linked lists like in
+   esp-matter, so walking them costs what it costs on the device. attribute::update() runs the PRE_UPDATE
+   callback, stores the value only if the callback accepts it and then runs POST_UPDATE, like a write through the
+   Matter stack. attribute::set_val() only stores. */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_err.h>
+#include <app-common/zap-generated/cluster-objects.h>
+
+typedef enum {
+    ESP_MATTER_VAL_TYPE_INVALID = 0,
+    ESP_MATTER_VAL_TYPE_BOOLEAN,
+    ESP_MATTER_VAL_TYPE_INT16,
+    ESP_MATTER_VAL_TYPE_UINT8,
+    ESP_MATTER_VAL_TYPE_UINT16,
+    ESP_MATTER_VAL_TYPE_UINT32,
+    ESP_MATTER_VAL_TYPE_ENUM8,
+    ESP_MATTER_VAL_TYPE_BITMAP8,
+    ESP_MATTER_VAL_TYPE_NULLABLE_INT16,
+    ESP_MATTER_VAL_TYPE_NULLABLE_UINT8,
+} esp_matter_val_type_t;
+
+typedef union {
+    bool b;
+    int16_t i16;
+    uint8_t u8;
+    uint16_t u16;
+    uint32_t u32;
+    void *p;
+} esp_matter_val_t;
+
+typedef struct {
+    esp_matter_val_type_t type;
+    esp_matter_val_t val;
+} esp_matter_attr_val_t;
+
+esp_matter_attr_val_t esp_matter_invalid(void *val);
+esp_matter_attr_val_t esp_matter_bool(bool val);
+esp_matter_attr_val_t esp_matter_int16(int16_t val);
+esp_matter_attr_val_t esp_matter_uint8(uint8_t val);
+esp_matter_attr_val_t esp_matter_uint16(uint16_t val);
+esp_matter_attr_val_t esp_matter_uint32(uint32_t val);
+esp_matter_attr_val_t esp_matter_enum8(uint8_t val);
+esp_matter_attr_val_t esp_matter_bitmap8(uint8_t val);
+esp_matter_attr_val_t esp_matter_nullable_int16(int16_t val);
+esp_matter_attr_val_t esp_matter_nullable_uint8(uint8_t val);
+
+struct fake_node;
+struct fake_endpoint;
+struct fake_cluster;
+struct fake_attribute;
+
+namespace esp_matter {
+
+typedef struct fake_node node_t;
+typedef struct fake_endpoint endpoint_t;
+typedef struct fake_cluster cluster_t;
+typedef struct fake_attribute attribute_t;
+
+enum {
+    ENDPOINT_FLAG_NONE = 0,
+    CLUSTER_FLAG_SERVER = 1 << 1,
+    ATTRIBUTE_FLAG_NONE = 0,
+    ATTRIBUTE_FLAG_WRITABLE = 1 << 0,
+    ATTRIBUTE_FLAG_NULLABLE = 1 << 1,
+};
+
+namespace node {
+/** Create the node, there is only one */
+node_t *create_raw();
+node_t *get();
+/** Free the node with all its endpoints */
+void destroy();
+} // namespace node
+
+namespace endpoint {
+/** Create an endpoint with the next free endpoint ID, starting at 0 */
+endpoint_t *create(node_t *node, uint8_t flags, void *priv_data);
+endpoint_t *get(node_t *node, uint16_t endpoint_id);
+uint16_t get_id(endpoint_t *endpoint);
+} // namespace endpoint
+
+namespace cluster {
+cluster_t *create(endpoint_t *endpoint, uint32_t cluster_id, uint8_t flags);
+cluster_t *get(endpoint_t *endpoint, uint32_t cluster_id);
+} // namespace cluster
+
+namespace attribute {
+
+typedef enum {
+    PRE_UPDATE,
+    POST_UPDATE,
+    READ,
+    WRITE,
+} callback_type_t;
+
+typedef esp_err_t (*callback_t)(callback_type_t type, uint16_t endpoint_id, uint32_t cluster_id,
+                                uint32_t attribute_id, esp_matter_attr_val_t *val, void *priv_data);
+
+esp_err_t set_callback(callback_t callback);
+attribute_t *create(cluster_t *cluster, uint32_t attribute_id, uint16_t flags, esp_matter_attr_val_t val);
+attribute_t *get(cluster_t *cluster, uint32_t attribute_id);
+attribute_t *get(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id);
+esp_err_t get_val(attribute_t *attribute, esp_matter_attr_val_t *val);
+esp_err_t set_val(attribute_t *attribute, esp_matter_attr_val_t *val);
+esp_err_t update(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id, esp_matter_attr_val_t *val);
+
+} // namespace attribute
+} // namespace esp_matter
+
+/* Attribute changes reported to subscribers so far, by attribute::update() or
+   MatterReportingAttributeChangeCallback() */
+uint32_t fake_esp_matter_report_count();
+
+/* Value of an attribute as subscribers last received it, attribute::set_val() alone does not report */
+esp_matter_attr_val_t fake_esp_matter_reported_val(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id);
+
+/* Called with every report, on the thread that reports the change */
+typedef void (*fake_esp_matter_report_handler_t)(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id,
+                                                 const esp_matter_attr_val_t *val);
+void fake_esp_matter_set_report_handler(fake_esp_matter_report_handler_t handler);
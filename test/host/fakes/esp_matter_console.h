@@ -0,0 +1,29 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_err.h>
+
+namespace esp_matter {
+namespace console {
+
+typedef esp_err_t (*command_handler_t)(int argc, char **argv);
+
+typedef struct {
+    const char *name;
+    const char *description;
+    command_handler_t handler;
+} command_t;
+
+esp_err_t add_commands(const command_t *commands, uint8_t count);
+
+} // namespace console
+} // namespace esp_matter
@@ -0,0 +1,398 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* ESP-IDF and FreeRTOS fakes: logging, esp_timer, LEDC and tasks */
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <esp_err.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include "driver/ledc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    default: return "UNKNOWN ERROR";
+    }
+}
+
+/* Logging */
+
+static std::atomic<unsigned> s_log_count{0};
+
+void fake_esp_log(char level, const char *tag, const char *format, ...)
+{
+    s_log_count++;
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%c (%s) ", level, tag);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+unsigned fake_esp_log_count()
+{
+    return s_log_count;
+}
+
+/* esp_timer */
+
+struct fake_esp_timer {
+    esp_timer_create_args_t args;
+    bool armed;
+    uint64_t due_us;
+    uint64_t period_us;     /* 0 for a one-shot timer */
+};
+
+static std::recursive_mutex s_timer_mutex;
+static std::vector<fake_esp_timer *> s_timers;
+static std::atomic<int64_t> s_now_us{0};
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (!create_args || !create_args->callback || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::recursive_mutex> lock(s_timer_mutex);
+    fake_esp_timer *timer = new fake_esp_timer{*create_args, false, 0, 0};
+    s_timers.push_back(timer);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+    std::lock_guard<std::recursive_mutex> lock(s_timer_mutex);
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = true;
+    timer->due_us = s_now_us + timeout_us;
+    timer->period_us = period_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+    return timer_start(timer, period, period);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    std::lock_guard<std::recursive_mutex> lock(s_timer_mutex);
+    if (!timer) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    std::lock_guard<std::recursive_mutex> lock(s_timer_mutex);
+    for (size_t i = 0; i < s_timers.size(); i++) {
+        if (s_timers[i] == timer) {
+            s_timers.erase(s_timers.begin() + i);
+            delete timer;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+int64_t esp_timer_get_time()
+{
+    return s_now_us;
+}
+
+void fake_esp_timer_advance(uint64_t us)
+{
+    uint64_t end = s_now_us + us;
+    while (true) {
+        esp_timer_cb_t callback = NULL;
+        void *arg = NULL;
+        {
+            std::lock_guard<std::recursive_mutex> lock(s_timer_mutex);
+            fake_esp_timer *next = NULL;
+            for (fake_esp_timer *timer : s_timers) {
+                if (timer->armed && timer->due_us <= end && (!next || timer->due_us < next->due_us)) {
+                    next = timer;
+                }
+            }
+            if (!next) {
+                break;
+            }
+            s_now_us = next->due_us;
+            if (next->period_us) {
+                next->due_us += next->period_us;
+            } else {
+                next->armed = false;
+            }
+            callback = next->args.callback;
+            arg = next->args.arg;
+        }
+        callback(arg);
+    }
+    s_now_us = end;
+}
+
+/* LEDC */
+
+typedef struct {
+    std::atomic<uint32_t> duty;         /* latched duty, or the start of the running fade */
+    std::atomic<uint32_t> staged;       /* set by ledc_set_duty(), latched by ledc_update_duty() */
+    uint32_t fade_target;
+    uint32_t fade_ms;
+    int64_t fade_start_us;
+    bool fading;
+} fake_ledc_channel_t;
+
+static std::mutex s_ledc_mutex;
+static fake_ledc_channel_t s_ledc[LEDC_CHANNEL_MAX];
+static std::atomic<uint32_t> s_ledc_writes{0};
+
+/* Caller holds s_ledc_mutex */
+static uint32_t ledc_output(const fake_ledc_channel_t &channel)
+{
+    uint32_t from = channel.duty;
+    if (!channel.fading) {
+        return from;
+    }
+    int64_t elapsed_us = s_now_us - channel.fade_start_us;
+    if (channel.fade_ms == 0 || elapsed_us >= (int64_t)channel.fade_ms * 1000) {
+        return channel.fade_target;
+    }
+    int64_t delta = (int64_t)channel.fade_target - from;
+    return (uint32_t)(from + (delta * elapsed_us) / ((int64_t)channel.fade_ms * 1000));
+}
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *timer_conf)
+{
+    return timer_conf && timer_conf->freq_hz > 0 ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *ledc_conf)
+{
+    if (!ledc_conf || ledc_conf->channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(s_ledc_mutex);
+    fake_ledc_channel_t &channel = s_ledc[ledc_conf->channel];
+    channel.duty = ledc_conf->duty;
+    channel.staged = ledc_conf->duty;
+    channel.fading = false;
+    return ESP_OK;
+}
+
+esp_err_t ledc_fade_func_install(int intr_alloc_flags)
+{
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty)
+{
+    if (channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_ledc[channel].staged = duty;
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    if (channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(s_ledc_mutex);
+    s_ledc[channel].duty = s_ledc[channel].staged.load();
+    s_ledc[channel].fading = false;
+    s_ledc_writes++;
+    return ESP_OK;
+}
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    if (channel >= LEDC_CHANNEL_MAX) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(s_ledc_mutex);
+    return ledc_output(s_ledc[channel]);
+}
+
+esp_err_t ledc_set_fade_with_time(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t target_duty,
+                                  int max_fade_time_ms)
+{
+    if (channel >= LEDC_CHANNEL_MAX || max_fade_time_ms < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(s_ledc_mutex);
+    s_ledc[channel].fade_target = target_duty;
+    s_ledc[channel].fade_ms = (uint32_t)max_fade_time_ms;
+    return ESP_OK;
+}
+
+esp_err_t ledc_fade_start(ledc_mode_t speed_mode, ledc_channel_t channel, ledc_fade_mode_t fade_mode)
+{
+    if (channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(s_ledc_mutex);
+    s_ledc[channel].fading = true;
+    s_ledc[channel].fade_start_us = s_now_us;
+    s_ledc_writes++;
+    return ESP_OK;
+}
+
+esp_err_t ledc_fade_stop(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    if (channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(s_ledc_mutex);
+    s_ledc[channel].duty = ledc_output(s_ledc[channel]);
+    s_ledc[channel].fading = false;
+    return ESP_OK;
+}
+
+uint32_t fake_ledc_target(ledc_channel_t channel)
+{
+    std::lock_guard<std::mutex> lock(s_ledc_mutex);
+    return s_ledc[channel].fading ? s_ledc[channel].fade_target : s_ledc[channel].duty.load();
+}
+
+uint32_t fake_ledc_write_count()
+{
+    return s_ledc_writes;
+}
+
+void fake_ledc_reset()
+{
+    std::lock_guard<std::mutex> lock(s_ledc_mutex);
+    for (fake_ledc_channel_t &channel : s_ledc) {
+        channel.duty = 0;
+        channel.staged = 0;
+        channel.fading = false;
+    }
+    s_ledc_writes = 0;
+}
+
+/* Tasks. The task objects and what they wait on are never freed: a task runs until the process exits, and
+   destroying a condition variable a task still waits on would hang the exit. */
+
+struct fake_task {
+    std::thread thread;
+    uint32_t notified = 0;
+    bool waiting = false;
+};
+
+static std::mutex &s_task_mutex = *new std::mutex;
+static std::condition_variable &s_task_cond = *new std::condition_variable;
+static std::vector<fake_task *> &s_tasks = *new std::vector<fake_task *>;
+static thread_local fake_task *s_current_task;
+
+BaseType_t xTaskCreate(TaskFunction_t task_code, const char *name, uint32_t stack_depth, void *parameters,
+                       UBaseType_t priority, TaskHandle_t *created_task)
+{
+    fake_task *task = new fake_task();
+    {
+        std::lock_guard<std::mutex> lock(s_task_mutex);
+        s_tasks.push_back(task);
+    }
+    if (created_task) {
+        *created_task = task;
+    }
+    task->thread = std::thread([task, task_code, parameters]() {
+        s_current_task = task;
+        task_code(parameters);
+    });
+    task->thread.detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    if (!task) {
+        return pdFAIL;
+    }
+    std::lock_guard<std::mutex> lock(s_task_mutex);
+    switch (action) {
+    case eSetBits: task->notified |= value; break;
+    case eIncrement: task->notified++; break;
+    case eSetValueWithOverwrite:
+    case eSetValueWithoutOverwrite: task->notified = value; break;
+    case eNoAction: break;
+    }
+    s_task_cond.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t bits_to_clear_on_entry, uint32_t bits_to_clear_on_exit, uint32_t *notification_value,
+                           TickType_t ticks_to_wait)
+{
+    fake_task *task = s_current_task;
+    std::unique_lock<std::mutex> lock(s_task_mutex);
+    task->notified &= ~bits_to_clear_on_entry;
+    task->waiting = true;
+    s_task_cond.notify_all();
+    s_task_cond.wait(lock, [task]() { return task->notified != 0; });
+    task->waiting = false;
+    if (notification_value) {
+        *notification_value = task->notified;
+    }
+    task->notified &= ~bits_to_clear_on_exit;
+    return pdTRUE;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+void fake_task_wait_idle()
+{
+    std::unique_lock<std::mutex> lock(s_task_mutex);
+    s_task_cond.wait(lock, []() {
+        for (fake_task *task : s_tasks) {
+            if (!task->waiting || task->notified != 0) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
@@ -0,0 +1,423 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* esp-matter and CHIP fakes: the data model, the CHIP work queue, reporting, console and buttons */
+
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+
+#include <esp_matter.h>
+#include <esp_matter_console.h>
+#include <iot_button.h>
+#include <app/reporting/reporting.h>
+#include <platform/CHIPDeviceLayer.h>
+
+/* Attribute values */
+
+static esp_matter_attr_val_t make_val(esp_matter_val_type_t type)
+{
+    esp_matter_attr_val_t val;
+    memset(&val, 0, sizeof(val));
+    val.type = type;
+    return val;
+}
+
+esp_matter_attr_val_t esp_matter_invalid(void *val)
+{
+    esp_matter_attr_val_t out = make_val(ESP_MATTER_VAL_TYPE_INVALID);
+    out.val.p = val;
+    return out;
+}
+
+#define FAKE_VAL(name, type, field, enum_type)                                                            \
+    esp_matter_attr_val_t name(type val)                                                                  \
+    {                                                                                                     \
+        esp_matter_attr_val_t out = make_val(enum_type);                                                  \
+        out.val.field = val;                                                                              \
+        return out;                                                                                       \
+    }
+
+FAKE_VAL(esp_matter_bool, bool, b, ESP_MATTER_VAL_TYPE_BOOLEAN)
+FAKE_VAL(esp_matter_int16, int16_t, i16, ESP_MATTER_VAL_TYPE_INT16)
+FAKE_VAL(esp_matter_uint8, uint8_t, u8, ESP_MATTER_VAL_TYPE_UINT8)
+FAKE_VAL(esp_matter_uint16, uint16_t, u16, ESP_MATTER_VAL_TYPE_UINT16)
+FAKE_VAL(esp_matter_uint32, uint32_t, u32, ESP_MATTER_VAL_TYPE_UINT32)
+FAKE_VAL(esp_matter_enum8, uint8_t, u8, ESP_MATTER_VAL_TYPE_ENUM8)
+FAKE_VAL(esp_matter_bitmap8, uint8_t, u8, ESP_MATTER_VAL_TYPE_BITMAP8)
+FAKE_VAL(esp_matter_nullable_int16, int16_t, i16, ESP_MATTER_VAL_TYPE_NULLABLE_INT16)
+FAKE_VAL(esp_matter_nullable_uint8, uint8_t, u8, ESP_MATTER_VAL_TYPE_NULLABLE_UINT8)
+
+/* Data model */
+
+struct fake_attribute {
+    uint32_t id;
+    uint16_t flags;
+    esp_matter_attr_val_t val;
+    esp_matter_attr_val_t reported;     /* what subscribers were last sent */
+    fake_attribute *next;
+};
+
+struct fake_cluster {
+    uint32_t id;
+    uint8_t flags;
+    fake_attribute *attributes;
+    fake_cluster *next;
+};
+
+struct fake_endpoint {
+    uint16_t id;
+    void *priv_data;
+    fake_cluster *clusters;
+    fake_endpoint *next;
+};
+
+struct fake_node {
+    uint16_t next_endpoint_id;
+    fake_endpoint *endpoints;
+};
+
+static fake_node *s_node;
+static esp_matter::attribute::callback_t s_callback;
+static std::atomic<uint32_t> s_report_count{0};
+static fake_esp_matter_report_handler_t s_report_handler;
+
+static bool val_equal(const esp_matter_attr_val_t &a, const esp_matter_attr_val_t &b)
+{
+    return a.type == b.type && memcmp(&a.val, &b.val, sizeof(a.val)) == 0;
+}
+
+namespace esp_matter {
+
+namespace node {
+
+node_t *create_raw()
+{
+    if (!s_node) {
+        s_node = new fake_node{0, NULL};
+    }
+    return s_node;
+}
+
+node_t *get()
+{
+    return s_node;
+}
+
+void destroy()
+{
+    if (!s_node) {
+        return;
+    }
+    for (fake_endpoint *endpoint = s_node->endpoints; endpoint;) {
+        for (fake_cluster *cluster = endpoint->clusters; cluster;) {
+            for (fake_attribute *attribute = cluster->attributes; attribute;) {
+                fake_attribute *next = attribute->next;
+                delete attribute;
+                attribute = next;
+            }
+            fake_cluster *next = cluster->next;
+            delete cluster;
+            cluster = next;
+        }
+        fake_endpoint *next = endpoint->next;
+        delete endpoint;
+        endpoint = next;
+    }
+    delete s_node;
+    s_node = NULL;
+}
+
+} // namespace node
+
+namespace endpoint {
+
+endpoint_t *create(node_t *node, uint8_t flags, void *priv_data)
+{
+    if (!node) {
+        return NULL;
+    }
+    fake_endpoint *endpoint = new fake_endpoint{node->next_endpoint_id++, priv_data, NULL, NULL};
+    fake_endpoint **tail = &node->endpoints;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = endpoint;
+    return endpoint;
+}
+
+endpoint_t *get(node_t *node, uint16_t endpoint_id)
+{
+    for (fake_endpoint *endpoint = node ? node->endpoints : NULL; endpoint; endpoint = endpoint->next) {
+        if (endpoint->id == endpoint_id) {
+            return endpoint;
+        }
+    }
+    return NULL;
+}
+
+uint16_t get_id(endpoint_t *endpoint)
+{
+    return endpoint ? endpoint->id : 0xFFFF;
+}
+
+} // namespace endpoint
+
+namespace cluster {
+
+cluster_t *create(endpoint_t *endpoint, uint32_t cluster_id, uint8_t flags)
+{
+    if (!endpoint) {
+        return NULL;
+    }
+    cluster_t *existing = get(endpoint, cluster_id);
+    if (existing) {
+        return existing;
+    }
+    fake_cluster *cluster = new fake_cluster{cluster_id, flags, NULL, NULL};
+    fake_cluster **tail = &endpoint->clusters;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = cluster;
+    return cluster;
+}
+
+cluster_t *get(endpoint_t *endpoint, uint32_t cluster_id)
+{
+    for (fake_cluster *cluster = endpoint ? endpoint->clusters : NULL; cluster; cluster = cluster->next) {
+        if (cluster->id == cluster_id) {
+            return cluster;
+        }
+    }
+    return NULL;
+}
+
+} // namespace cluster
+
+namespace attribute {
+
+esp_err_t set_callback(callback_t callback)
+{
+    s_callback = callback;
+    return ESP_OK;
+}
+
+attribute_t *create(cluster_t *cluster, uint32_t attribute_id, uint16_t flags, esp_matter_attr_val_t val)
+{
+    if (!cluster) {
+        return NULL;
+    }
+    fake_attribute *attribute = new fake_attribute{attribute_id, flags, val, val, NULL};
+    fake_attribute **tail = &cluster->attributes;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = attribute;
+    return attribute;
+}
+
+attribute_t *get(cluster_t *cluster, uint32_t attribute_id)
+{
+    for (fake_attribute *attribute = cluster ? cluster->attributes : NULL; attribute; attribute = attribute->next) {
+        if (attribute->id == attribute_id) {
+            return attribute;
+        }
+    }
+    return NULL;
+}
+
+attribute_t *get(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id)
+{
+    return get(cluster::get(endpoint::get(node::get(), endpoint_id), cluster_id), attribute_id);
+}
+
+esp_err_t get_val(attribute_t *attribute, esp_matter_attr_val_t *val)
+{
+    if (!attribute || !val) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *val = attribute->val;
+    return ESP_OK;
+}
+
+esp_err_t set_val(attribute_t *attribute, esp_matter_attr_val_t *val)
+{
+    if (!attribute || !val) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* The stored type is kept, callers pass values built for the attribute's type */
+    attribute->val.val = val->val;
+    return ESP_OK;
+}
+
+esp_err_t update(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id, esp_matter_attr_val_t *val)
+{
+    endpoint_t *endpoint = endpoint::get(node::get(), endpoint_id);
+    attribute_t *attribute = get(cluster::get(endpoint, cluster_id), attribute_id);
+    if (!attribute || !val) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (s_callback) {
+        esp_err_t err = s_callback(PRE_UPDATE, endpoint_id, cluster_id, attribute_id, val, endpoint->priv_data);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    esp_matter_attr_val_t stored = attribute->val;
+    stored.val = val->val;
+    if (!val_equal(stored, attribute->val)) {
+        attribute->val = stored;
+        attribute->reported = stored;
+        s_report_count++;
+        if (s_report_handler) {
+            s_report_handler(endpoint_id, cluster_id, attribute_id, &stored);
+        }
+    }
+    if (s_callback) {
+        s_callback(POST_UPDATE, endpoint_id, cluster_id, attribute_id, val, endpoint->priv_data);
+    }
+    return ESP_OK;
+}
+
+} // namespace attribute
+
+namespace console {
+
+esp_err_t add_commands(const command_t *commands, uint8_t count)
+{
+    return ESP_OK;
+}
+
+} // namespace console
+
+} // namespace esp_matter
+
+uint32_t fake_esp_matter_report_count()
+{
+    return s_report_count;
+}
+
+esp_matter_attr_val_t fake_esp_matter_reported_val(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id)
+{
+    fake_attribute *attribute = esp_matter::attribute::get(endpoint_id, cluster_id, attribute_id);
+    return attribute ? attribute->reported : esp_matter_invalid(NULL);
+}
+
+/* The report reads the attribute when it is generated, which is after the caller stored the new value */
+void MatterReportingAttributeChangeCallback(chip::EndpointId endpoint, chip::ClusterId cluster,
+                                            chip::AttributeId attribute)
+{
+    fake_attribute *reported = esp_matter::attribute::get(endpoint, cluster, attribute);
+    if (reported) {
+        reported->reported = reported->val;
+    }
+    s_report_count++;
+    if (reported && s_report_handler) {
+        s_report_handler(endpoint, cluster, attribute, &reported->reported);
+    }
+}
+
+void fake_esp_matter_set_report_handler(fake_esp_matter_report_handler_t handler)
+{
+    s_report_handler = handler;
+}
+
+/* CHIP work queue, a fixed ring so scheduling work does not allocate */
+
+#define FAKE_WORK_QUEUE_SIZE 64
+
+typedef struct {
+    chip::DeviceLayer::AsyncWorkFunct work;
+    intptr_t arg;
+} fake_work_t;
+
+static std::mutex s_work_mutex;
+static fake_work_t s_work[FAKE_WORK_QUEUE_SIZE];
+static size_t s_work_head;
+static size_t s_work_tail;
+static unsigned s_work_failures;
+
+namespace chip {
+namespace DeviceLayer {
+
+CHIP_ERROR PlatformManager::ScheduleWork(AsyncWorkFunct work, intptr_t arg)
+{
+    std::lock_guard<std::mutex> lock(s_work_mutex);
+    if (s_work_failures > 0) {
+        s_work_failures--;
+        return CHIP_ERROR_NO_MEMORY;
+    }
+    if (s_work_head - s_work_tail == FAKE_WORK_QUEUE_SIZE) {
+        return CHIP_ERROR_NO_MEMORY;
+    }
+    s_work[s_work_head++ % FAKE_WORK_QUEUE_SIZE] = {work, arg};
+    return CHIP_NO_ERROR;
+}
+
+PlatformManager &PlatformMgr()
+{
+    static PlatformManager manager;
+    return manager;
+}
+
+} // namespace DeviceLayer
+} // namespace chip
+
+unsigned fake_chip_run_work()
+{
+    unsigned count = 0;
+    while (true) {
+        fake_work_t item;
+        {
+            std::lock_guard<std::mutex> lock(s_work_mutex);
+            if (s_work_tail == s_work_head) {
+                return count;
+            }
+            item = s_work[s_work_tail++ % FAKE_WORK_QUEUE_SIZE];
+        }
+        item.work(item.arg);
+        count++;
+    }
+}
+
+void fake_chip_fail_schedule_work(unsigned count)
+{
+    std::lock_guard<std::mutex> lock(s_work_mutex);
+    s_work_failures = count;
+}
+
+/* Buttons */
+
+struct fake_button {
+    button_cb_t callbacks[BUTTON_EVENT_MAX];
+    void *usr_data[BUTTON_EVENT_MAX];
+};
+
+button_handle_t iot_button_create(const button_config_t *config)
+{
+    return config ? new fake_button() : NULL;
+}
+
+esp_err_t iot_button_register_cb(button_handle_t btn_handle, button_event_t event, button_cb_t cb, void *usr_data)
+{
+    if (!btn_handle || event >= BUTTON_EVENT_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    btn_handle->callbacks[event] = cb;
+    btn_handle->usr_data[event] = usr_data;
+    return ESP_OK;
+}
+
+void fake_iot_button_event(button_handle_t btn_handle, button_event_t event)
+{
+    if (btn_handle && event < BUTTON_EVENT_MAX && btn_handle->callbacks[event]) {
+        btn_handle->callbacks[event](btn_handle, btn_handle->usr_data[event]);
+    }
+}
@@ -0,0 +1,96 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include <mutex>
+
+#include "fake_persist.h"
+
+static std::mutex s_mutex;
+static bool s_commissioned;
+static app_persist_fan_t s_fans[APP_PERSIST_MAX_FANS];
+static bool s_fans_valid[APP_PERSIST_MAX_FANS];
+static uint32_t s_fan_writes[APP_PERSIST_MAX_FANS];
+static app_fan_curve_t s_curves[APP_PERSIST_MAX_FANS];
+static bool s_curves_valid[APP_PERSIST_MAX_FANS];
+
+esp_err_t app_persist_init()
+{
+    return ESP_OK;
+}
+
+bool app_persist_get_commissioned()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_commissioned;
+}
+
+void app_persist_set_commissioned(bool commissioned)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_commissioned = commissioned;
+}
+
+void app_persist_invalidate_mirror()
+{
+}
+
+esp_err_t app_persist_get_fan(size_t fan_index, app_persist_fan_t *state)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (fan_index >= APP_PERSIST_MAX_FANS || !s_fans_valid[fan_index]) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *state = s_fans[fan_index];
+    return ESP_OK;
+}
+
+void app_persist_set_fan(size_t fan_index, uint8_t fan_mode, uint8_t percent)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (fan_index < APP_PERSIST_MAX_FANS) {
+        s_fans[fan_index] = {fan_mode, percent};
+        s_fans_valid[fan_index] = true;
+        s_fan_writes[fan_index]++;
+    }
+}
+
+esp_err_t app_persist_get_curve(size_t fan_index, app_fan_curve_t *curve)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (fan_index >= APP_PERSIST_MAX_FANS || !s_curves_valid[fan_index]) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *curve = s_curves[fan_index];
+    return ESP_OK;
+}
+
+void app_persist_set_curve(size_t fan_index, const app_fan_curve_t *curve)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (fan_index < APP_PERSIST_MAX_FANS) {
+        s_curves[fan_index] = *curve;
+        s_curves_valid[fan_index] = true;
+    }
+}
+
+void fake_persist_reset()
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_commissioned = false;
+    memset(s_fans_valid, 0, sizeof(s_fans_valid));
+    memset(s_fan_writes, 0, sizeof(s_fan_writes));
+    memset(s_curves_valid, 0, sizeof(s_curves_valid));
+}
+
+uint32_t fake_persist_fan_writes(size_t fan_index)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return fan_index < APP_PERSIST_MAX_FANS ? s_fan_writes[fan_index] : 0;
+}
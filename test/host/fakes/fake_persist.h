@@ -0,0 +1,19 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* app_persist.h kept in RAM, the NVS write-behind task is not part of the host build */
+
+#pragma once
+
+#include <app_persist.h>
+
+/* Forget everything, like an erased NVS */
+void fake_persist_reset();
+
+/* Number of app_persist_set_fan() calls for a fan, each one is an NVS write on the device */
+uint32_t fake_persist_fan_writes(size_t fan_index);
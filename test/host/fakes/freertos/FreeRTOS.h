@@ -0,0 +1,47 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* The FreeRTOS types and critical sections used by main/. Critical sections are a spinlock, so they still
+   exclude each other when the fake tasks run on threads. */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE         0
+#define pdTRUE          1
+#define pdFAIL          0
+#define pdPASS          1
+#define portMAX_DELAY   ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+typedef struct {
+    std::atomic<bool> locked;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {}
+
+static inline void fake_port_enter_critical(portMUX_TYPE *mux)
+{
+    while (mux->locked.exchange(true, std::memory_order_acquire)) {
+    }
+}
+
+static inline void fake_port_exit_critical(portMUX_TYPE *mux)
+{
+    mux->locked.store(false, std::memory_order_release);
+}
+
+#define portENTER_CRITICAL(mux) fake_port_enter_critical(mux)
+#define portEXIT_CRITICAL(mux) fake_port_exit_critical(mux)
@@ -0,0 +1,51 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Buttons of the espressif/button component. Gestures are injected with fake_iot_button_event(), the callbacks run
+   on the calling thread like they would in the esp_timer task. */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <esp_err.h>
+
+typedef struct fake_button *button_handle_t;
+typedef void (*button_cb_t)(void *button_handle, void *usr_data);
+
+typedef enum {
+    BUTTON_PRESS_DOWN = 0,
+    BUTTON_PRESS_UP,
+    BUTTON_SINGLE_CLICK,
+    BUTTON_DOUBLE_CLICK,
+    BUTTON_LONG_PRESS_START,
+    BUTTON_LONG_PRESS_HOLD,
+    BUTTON_EVENT_MAX,
+} button_event_t;
+
+typedef enum {
+    BUTTON_TYPE_GPIO,
+} button_type_t;
+
+typedef struct {
+    int32_t gpio_num;
+    uint8_t active_level;
+} button_gpio_config_t;
+
+typedef struct {
+    button_type_t type;
+    uint16_t long_press_time;
+    uint16_t short_press_time;
+    button_gpio_config_t gpio_button_config;
+} button_config_t;
+
+button_handle_t iot_button_create(const button_config_t *config);
+esp_err_t iot_button_register_cb(button_handle_t btn_handle, button_event_t event, button_cb_t cb, void *usr_data);
+
+/* Run the callbacks registered for a gesture */
+void fake_iot_button_event(button_handle_t btn_handle, button_event_t event);
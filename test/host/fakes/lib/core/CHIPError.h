@@ -0,0 +1,17 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t CHIP_ERROR;
+
+#define CHIP_NO_ERROR           ((CHIP_ERROR)0)
+#define CHIP_ERROR_NO_MEMORY    ((CHIP_ERROR)0x0b)
+#define CHIP_ERROR_INCORRECT_STATE ((CHIP_ERROR)0x03)
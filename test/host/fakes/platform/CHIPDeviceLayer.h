@@ -0,0 +1,38 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* The CHIP thread is whoever calls fake_chip_run_work(): ScheduleWork() only queues, the queue is run there */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <app-common/zap-generated/cluster-objects.h>
+#include <lib/core/CHIPError.h>
+
+namespace chip {
+namespace DeviceLayer {
+
+typedef void (*AsyncWorkFunct)(intptr_t arg);
+
+class PlatformManager {
+public:
+    CHIP_ERROR ScheduleWork(AsyncWorkFunct work, intptr_t arg = 0);
+    void LockChipStack() {}
+    void UnlockChipStack() {}
+};
+
+PlatformManager &PlatformMgr();
+
+} // namespace DeviceLayer
+} // namespace chip
+
+/* Run the queued work, including work queued meanwhile. Returns the number of items run. */
+unsigned fake_chip_run_work();
+/* Make the next ScheduleWork() calls fail as if the event queue were full */
+void fake_chip_fail_schedule_work(unsigned count);
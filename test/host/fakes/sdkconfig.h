@@ -0,0 +1,44 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Configuration of the host build, the Kconfig defaults of main/ with four fans and the simulated tach source.
+   Forced into every translation unit like the generated sdkconfig.h of ESP-IDF. */
+
+#pragma once
+
+#define CONFIG_BUTTON_PIN 21
+#define CONFIG_EXAMPLE_FAN_GPIO 18
+#define CONFIG_EXAMPLE_FAN2_GPIO 19
+#define CONFIG_EXAMPLE_FAN3_GPIO 23
+#define CONFIG_EXAMPLE_FAN4_GPIO 25
+#define CONFIG_ESP_MATTER_MAX_DYNAMIC_ENDPOINT_COUNT 16
+
+#define CONFIG_FAN_COUNT 4
+#define CONFIG_FAN_SLEW_RATE_PERCENT_PER_SEC 50
+#define CONFIG_FAN_SPEED_MAX 10
+#define CONFIG_FAN_TACH_ENABLE 1
+#define CONFIG_FAN_TACH_SOURCE_SIMULATED 1
+#define CONFIG_FAN_TACH_PULSES_PER_REV 2
+#define CONFIG_FAN_TACH_WINDOW_MS 1000
+#define CONFIG_FAN_PID_KP_Q8 192
+#define CONFIG_FAN_PID_KI_Q8 20
+#define CONFIG_FAN_PID_KD_Q8 0
+#define CONFIG_FAN_CALIBRATION 1
+#define CONFIG_FAN_CALIBRATION_SETTLE_WINDOWS 2
+#define CONFIG_FAN_KICK_MS 500
+#define CONFIG_FAN_AUTO_TEMP_MIN 30
+#define CONFIG_FAN_AUTO_TEMP_MAX 45
+#define CONFIG_FAN_AUTO_PERCENT_MIN 20
+#define CONFIG_FAN_AUTO_HYSTERESIS 50
+#define CONFIG_FAN_AUTO_SAMPLE_INTERVAL_MS 2000
+#define CONFIG_FAN_MAX_RPM 1500
+#define CONFIG_FAN_IDENTIFY_PULSE_PERCENT 100
+#define CONFIG_FAN_IDENTIFY_PULSE_MS 1000
+#define CONFIG_FAN_REPORT_MIN_DELTA 5
+#define CONFIG_FAN_REPORT_MIN_INTERVAL_MS 500
+#define CONFIG_FAN_REPORT_MAX_INTERVAL_MS 5000
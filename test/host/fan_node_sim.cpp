@@ -0,0 +1,287 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* The fan node on Linux for load tests of controllers: the node of host_node.h, driven by the unchanged driver of
+ * main/ on the fake LEDC, tach and button, served over UDP
+ *
+ * One request per datagram, the answer goes back to the sender and starts with the sequence number of the request:
+ *   <seq> info                                         <seq> ok fans <endpoint>... temperature <endpoint>
+ *   <seq> read <endpoint> <cluster> <attribute>        <seq> ok <value>
+ *   <seq> write <endpoint> <cluster> <attribute> <value|null>   <seq> ok
+ *   <seq> duty <fan>                                   <seq> ok <LEDC duty>
+ *   <seq> subscribe                                    <seq> ok
+ * A failed request is answered with "<seq> err <reason>". After subscribe, the sender gets a datagram
+ * "report <endpoint> <cluster> <attribute> <value>" for every attribute change the node reports.
+ *
+ * The virtual clock of the fakes follows the real time, so ramps, tach windows, pulses and the PercentCurrent reports
+ * run as on the device. "ready <port>" is printed to stdout once the node serves requests.
+ *
+ * Usage: fan_node_sim [--bind <address>] [--port <port>]    (default ::1, port 5540, 0 picks a free port)
+ */
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <app_fan_endpoints.h>
+
+#include "host_node.h"
+
+#define SIM_DEFAULT_PORT        5540
+#define SIM_MAX_SUBSCRIBERS     16
+#define SIM_TICK_MS             10
+
+static int s_socket = -1;
+static std::mutex s_subscriber_mutex;
+static std::vector<sockaddr_storage> s_subscribers;
+
+static uint64_t now_ms()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static socklen_t address_length(const sockaddr_storage &address)
+{
+    return address.ss_family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+}
+
+static bool same_address(const sockaddr_storage &a, const sockaddr_storage &b)
+{
+    return a.ss_family == b.ss_family && memcmp(&a, &b, address_length(a)) == 0;
+}
+
+static bool is_null(const esp_matter_attr_val_t &val)
+{
+    return (val.type == ESP_MATTER_VAL_TYPE_NULLABLE_UINT8 && val.val.u8 == UINT8_MAX) ||
+           (val.type == ESP_MATTER_VAL_TYPE_NULLABLE_INT16 && val.val.i16 == INT16_MIN);
+}
+
+static std::string format_val(const esp_matter_attr_val_t &val)
+{
+    if (is_null(val)) {
+        return "null";
+    }
+    switch (val.type) {
+    case ESP_MATTER_VAL_TYPE_BOOLEAN: return val.val.b ? "1" : "0";
+    case ESP_MATTER_VAL_TYPE_INT16:
+    case ESP_MATTER_VAL_TYPE_NULLABLE_INT16: return std::to_string(val.val.i16);
+    case ESP_MATTER_VAL_TYPE_UINT8:
+    case ESP_MATTER_VAL_TYPE_ENUM8:
+    case ESP_MATTER_VAL_TYPE_BITMAP8:
+    case ESP_MATTER_VAL_TYPE_NULLABLE_UINT8: return std::to_string(val.val.u8);
+    case ESP_MATTER_VAL_TYPE_UINT16: return std::to_string(val.val.u16);
+    case ESP_MATTER_VAL_TYPE_UINT32: return std::to_string(val.val.u32);
+    default: return "invalid";
+    }
+}
+
+/* The value a write of `text` carries, typed like the stored attribute as the Matter stack decodes it */
+static bool parse_val(const char *text, const esp_matter_attr_val_t &stored, esp_matter_attr_val_t *val)
+{
+    *val = stored;
+    if (strcmp(text, "null") == 0) {
+        if (stored.type == ESP_MATTER_VAL_TYPE_NULLABLE_UINT8) {
+            val->val.u8 = UINT8_MAX;
+        } else if (stored.type == ESP_MATTER_VAL_TYPE_NULLABLE_INT16) {
+            val->val.i16 = INT16_MIN;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    char *end = NULL;
+    long value = strtol(text, &end, 0);
+    if (*end != '\0') {
+        return false;
+    }
+    switch (stored.type) {
+    case ESP_MATTER_VAL_TYPE_BOOLEAN: val->val.b = value != 0; return value == 0 || value == 1;
+    case ESP_MATTER_VAL_TYPE_INT16:
+    case ESP_MATTER_VAL_TYPE_NULLABLE_INT16: val->val.i16 = (int16_t)value; return value >= INT16_MIN && value <= INT16_MAX;
+    case ESP_MATTER_VAL_TYPE_UINT8:
+    case ESP_MATTER_VAL_TYPE_ENUM8:
+    case ESP_MATTER_VAL_TYPE_BITMAP8:
+    case ESP_MATTER_VAL_TYPE_NULLABLE_UINT8: val->val.u8 = (uint8_t)value; return value >= 0 && value <= UINT8_MAX;
+    case ESP_MATTER_VAL_TYPE_UINT16: val->val.u16 = (uint16_t)value; return value >= 0 && value <= UINT16_MAX;
+    case ESP_MATTER_VAL_TYPE_UINT32: val->val.u32 = (uint32_t)value; return value >= 0;
+    default: return false;
+    }
+}
+
+static void send_to(const sockaddr_storage &address, const std::string &text)
+{
+    sendto(s_socket, text.data(), text.size(), 0, (const sockaddr *)&address, address_length(address));
+}
+
+static void report_handler(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id,
+                           const esp_matter_attr_val_t *val)
+{
+    std::string text = "report " + std::to_string(endpoint_id) + " " + std::to_string(cluster_id) + " " +
+                       std::to_string(attribute_id) + " " + format_val(*val);
+    std::lock_guard<std::mutex> lock(s_subscriber_mutex);
+    for (const sockaddr_storage &subscriber : s_subscribers) {
+        send_to(subscriber, text);
+    }
+}
+
+static std::string handle_request(char *request, const sockaddr_storage &sender)
+{
+    char *save = NULL;
+    const char *seq = strtok_r(request, " \r\n", &save);
+    const char *command = strtok_r(NULL, " \r\n", &save);
+    if (!seq || !command) {
+        return "0 err request";
+    }
+    std::string reply = std::string(seq) + " ";
+    const char *args[4] = {};
+    int count = 0;
+    for (const char *arg; count < 4 && (arg = strtok_r(NULL, " \r\n", &save)) != NULL;) {
+        args[count++] = arg;
+    }
+
+    if (strcmp(command, "info") == 0) {
+        reply += "ok fans";
+        for (size_t i = 0; i < k_fan_endpoint_count; i++) {
+            reply += " " + std::to_string(host_node_fan_endpoint(i));
+        }
+        return reply + " temperature " + std::to_string(host_node_temperature_endpoint());
+    }
+    if (strcmp(command, "subscribe") == 0) {
+        std::lock_guard<std::mutex> lock(s_subscriber_mutex);
+        for (const sockaddr_storage &subscriber : s_subscribers) {
+            if (same_address(subscriber, sender)) {
+                return reply + "ok";
+            }
+        }
+        if (s_subscribers.size() >= SIM_MAX_SUBSCRIBERS) {
+            return reply + "err subscribers";
+        }
+        s_subscribers.push_back(sender);
+        return reply + "ok";
+    }
+    if (strcmp(command, "duty") == 0 && count == 1) {
+        unsigned long fan = strtoul(args[0], NULL, 0);
+        if (fan >= k_fan_endpoint_count) {
+            return reply + "err fan";
+        }
+        return reply + "ok " + std::to_string(host_node_fan_duty(fan));
+    }
+    if ((strcmp(command, "read") == 0 && count == 3) || (strcmp(command, "write") == 0 && count == 4)) {
+        uint16_t endpoint_id = (uint16_t)strtoul(args[0], NULL, 0);
+        uint32_t cluster_id = (uint32_t)strtoul(args[1], NULL, 0);
+        uint32_t attribute_id = (uint32_t)strtoul(args[2], NULL, 0);
+        esp_matter_attr_val_t stored = host_node_read(endpoint_id, cluster_id, attribute_id);
+        if (stored.type == ESP_MATTER_VAL_TYPE_INVALID) {
+            return reply + "err unsupported attribute";
+        }
+        if (command[0] == 'r') {
+            return reply + "ok " + format_val(stored);
+        }
+        esp_matter_attr_val_t val;
+        if (!parse_val(args[3], stored, &val)) {
+            return reply + "err constraint";
+        }
+        esp_err_t err = host_node_write(endpoint_id, cluster_id, attribute_id, val);
+        return reply + (err == ESP_OK ? "ok" : std::string("err ") + esp_err_to_name(err));
+    }
+    return reply + "err command";
+}
+
+static int open_socket(const char *bind_address, const char *port)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+    addrinfo *result = NULL;
+    int err = getaddrinfo(bind_address, port, &hints, &result);
+    if (err != 0) {
+        fprintf(stderr, "Invalid address %s port %s: %s\n", bind_address, port, gai_strerror(err));
+        return -1;
+    }
+    int fd = socket(result->ai_family, result->ai_socktype, 0);
+    if (fd < 0 || bind(fd, result->ai_addr, result->ai_addrlen) != 0) {
+        perror("bind");
+        if (fd >= 0) {
+            close(fd);
+        }
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+static int bound_port(int fd)
+{
+    sockaddr_storage address = {};
+    socklen_t length = sizeof(address);
+    getsockname(fd, (sockaddr *)&address, &length);
+    return ntohs(address.ss_family == AF_INET6 ? ((sockaddr_in6 *)&address)->sin6_port
+                                               : ((sockaddr_in *)&address)->sin_port);
+}
+
+int main(int argc, char **argv)
+{
+    const char *bind_address = "::1";
+    std::string port = std::to_string(SIM_DEFAULT_PORT);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bind") == 0 && i + 1 < argc) {
+            bind_address = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [--bind <address>] [--port <port>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    s_socket = open_socket(bind_address, port.c_str());
+    if (s_socket < 0) {
+        return 1;
+    }
+    if (host_node_init() != ESP_OK) {
+        fprintf(stderr, "Failed to create the node\n");
+        return 1;
+    }
+    fake_esp_matter_set_report_handler(report_handler);
+    printf("ready %d\n", bound_port(s_socket));
+    fflush(stdout);
+
+    uint64_t clock_ms = now_ms();
+    while (true) {
+        pollfd fd = {s_socket, POLLIN, 0};
+        if (poll(&fd, 1, SIM_TICK_MS) > 0) {
+            char request[256];
+            sockaddr_storage sender = {};
+            socklen_t sender_length = sizeof(sender);
+            ssize_t length = recvfrom(s_socket, request, sizeof(request) - 1, 0, (sockaddr *)&sender, &sender_length);
+            if (length > 0) {
+                request[length] = '\0';
+                send_to(sender, handle_request(request, sender));
+            }
+        }
+        uint64_t now = now_ms();
+        if (now - clock_ms >= SIM_TICK_MS) {
+            host_node_advance_ms((uint32_t)(now - clock_ms));
+            clock_ms = now;
+        }
+    }
+}
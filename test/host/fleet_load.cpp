@@ -0,0 +1,248 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Controller load on a fleet of fan_node_sim instances
+ *
+ * Subscribes to every node on consecutive ports, then writes the PercentSetting of a random fan of node after node at
+ * a fixed total rate, like a controller driving the fleet. The time from a write to its answer is the write latency,
+ * the reports that come back are the subscription load. One CSV line with the results is printed to stdout.
+ *
+ * Usage: fleet_load [--host <address>] [--duration <s>] [--rate <writes/s>] <first port> <count>
+ */
+
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define FAN_CONTROL_CLUSTER_ID      0x0202
+#define PERCENT_SETTING_ID          0x0002
+#define SETUP_TIMEOUT_US            500000
+#define SETUP_ATTEMPTS              5
+#define DRAIN_US                    1000000
+
+typedef struct {
+    sockaddr_storage address;
+    socklen_t address_length;
+    std::vector<unsigned> fan_endpoints;
+    bool subscribed;
+} node_t;
+
+static uint64_t now_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool resolve(const char *host, int port, node_t *node)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    addrinfo *result = NULL;
+    if (getaddrinfo(host, std::to_string(port).c_str(), &hints, &result) != 0) {
+        return false;
+    }
+    memcpy(&node->address, result->ai_addr, result->ai_addrlen);
+    node->address_length = result->ai_addrlen;
+    freeaddrinfo(result);
+    return true;
+}
+
+static int node_of(const std::vector<node_t> &nodes, const sockaddr_storage &address, socklen_t length)
+{
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].address_length == length && memcmp(&nodes[i].address, &address, length) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static void send_request(int fd, const node_t &node, const std::string &text)
+{
+    sendto(fd, text.data(), text.size(), 0, (const sockaddr *)&node.address, node.address_length);
+}
+
+/* Returns the length of the datagram received within the timeout, 0 if none */
+static ssize_t receive(int fd, uint64_t timeout_us, char *buffer, size_t size, sockaddr_storage *sender,
+                       socklen_t *sender_length)
+{
+    pollfd pfd = {fd, POLLIN, 0};
+    if (poll(&pfd, 1, (int)((timeout_us + 999) / 1000)) <= 0) {
+        return 0;
+    }
+    *sender_length = sizeof(*sender);
+    ssize_t length = recvfrom(fd, buffer, size - 1, 0, (sockaddr *)sender, sender_length);
+    if (length > 0) {
+        buffer[length] = '\0';
+    }
+    return length > 0 ? length : 0;
+}
+
+/* Asks every node for its endpoints and subscribes, retrying the nodes that do not answer */
+static bool set_up(int fd, std::vector<node_t> &nodes)
+{
+    for (int attempt = 0; attempt < SETUP_ATTEMPTS; attempt++) {
+        size_t pending = 0;
+        for (const node_t &node : nodes) {
+            if (node.fan_endpoints.empty()) {
+                send_request(fd, node, "1 info");
+            }
+            if (!node.subscribed) {
+                send_request(fd, node, "2 subscribe");
+            }
+            pending += node.fan_endpoints.empty() || !node.subscribed;
+        }
+        if (pending == 0) {
+            return true;
+        }
+        uint64_t end = now_us() + SETUP_TIMEOUT_US;
+        for (uint64_t now = now_us(); now < end; now = now_us()) {
+            char buffer[512];
+            sockaddr_storage sender;
+            socklen_t sender_length;
+            if (!receive(fd, end - now, buffer, sizeof(buffer), &sender, &sender_length)) {
+                continue;
+            }
+            int index = node_of(nodes, sender, sender_length);
+            if (index < 0) {
+                continue;
+            }
+            node_t &node = nodes[index];
+            if (strncmp(buffer, "1 ok fans ", 10) == 0 && node.fan_endpoints.empty()) {
+                char *save = NULL;
+                for (char *token = strtok_r(buffer + 10, " ", &save); token && strcmp(token, "temperature") != 0;
+                     token = strtok_r(NULL, " ", &save)) {
+                    node.fan_endpoints.push_back((unsigned)strtoul(token, NULL, 10));
+                }
+            } else if (strncmp(buffer, "2 ok", 4) == 0) {
+                node.subscribed = true;
+            }
+        }
+    }
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].fan_endpoints.empty() || !nodes[i].subscribed) {
+            fprintf(stderr, "Node %d does not answer\n", (int)i);
+        }
+    }
+    return false;
+}
+
+static uint64_t percentile(const std::vector<uint64_t> &sorted, int percent)
+{
+    return sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, sorted.size() * percent / 100)];
+}
+
+int main(int argc, char **argv)
+{
+    const char *host = "::1";
+    double duration_s = 10;
+    double rate = 100;
+    int arg = 1;
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+        if (strcmp(argv[arg], "--host") == 0) {
+            host = argv[arg + 1];
+        } else if (strcmp(argv[arg], "--duration") == 0) {
+            duration_s = atof(argv[arg + 1]);
+        } else if (strcmp(argv[arg], "--rate") == 0) {
+            rate = atof(argv[arg + 1]);
+        } else {
+            break;
+        }
+    }
+    if (argc - arg != 2 || rate <= 0 || duration_s <= 0) {
+        fprintf(stderr, "Usage: %s [--host <address>] [--duration <s>] [--rate <writes/s>] <first port> <count>\n",
+                argv[0]);
+        return 2;
+    }
+    int first_port = atoi(argv[arg]);
+    int count = atoi(argv[arg + 1]);
+
+    std::vector<node_t> nodes(count > 0 ? count : 0);
+    for (int i = 0; i < count; i++) {
+        if (!resolve(host, first_port + i, &nodes[i])) {
+            fprintf(stderr, "Invalid address %s\n", host);
+            return 2;
+        }
+    }
+    int fd = count > 0 ? socket(nodes[0].address.ss_family, SOCK_DGRAM, 0) : -1;
+    if (fd < 0) {
+        fprintf(stderr, "No nodes\n");
+        return 2;
+    }
+    /* Reports of hundreds of nodes arrive in bursts */
+    int buffer_size = 4 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    if (!set_up(fd, nodes)) {
+        return 1;
+    }
+
+    srand(1);
+    std::unordered_map<uint32_t, uint64_t> pending;
+    std::vector<uint64_t> latencies;
+    uint32_t writes = 0, errors = 0, reports = 0;
+    uint64_t interval_us = (uint64_t)(1000000 / rate);
+    uint64_t start = now_us();
+    uint64_t end = start + (uint64_t)(duration_s * 1000000);
+    uint64_t next_write = start;
+    for (uint64_t now = start; now < end + DRAIN_US && (now < end || !pending.empty()); now = now_us()) {
+        while (now < end && next_write <= now) {
+            const node_t &node = nodes[writes % nodes.size()];
+            uint32_t seq = 100 + writes;
+            unsigned endpoint = node.fan_endpoints[rand() % node.fan_endpoints.size()];
+            send_request(fd, node, std::to_string(seq) + " write " + std::to_string(endpoint) + " " +
+                                       std::to_string(FAN_CONTROL_CLUSTER_ID) + " " +
+                                       std::to_string(PERCENT_SETTING_ID) + " " + std::to_string(rand() % 101));
+            pending[seq] = now_us();
+            writes++;
+            next_write += interval_us;
+        }
+        uint64_t wait_us = now < end ? (next_write > now ? next_write - now : 0) : end + DRAIN_US - now;
+        char buffer[512];
+        sockaddr_storage sender;
+        socklen_t sender_length;
+        while (receive(fd, wait_us, buffer, sizeof(buffer), &sender, &sender_length)) {
+            wait_us = 0;
+            if (strncmp(buffer, "report ", 7) == 0) {
+                reports++;
+                continue;
+            }
+            char *rest = NULL;
+            uint32_t seq = (uint32_t)strtoul(buffer, &rest, 10);
+            auto it = pending.find(seq);
+            if (it == pending.end()) {
+                continue;
+            }
+            latencies.push_back(now_us() - it->second);
+            errors += strncmp(rest, " ok", 3) != 0;
+            pending.erase(it);
+        }
+    }
+    double elapsed_s = (now_us() - start) / 1e6;
+    close(fd);
+
+    std::sort(latencies.begin(), latencies.end());
+    printf("nodes,writes,answered,errors,lost,p50_us,p99_us,max_us,reports,reports_per_s\n");
+    printf("%d,%u,%u,%u,%u,%llu,%llu,%llu,%u,%.0f\n", count, writes, (unsigned)latencies.size(), errors,
+           (unsigned)pending.size(), (unsigned long long)percentile(latencies, 50),
+           (unsigned long long)percentile(latencies, 99),
+           (unsigned long long)(latencies.empty() ? 0 : latencies.back()), reports, reports / elapsed_s);
+    return pending.empty() && errors == 0 ? 0 : 1;
+}
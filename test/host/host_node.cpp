@@ -0,0 +1,175 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <iot_button.h>
+#include <platform/CHIPDeviceLayer.h>
+#include "driver/ledc.h"
+#include "freertos/task.h"
+
+#include <app_fan_endpoints.h>
+#include <app_persist.h>
+
+#include "host_node.h"
+
+using namespace chip::app::Clusters;
+using namespace esp_matter;
+
+static const char *TAG = "host_node";
+
+static uint16_t s_fan_endpoint_ids[CONFIG_FAN_COUNT];
+static uint16_t s_temperature_endpoint_id;
+static app_driver_handle_t s_button;
+static bool s_initialized;
+
+/* Clusters of the Root Node device type as esp-matter creates them: Descriptor, Access Control, Basic Information,
+   General Commissioning, Network Commissioning, General Diagnostics, Administrator Commissioning, Operational
+   Credentials and Group Key Management */
+static const uint32_t k_root_cluster_ids[] = { 0x001D, 0x001F, 0x0028, 0x0030, 0x0031, 0x0033, 0x003C, 0x003E, 0x003F };
+
+/* A cluster with the global attributes every cluster starts with, so lookups walk as far as on the device */
+static cluster_t *create_cluster(endpoint_t *endpoint, uint32_t cluster_id)
+{
+    cluster_t *cluster = cluster::create(endpoint, cluster_id, CLUSTER_FLAG_SERVER);
+    attribute::create(cluster, Globals::Attributes::FeatureMap::Id, ATTRIBUTE_FLAG_NONE, esp_matter_uint32(0));
+    attribute::create(cluster, Globals::Attributes::ClusterRevision::Id, ATTRIBUTE_FLAG_NONE, esp_matter_uint16(1));
+    return cluster;
+}
+
+static esp_err_t app_attribute_update_cb(attribute::callback_type_t type, uint16_t endpoint_id, uint32_t cluster_id,
+                                         uint32_t attribute_id, esp_matter_attr_val_t *val, void *priv_data)
+{
+    if (type != attribute::PRE_UPDATE) {
+        return ESP_OK;
+    }
+    return app_driver_attribute_update((app_driver_handle_t)priv_data, endpoint_id, cluster_id, attribute_id, val);
+}
+
+/* A Fan endpoint with Groups and Scenes Management as app_main() creates it, FanControl with the Multi-Speed
+   feature seeded from the persisted state */
+static endpoint_t *create_fan_endpoint(node_t *node, const app_fan_endpoint_config_t &fan, app_driver_handle_t handle)
+{
+    uint8_t fan_mode = APP_FAN_MODE_OFF;
+    uint8_t percent = 0;
+    app_persist_fan_t restored;
+    if (app_persist_get_fan(fan.channel, &restored) == ESP_OK && restored.percent <= 100 &&
+        restored.fan_mode < k_fan_mode_count) {
+        fan_mode = restored.fan_mode;
+        percent = restored.percent;
+    }
+    uint8_t speed = app_fan_percent_to_speed(percent, CONFIG_FAN_SPEED_MAX);
+
+    endpoint_t *endpoint = endpoint::create(node, ENDPOINT_FLAG_NONE, handle);
+    create_cluster(endpoint, Descriptor::Id);
+    create_cluster(endpoint, Identify::Id);
+    create_cluster(endpoint, Groups::Id);
+    cluster_t *cluster = create_cluster(endpoint, FanControl::Id);
+    attribute::create(cluster, FanControl::Attributes::FanMode::Id, ATTRIBUTE_FLAG_WRITABLE, esp_matter_enum8(fan_mode));
+    attribute::create(cluster, FanControl::Attributes::FanModeSequence::Id, ATTRIBUTE_FLAG_NONE,
+                      esp_matter_enum8(fan.fan_mode_sequence));
+    attribute::create(cluster, FanControl::Attributes::PercentSetting::Id,
+                      ATTRIBUTE_FLAG_WRITABLE | ATTRIBUTE_FLAG_NULLABLE, esp_matter_nullable_uint8(percent));
+    attribute::create(cluster, FanControl::Attributes::PercentCurrent::Id, ATTRIBUTE_FLAG_NONE,
+                      esp_matter_uint8(percent));
+    attribute::create(cluster, FanControl::Attributes::SpeedMax::Id, ATTRIBUTE_FLAG_NONE,
+                      esp_matter_uint8(CONFIG_FAN_SPEED_MAX));
+    attribute::create(cluster, FanControl::Attributes::SpeedSetting::Id,
+                      ATTRIBUTE_FLAG_WRITABLE | ATTRIBUTE_FLAG_NULLABLE, esp_matter_nullable_uint8(speed));
+    attribute::create(cluster, FanControl::Attributes::SpeedCurrent::Id, ATTRIBUTE_FLAG_NONE, esp_matter_uint8(speed));
+    create_cluster(endpoint, ScenesManagement::Id);
+    return endpoint;
+}
+
+esp_err_t host_node_init()
+{
+    if (s_initialized) {
+        return ESP_OK;
+    }
+    app_driver_handle_t fan_handle = app_driver_fan_init();
+    attribute::set_callback(app_attribute_update_cb);
+    node_t *node = node::create_raw();
+    endpoint_t *root = endpoint::create(node, ENDPOINT_FLAG_NONE, NULL);
+    for (uint32_t cluster_id : k_root_cluster_ids) {
+        create_cluster(root, cluster_id);
+    }
+
+    for (size_t i = 0; i < k_fan_endpoint_count; i++) {
+        endpoint_t *endpoint = create_fan_endpoint(node, k_fan_endpoints[i], fan_handle);
+        s_fan_endpoint_ids[i] = endpoint::get_id(endpoint);
+        esp_err_t err = app_driver_fan_bind_endpoint(fan_handle, i, s_fan_endpoint_ids[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to bind fan %d", (int)i);
+            return err;
+        }
+    }
+
+    endpoint_t *temperature = endpoint::create(node, ENDPOINT_FLAG_NONE, fan_handle);
+    create_cluster(temperature, Descriptor::Id);
+    create_cluster(temperature, Identify::Id);
+    cluster_t *cluster = create_cluster(temperature, TemperatureMeasurement::Id);
+    attribute::create(cluster, TemperatureMeasurement::Attributes::MeasuredValue::Id, ATTRIBUTE_FLAG_NULLABLE,
+                      esp_matter_nullable_int16(INT16_MIN));
+    s_temperature_endpoint_id = endpoint::get_id(temperature);
+
+    gpio_num_t reset_gpio;
+    s_button = app_driver_button_init(&reset_gpio);
+    app_driver_button_register_local_control(s_button);
+    s_initialized = true;
+    host_node_settle();
+    return ESP_OK;
+}
+
+uint16_t host_node_fan_endpoint(size_t fan_index)
+{
+    return s_fan_endpoint_ids[fan_index];
+}
+
+uint16_t host_node_temperature_endpoint()
+{
+    return s_temperature_endpoint_id;
+}
+
+app_driver_handle_t host_node_button()
+{
+    return s_button;
+}
+
+void host_node_settle()
+{
+    do {
+        fake_task_wait_idle();
+    } while (fake_chip_run_work() > 0);
+}
+
+esp_err_t host_node_write(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id, esp_matter_attr_val_t val)
+{
+    esp_err_t err = attribute::update(endpoint_id, cluster_id, attribute_id, &val);
+    host_node_settle();
+    return err;
+}
+
+void host_node_advance_ms(uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i += 10) {
+        fake_esp_timer_advance((ms - i < 10 ? ms - i : 10) * 1000);
+        host_node_settle();
+    }
+}
+
+esp_matter_attr_val_t host_node_read(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id)
+{
+    esp_matter_attr_val_t val = esp_matter_invalid(NULL);
+    attribute::get_val(attribute::get(endpoint_id, cluster_id, attribute_id), &val);
+    return val;
+}
+
+uint32_t host_node_fan_duty(size_t fan_index)
+{
+    return fake_ledc_target((ledc_channel_t)(LEDC_CHANNEL_0 + k_fan_endpoints[fan_index].channel));
+}
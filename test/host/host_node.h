@@ -0,0 +1,53 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* The node app_main() builds, on the fake data model: the root endpoint 0, one FanControl endpoint per entry of
+ * k_fan_endpoints driven by main/app_driver.cpp and a TemperatureMeasurement endpoint for the Auto mode.
+ *
+ * The calling thread plays the CHIP thread, the driver task runs on a thread of its own.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <esp_matter.h>
+#include <app_priv.h>
+
+/** Create the node and start the driver, once per process
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t host_node_init();
+
+uint16_t host_node_fan_endpoint(size_t fan_index);
+uint16_t host_node_temperature_endpoint();
+app_driver_handle_t host_node_button();
+
+/** Write an attribute like a Matter client and wait until the node has handled it
+ *
+ * The write runs the attribute callback and is stored if the callback accepts it. The work the callback
+ * scheduled on the CHIP thread and the driver task's commit are done when this returns.
+ *
+ * @return result of the attribute callback.
+ */
+esp_err_t host_node_write(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id, esp_matter_attr_val_t val);
+
+/** Run the queued CHIP work and wait for the driver task until neither has anything left to do */
+void host_node_settle();
+
+/** Move the virtual clock forward, firing the tach, report and pulse timers, and settle after each step */
+void host_node_advance_ms(uint32_t ms);
+
+/** Stored value of an attribute, the invalid value if it does not exist */
+esp_matter_attr_val_t host_node_read(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id);
+
+/** Duty the LEDC channel of a fan ends up at */
+uint32_t host_node_fan_duty(size_t fan_index);
@@ -0,0 +1,74 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host_test.h"
+
+#define HOST_TEST_MAX 256
+
+typedef struct {
+    const char *name;
+    host_test_fn_t fn;
+} host_test_t;
+
+static host_test_t s_tests[HOST_TEST_MAX];
+static int s_test_count;
+static int s_failures;
+
+host_test_registrar::host_test_registrar(const char *name, host_test_fn_t fn)
+{
+    if (s_test_count < HOST_TEST_MAX) {
+        s_tests[s_test_count++] = {name, fn};
+    }
+}
+
+void host_test_fail(const char *file, int line, const char *expression)
+{
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    s_failures++;
+}
+
+void host_test_fail_eq(const char *file, int line, const char *expression, long long actual, long long expected)
+{
+    fprintf(stderr, "%s:%d: check failed: %s, got %lld, expected %lld\n", file, line, expression, actual, expected);
+    s_failures++;
+}
+
+static bool selected(int argc, char **argv, const char *name)
+{
+    if (argc < 2) {
+        return true;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    int run = 0;
+    for (int i = 0; i < s_test_count; i++) {
+        if (!selected(argc, argv, s_tests[i].name)) {
+            continue;
+        }
+        int failures = s_failures;
+        s_tests[i].fn();
+        printf("%s %s\n", s_failures == failures ? "PASS" : "FAIL", s_tests[i].name);
+        run++;
+    }
+    if (run == 0) {
+        fprintf(stderr, "No test matched\n");
+        return 1;
+    }
+    return s_failures ? 1 : 0;
+}
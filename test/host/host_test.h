@@ -0,0 +1,48 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Minimal test runner of the host build
+ *
+ * A test is a function defined with HOST_TEST(). The CHECK macros record a failure with its location and let the
+ * test continue, so one run shows every broken expectation. The runner exits with 1 if any check failed. Passing
+ * test names on the command line runs only those.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef void (*host_test_fn_t)();
+
+struct host_test_registrar {
+    host_test_registrar(const char *name, host_test_fn_t fn);
+};
+
+void host_test_fail(const char *file, int line, const char *expression);
+void host_test_fail_eq(const char *file, int line, const char *expression, long long actual, long long expected);
+
+#define HOST_TEST(name)                                                \
+    static void name();                                                \
+    static host_test_registrar name##_registrar(#name, name);         \
+    static void name()
+
+#define CHECK(condition)                                               \
+    do {                                                               \
+        if (!(condition)) {                                            \
+            host_test_fail(__FILE__, __LINE__, #condition);            \
+        }                                                              \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                        \
+    do {                                                                                                  \
+        long long actual_ = (long long)(actual);                                                          \
+        long long expected_ = (long long)(expected);                                                      \
+        if (actual_ != expected_) {                                                                       \
+            host_test_fail_eq(__FILE__, __LINE__, #actual " == " #expected, actual_, expected_);          \
+        }                                                                                                 \
+    } while (0)
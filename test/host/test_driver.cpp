@@ -0,0 +1,208 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Attribute writes through the real attribute callback of main/app_driver.cpp, down to the LEDC channels */
+
+#include <freertos/FreeRTOS.h>
+#include <platform/CHIPDeviceLayer.h>
+#include "driver/ledc.h"
+
+#include <app_fan_bank.h>
+#include <app_persist.h>
+
+#include "host_node.h"
+#include "host_test.h"
+
+using namespace chip::app::Clusters;
+
+static uint8_t read_u8(size_t fan, uint32_t attribute_id)
+{
+    return host_node_read(host_node_fan_endpoint(fan), FanControl::Id, attribute_id).val.u8;
+}
+
+static esp_err_t write_fan(size_t fan, uint32_t attribute_id, esp_matter_attr_val_t val)
+{
+    return host_node_write(host_node_fan_endpoint(fan), FanControl::Id, attribute_id, val);
+}
+
+static uint32_t duty_of(uint8_t percent)
+{
+    return ((uint32_t)percent * (FAN_BANK_DUTY_MAX - 1)) / 100;
+}
+
+HOST_TEST(percent_write_selects_mode_and_duty)
+{
+    CHECK_EQ(host_node_init(), ESP_OK);
+    CHECK_EQ(write_fan(0, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(10)), ESP_OK);
+    CHECK_EQ(read_u8(0, FanControl::Attributes::FanMode::Id), APP_FAN_MODE_LOW);
+    CHECK_EQ(read_u8(0, FanControl::Attributes::PercentSetting::Id), 10);
+    CHECK_EQ(read_u8(0, FanControl::Attributes::SpeedSetting::Id), 1);
+    CHECK_EQ(host_node_fan_duty(0), duty_of(10));
+
+    CHECK_EQ(write_fan(0, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(50)), ESP_OK);
+    CHECK_EQ(read_u8(0, FanControl::Attributes::FanMode::Id), APP_FAN_MODE_MEDIUM);
+    CHECK_EQ(host_node_fan_duty(0), duty_of(50));
+
+    app_persist_fan_t persisted = {};
+    CHECK_EQ(app_persist_get_fan(0, &persisted), ESP_OK);
+    CHECK_EQ(persisted.fan_mode, APP_FAN_MODE_MEDIUM);
+    CHECK_EQ(persisted.percent, 50);
+}
+
+HOST_TEST(mode_write_moves_percent_into_band)
+{
+    CHECK_EQ(host_node_init(), ESP_OK);
+    CHECK_EQ(write_fan(0, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(20)), ESP_OK);
+    CHECK_EQ(write_fan(0, FanControl::Attributes::FanMode::Id, esp_matter_enum8(APP_FAN_MODE_HIGH)), ESP_OK);
+    CHECK_EQ(read_u8(0, FanControl::Attributes::FanMode::Id), APP_FAN_MODE_HIGH);
+    CHECK_EQ(read_u8(0, FanControl::Attributes::PercentSetting::Id), HIGH_MODE_PERCENT_MAX);
+    CHECK_EQ(read_u8(0, FanControl::Attributes::SpeedSetting::Id), CONFIG_FAN_SPEED_MAX);
+    CHECK_EQ(host_node_fan_duty(0), duty_of(HIGH_MODE_PERCENT_MAX));
+
+    /* A percent already inside the band of the new mode stays */
+    CHECK_EQ(write_fan(0, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(70)), ESP_OK);
+    CHECK_EQ(write_fan(0, FanControl::Attributes::FanMode::Id, esp_matter_enum8(APP_FAN_MODE_HIGH)), ESP_OK);
+    CHECK_EQ(read_u8(0, FanControl::Attributes::PercentSetting::Id), 70);
+
+    CHECK_EQ(write_fan(0, FanControl::Attributes::FanMode::Id, esp_matter_enum8(APP_FAN_MODE_OFF)), ESP_OK);
+    CHECK_EQ(read_u8(0, FanControl::Attributes::PercentSetting::Id), 0);
+    CHECK_EQ(host_node_fan_duty(0), 0);
+}
+
+/* esp-matter stores the written value after the callback, the correction must land after that */
+HOST_TEST(unsupported_mode_is_corrected_after_the_write_is_stored)
+{
+    CHECK_EQ(host_node_init(), ESP_OK);
+    CHECK_EQ(write_fan(1, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(10)), ESP_OK);
+    CHECK_EQ(write_fan(1, FanControl::Attributes::FanMode::Id, esp_matter_enum8(APP_FAN_MODE_ON)), ESP_OK);
+    CHECK_EQ(read_u8(1, FanControl::Attributes::FanMode::Id), APP_FAN_MODE_HIGH);
+    CHECK_EQ(read_u8(1, FanControl::Attributes::PercentSetting::Id), HIGH_MODE_PERCENT_MAX);
+    CHECK_EQ(host_node_fan_duty(1), duty_of(HIGH_MODE_PERCENT_MAX));
+    /* Subscribers were sent the unsupported mode with the write, the correction has to reach them too */
+    CHECK_EQ(fake_esp_matter_reported_val(host_node_fan_endpoint(1), FanControl::Id, FanControl::Attributes::FanMode::Id)
+                 .val.u8,
+             APP_FAN_MODE_HIGH);
+}
+
+HOST_TEST(speed_write_sets_percent_and_mode)
+{
+    CHECK_EQ(host_node_init(), ESP_OK);
+    CHECK_EQ(write_fan(2, FanControl::Attributes::SpeedSetting::Id, esp_matter_nullable_uint8(5)), ESP_OK);
+    CHECK_EQ(read_u8(2, FanControl::Attributes::PercentSetting::Id), 50);
+    CHECK_EQ(read_u8(2, FanControl::Attributes::FanMode::Id), APP_FAN_MODE_MEDIUM);
+    CHECK_EQ(host_node_fan_duty(2), duty_of(50));
+}
+
+HOST_TEST(null_writes_are_ignored)
+{
+    CHECK_EQ(host_node_init(), ESP_OK);
+    CHECK_EQ(write_fan(2, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(40)), ESP_OK);
+    uint32_t writes = fake_ledc_write_count();
+    write_fan(2, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(UINT8_MAX));
+    CHECK_EQ(fake_ledc_write_count(), writes);
+    CHECK_EQ(host_node_fan_duty(2), duty_of(40));
+}
+
+/* A group write reaches every fan in one driver commit, woken by one flush on the CHIP thread */
+HOST_TEST(group_write_is_one_flush)
+{
+    CHECK_EQ(host_node_init(), ESP_OK);
+    for (size_t i = 0; i < CONFIG_FAN_COUNT; i++) {
+        esp_matter_attr_val_t val = esp_matter_nullable_uint8(60);
+        CHECK_EQ(esp_matter::attribute::update(host_node_fan_endpoint(i), FanControl::Id,
+                                               FanControl::Attributes::PercentSetting::Id, &val),
+                 ESP_OK);
+    }
+    CHECK_EQ(fake_chip_run_work(), 1);
+    host_node_settle();
+    for (size_t i = 0; i < CONFIG_FAN_COUNT; i++) {
+        CHECK_EQ(host_node_fan_duty(i), duty_of(60));
+    }
+}
+
+HOST_TEST(failed_flush_wakes_the_driver_directly)
+{
+    CHECK_EQ(host_node_init(), ESP_OK);
+    fake_chip_fail_schedule_work(1);
+    CHECK_EQ(write_fan(3, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(25)), ESP_OK);
+    CHECK_EQ(host_node_fan_duty(3), duty_of(25));
+    /* The next write is flushed the normal way again */
+    CHECK_EQ(write_fan(3, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(30)), ESP_OK);
+    CHECK_EQ(host_node_fan_duty(3), duty_of(30));
+}
+
+/* The CHIP thread never blocks on the driver, a full command ring rejects the write */
+HOST_TEST(full_command_ring_rejects_writes)
+{
+    CHECK_EQ(host_node_init(), ESP_OK);
+    esp_err_t err = ESP_OK;
+    int accepted = 0;
+    for (int i = 0; i < 64 && err == ESP_OK; i++) {
+        esp_matter_attr_val_t val = esp_matter_nullable_uint8(1 + i % 100);
+        err = esp_matter::attribute::update(host_node_fan_endpoint(0), FanControl::Id,
+                                            FanControl::Attributes::PercentSetting::Id, &val);
+        accepted += err == ESP_OK;
+    }
+    CHECK_EQ(err, ESP_ERR_NO_MEM);
+    CHECK(accepted > 0 && accepted < 64);
+    host_node_settle();
+    CHECK_EQ(host_node_fan_duty(0), duty_of(accepted));
+    CHECK_EQ(write_fan(0, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(90)), ESP_OK);
+    CHECK_EQ(host_node_fan_duty(0), duty_of(90));
+}
+
+HOST_TEST(auto_mode_follows_temperature)
+{
+    CHECK_EQ(host_node_init(), ESP_OK);
+    CHECK_EQ(write_fan(1, FanControl::Attributes::FanMode::Id, esp_matter_enum8(APP_FAN_MODE_AUTO)), ESP_OK);
+    CHECK_EQ(host_node_write(host_node_temperature_endpoint(), TemperatureMeasurement::Id,
+                             TemperatureMeasurement::Attributes::MeasuredValue::Id,
+                             esp_matter_nullable_int16((CONFIG_FAN_AUTO_TEMP_MIN + CONFIG_FAN_AUTO_TEMP_MAX) * 50)),
+             ESP_OK);
+    uint8_t percent = (CONFIG_FAN_AUTO_PERCENT_MIN + 100) / 2;
+    CHECK_EQ(host_node_fan_duty(1), duty_of(percent));
+    CHECK_EQ(read_u8(1, FanControl::Attributes::FanMode::Id), APP_FAN_MODE_AUTO);
+
+    CHECK_EQ(host_node_write(host_node_temperature_endpoint(), TemperatureMeasurement::Id,
+                             TemperatureMeasurement::Attributes::MeasuredValue::Id,
+                             esp_matter_nullable_int16(CONFIG_FAN_AUTO_TEMP_MAX * 100)),
+             ESP_OK);
+    CHECK_EQ(host_node_fan_duty(1), duty_of(100));
+    /* Fans outside Auto do not follow */
+    CHECK_EQ(host_node_fan_duty(2), duty_of(read_u8(2, FanControl::Attributes::PercentSetting::Id)));
+
+    CHECK_EQ(write_fan(1, FanControl::Attributes::FanMode::Id, esp_matter_enum8(APP_FAN_MODE_LOW)), ESP_OK);
+    CHECK_EQ(host_node_fan_duty(1), duty_of(LOW_MODE_PERCENT_MAX));
+}
+
+/* A ramp of the output is reported a few times, not on every 100 ms sample */
+HOST_TEST(percent_current_reports_are_coalesced)
+{
+    CHECK_EQ(host_node_init(), ESP_OK);
+    CHECK_EQ(write_fan(3, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(0)), ESP_OK);
+    host_node_advance_ms(30000);
+    uint32_t reports = fake_esp_matter_report_count();
+    CHECK_EQ(write_fan(3, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(100)), ESP_OK);
+    host_node_advance_ms(30000);
+    reports = fake_esp_matter_report_count() - reports;
+    uint8_t current = read_u8(3, FanControl::Attributes::PercentCurrent::Id);
+    CHECK(current >= 100 - CONFIG_FAN_REPORT_MIN_DELTA);
+    CHECK(reports > 0);
+    CHECK(reports <= 30000 / CONFIG_FAN_REPORT_MIN_INTERVAL_MS);
+}
+
+HOST_TEST(identify_pulse_restores_the_speed)
+{
+    CHECK_EQ(host_node_init(), ESP_OK);
+    CHECK_EQ(write_fan(2, FanControl::Attributes::PercentSetting::Id, esp_matter_nullable_uint8(20)), ESP_OK);
+    CHECK_EQ(app_driver_fan_identify_pulse(NULL, host_node_fan_endpoint(2)), ESP_OK);
+    host_node_settle();
+    CHECK_EQ(host_node_fan_duty(2), duty_of(CONFIG_FAN_IDENTIFY_PULSE_PERCENT));
+    host_node_advance_ms(CONFIG_FAN_IDENTIFY_PULSE_MS + 10);
+    CHECK_EQ(host_node_fan_duty(2), duty_of(20));
+}
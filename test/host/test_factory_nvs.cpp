@@ -0,0 +1,212 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* The lookup of main/app_factory_nvs.h the factory data provider runs on the fctry mapping, run on the
+ * partition images tools/mfg generated into out/
+ *
+ * Every item of an image's internal/partition.csv has to be found with the value the CSV gives, blobs are compared
+ * with the files next to the image where they exist. Damaged copies of the images check that the lookup skips what
+ * nvs_flash would skip.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <app_factory_nvs.h>
+
+#include "host_test.h"
+
+#define FACTORY_NAMESPACE   "chip-factory"
+#define IMAGE_SUFFIX        "-partition.bin"
+
+namespace fs = std::filesystem;
+
+static uint32_t zlib_crc32(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    return (uint32_t)crc32(crc, buf, len);
+}
+
+static std::vector<uint8_t> read_file(const fs::path &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static std::vector<fs::path> find_images()
+{
+    std::vector<fs::path> images;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(HOST_MFG_OUT_DIR, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.size() > strlen(IMAGE_SUFFIX) &&
+            name.compare(name.size() - strlen(IMAGE_SUFFIX), strlen(IMAGE_SUFFIX), IMAGE_SUFFIX) == 0) {
+            images.push_back(it->path());
+        }
+    }
+    return images;
+}
+
+/* The CSV holds the paths of the machine the batch ran on, the DAC files are also next to the image */
+static fs::path local_blob_path(const fs::path &image_path, const std::string &value)
+{
+    fs::path local = image_path.parent_path() / "internal" / fs::path(value).filename();
+    return fs::exists(local) ? local : fs::path();
+}
+
+static bool find(const std::vector<uint8_t> &image, const char *key, uint8_t type, app_factory_nvs_item_t *item)
+{
+    return app_factory_nvs_find(image.data(), image.size(), FACTORY_NAMESPACE, key, type, zlib_crc32, item);
+}
+
+/* Returns the number of items checked */
+static int check_image(const fs::path &image_path)
+{
+    std::vector<uint8_t> image = read_file(image_path);
+    CHECK(!image.empty() && image.size() % APP_FACTORY_NVS_PAGE_SIZE == 0);
+
+    std::ifstream csv(image_path.parent_path() / "internal" / "partition.csv");
+    CHECK(csv.good());
+    int checked = 0;
+    std::string line;
+    while (std::getline(csv, line)) {
+        /* key,type,encoding,value with CRLF line ends, as mfg_batch writes it */
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        size_t first = line.find(',');
+        size_t second = line.find(',', first + 1);
+        size_t third = line.find(',', second + 1);
+        if (third == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, first);
+        std::string kind = line.substr(first + 1, second - first - 1);
+        std::string encoding = line.substr(second + 1, third - second - 1);
+        std::string value = line.substr(third + 1);
+        if (kind != "data" && kind != "file") {
+            continue;
+        }
+
+        app_factory_nvs_item_t item;
+        bool found = false;
+        if (encoding == "u8" || encoding == "u16" || encoding == "u32") {
+            uint8_t type = encoding == "u8"    ? APP_FACTORY_NVS_TYPE_U8
+                           : encoding == "u16" ? APP_FACTORY_NVS_TYPE_U16
+                                               : APP_FACTORY_NVS_TYPE_U32;
+            found = find(image, key.c_str(), type, &item);
+            CHECK(found && item.value == strtoul(value.c_str(), NULL, 0));
+        } else if (encoding == "string") {
+            found = find(image, key.c_str(), APP_FACTORY_NVS_TYPE_STR, &item);
+            CHECK(found && std::string((const char *)item.data, item.size) == value);
+        } else if (encoding == "binary") {
+            found = find(image, key.c_str(), APP_FACTORY_NVS_TYPE_BLOB, &item);
+            CHECK(found && item.size > 0);
+            fs::path local = local_blob_path(image_path, value);
+            if (found && !local.empty()) {
+                std::vector<uint8_t> expected = read_file(local);
+                CHECK(item.size == expected.size() && memcmp(item.data, expected.data(), item.size) == 0);
+            }
+        } else {
+            fprintf(stderr, "%s: unknown encoding '%s' of %s\n", image_path.c_str(), encoding.c_str(), key.c_str());
+            CHECK(false);
+        }
+        if (!found) {
+            fprintf(stderr, "%s: %s not found\n", image_path.filename().c_str(), key.c_str());
+        }
+        /* Strings and blobs point into the image, like into the flash mapping on the device */
+        CHECK(!found || item.data == NULL || (item.data > image.data() && item.data + item.size <= image.data() +
+                                                                                             image.size()));
+        checked++;
+    }
+    return checked;
+}
+
+HOST_TEST(every_item_of_the_generated_images_is_found)
+{
+    std::vector<fs::path> images = find_images();
+    CHECK(!images.empty());
+    for (const fs::path &image_path : images) {
+        int checked = check_image(image_path);
+        printf("  %s: %d items\n", image_path.filename().c_str(), checked);
+        /* Discriminator, iteration count, salt, verifier, IDs, serial number, DAC, PAI and CD */
+        CHECK(checked >= 12);
+    }
+}
+
+HOST_TEST(missing_keys_and_namespaces_are_not_found)
+{
+    std::vector<fs::path> images = find_images();
+    CHECK(!images.empty());
+    if (images.empty()) {
+        return;
+    }
+    std::vector<uint8_t> image = read_file(images[0]);
+    app_factory_nvs_item_t item;
+    CHECK(!find(image, "no-such-key", APP_FACTORY_NVS_TYPE_U32, &item));
+    /* The right key with the wrong type */
+    CHECK(!find(image, "discriminator", APP_FACTORY_NVS_TYPE_STR, &item));
+    CHECK(!find(image, "dac-cert", APP_FACTORY_NVS_TYPE_STR, &item));
+    CHECK(!app_factory_nvs_find(image.data(), image.size(), "chip-config", "discriminator", APP_FACTORY_NVS_TYPE_U32,
+                                zlib_crc32, &item));
+    /* A truncated image has no whole page */
+    CHECK(!app_factory_nvs_find(image.data(), APP_FACTORY_NVS_PAGE_SIZE - 1, FACTORY_NAMESPACE, "discriminator",
+                                APP_FACTORY_NVS_TYPE_U32, zlib_crc32, &item));
+}
+
+/* Damage nvs_flash would detect makes the lookup fail rather than return wrong data */
+HOST_TEST(damaged_images_are_rejected)
+{
+    std::vector<fs::path> images = find_images();
+    CHECK(!images.empty());
+    if (images.empty()) {
+        return;
+    }
+    const std::vector<uint8_t> original = read_file(images[0]);
+    app_factory_nvs_item_t item;
+    CHECK(find(original, "dac-cert", APP_FACTORY_NVS_TYPE_BLOB, &item));
+    size_t dac_offset = item.data - original.data();
+    CHECK(find(original, "discriminator", APP_FACTORY_NVS_TYPE_U32, &item));
+
+    /* A flipped bit in the blob data fails the data CRC */
+    std::vector<uint8_t> image = original;
+    image[dac_offset + 10] ^= 0x01;
+    CHECK(!find(image, "dac-cert", APP_FACTORY_NVS_TYPE_BLOB, &item));
+    CHECK(find(image, "discriminator", APP_FACTORY_NVS_TYPE_U32, &item));
+
+    /* A page with a broken header CRC is skipped as a whole */
+    image = original;
+    image[28] ^= 0x01;
+    CHECK(!find(image, "discriminator", APP_FACTORY_NVS_TYPE_U32, &item));
+
+    /* So is an uninitialized page */
+    image = original;
+    memset(image.data(), 0xFF, 4);
+    CHECK(!find(image, "discriminator", APP_FACTORY_NVS_TYPE_U32, &item));
+
+    /* An entry marked erased in the page's state bitmap is skipped */
+    image = original;
+    bool erased = false;
+    for (unsigned index = 0; index < APP_FACTORY_NVS_ENTRY_COUNT && !erased; index++) {
+        const uint8_t *entry = &image[2 * APP_FACTORY_NVS_ENTRY_SIZE + index * APP_FACTORY_NVS_ENTRY_SIZE];
+        if (entry[1] == APP_FACTORY_NVS_TYPE_U32 && strncmp((const char *)entry + 8, "discriminator", 16) == 0) {
+            image[APP_FACTORY_NVS_ENTRY_SIZE + index / 4] &= ~(3 << ((index % 4) * 2));
+            erased = true;
+        }
+    }
+    CHECK(erased);
+    CHECK(!find(image, "discriminator", APP_FACTORY_NVS_TYPE_U32, &item));
+    CHECK(find(image, "salt", APP_FACTORY_NVS_TYPE_STR, &item));
+}
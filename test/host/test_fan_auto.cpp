@@ -0,0 +1,192 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Temperature traces in traces/ replayed through the Auto mode controller of app_fan_auto.h and through the
+ * MeasuredValue callback of the driver
+ *
+ * A trace is a CSV file, one sample per CONFIG_FAN_AUTO_SAMPLE_INTERVAL_MS: MeasuredValue in 0.01 °C or null, and
+ * the PercentSetting expected after the sample. '#' lines and the header line are skipped.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "driver/ledc.h"
+
+#include <app_fan_auto.h>
+#include <app_fan_bank.h>
+#include <app_persist.h>
+
+#include "fake_persist.h"
+#include "host_node.h"
+#include "host_test.h"
+
+using namespace chip::app::Clusters;
+
+typedef struct {
+    bool is_null;
+    int16_t temperature;
+    uint8_t percent;
+} trace_sample_t;
+
+/* The configuration app_driver.cpp builds from the sdkconfig */
+static const app_fan_auto_config_t s_config = {
+    .temp_min = CONFIG_FAN_AUTO_TEMP_MIN * 100,
+    .temp_max = CONFIG_FAN_AUTO_TEMP_MAX * 100,
+    .hysteresis = CONFIG_FAN_AUTO_HYSTERESIS,
+    .percent_min = CONFIG_FAN_AUTO_PERCENT_MIN,
+    .percent_max = 100,
+};
+
+static const char *const k_traces[] = { "warmup.csv", "noisy_plateau.csv", "cooldown_and_step.csv" };
+
+static std::vector<trace_sample_t> load_trace(const char *name)
+{
+    std::vector<trace_sample_t> samples;
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", HOST_TRACE_DIR, name);
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        CHECK(file != NULL);
+        return samples;
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '#' || strncmp(line, "temperature,", 12) == 0) {
+            continue;
+        }
+        trace_sample_t sample = {};
+        char *comma = strchr(line, ',');
+        if (!comma) {
+            continue;
+        }
+        *comma = '\0';
+        sample.is_null = strcmp(line, "null") == 0;
+        sample.temperature = sample.is_null ? INT16_MIN : (int16_t)strtol(line, NULL, 10);
+        sample.percent = (uint8_t)strtol(comma + 1, NULL, 10);
+        samples.push_back(sample);
+    }
+    fclose(file);
+    CHECK(!samples.empty());
+    return samples;
+}
+
+/* Percent changes along a trace, starting from `percent` */
+static uint32_t count_changes(const std::vector<trace_sample_t> &samples, uint8_t percent)
+{
+    uint32_t changes = 0;
+    for (const trace_sample_t &sample : samples) {
+        changes += sample.percent != percent;
+        percent = sample.percent;
+    }
+    return changes;
+}
+
+static uint32_t duty_of(uint8_t percent)
+{
+    return ((uint32_t)percent * (FAN_BANK_DUTY_MAX - 1)) / 100;
+}
+
+static esp_err_t write_temperature(int16_t temperature)
+{
+    return host_node_write(host_node_temperature_endpoint(), TemperatureMeasurement::Id,
+                           TemperatureMeasurement::Attributes::MeasuredValue::Id,
+                           esp_matter_nullable_int16(temperature));
+}
+
+HOST_TEST(traces_replay_through_the_controller)
+{
+    for (const char *name : k_traces) {
+        std::vector<trace_sample_t> samples = load_trace(name);
+        app_fan_auto_state_t state = {};
+        uint8_t percent = 0;
+        for (size_t i = 0; i < samples.size(); i++) {
+            if (samples[i].is_null) {
+                /* The driver drops null before the controller */
+                CHECK_EQ(samples[i].percent, percent);
+                continue;
+            }
+            bool changed = app_fan_auto_update(&s_config, &state, samples[i].temperature);
+            if (state.percent != samples[i].percent) {
+                fprintf(stderr, "%s: sample %d (%d) gives %d %%, expected %d %%\n", name, (int)i,
+                        samples[i].temperature, state.percent, samples[i].percent);
+            }
+            CHECK_EQ(state.percent, samples[i].percent);
+            CHECK_EQ(changed, i == 0 || state.percent != percent);
+            percent = state.percent;
+        }
+    }
+}
+
+/* The input a percent was computed from is kept, a slow drift in steps below the hysteresis still recomputes */
+HOST_TEST(hysteresis_is_measured_from_the_last_recomputation)
+{
+    app_fan_auto_state_t state = {};
+    CHECK(app_fan_auto_update(&s_config, &state, 3600));
+    int16_t temperature = 3600;
+    int recomputations = 0;
+    for (int i = 0; i < 20; i++) {
+        temperature += CONFIG_FAN_AUTO_HYSTERESIS / 2;
+        int16_t input = state.temperature;
+        app_fan_auto_update(&s_config, &state, temperature);
+        recomputations += state.temperature != input;
+    }
+    /* 20 half-band steps cross the band every third step */
+    CHECK_EQ(recomputations, 6);
+    CHECK_EQ(state.temperature, 3600 + 18 * (CONFIG_FAN_AUTO_HYSTERESIS / 2));
+}
+
+HOST_TEST(noise_within_the_hysteresis_recomputes_once)
+{
+    std::vector<trace_sample_t> samples = load_trace("noisy_plateau.csv");
+    CHECK_EQ(count_changes(samples, 0), 1);
+}
+
+/* Fan 0 in Auto follows the traces down to the LEDC duty and NVS, fan 1 in Low ignores them */
+HOST_TEST(traces_replay_through_the_driver)
+{
+    CHECK_EQ(host_node_init(), ESP_OK);
+    CHECK_EQ(host_node_write(host_node_fan_endpoint(1), FanControl::Id, FanControl::Attributes::PercentSetting::Id,
+                             esp_matter_nullable_uint8(10)),
+             ESP_OK);
+    CHECK_EQ(host_node_write(host_node_fan_endpoint(0), FanControl::Id, FanControl::Attributes::FanMode::Id,
+                             esp_matter_enum8(APP_FAN_MODE_AUTO)),
+             ESP_OK);
+
+    for (const char *name : k_traces) {
+        std::vector<trace_sample_t> samples = load_trace(name);
+        /* Far below every trace, so the first sample of each recomputes as on a fresh controller */
+        CHECK_EQ(write_temperature(-4000), ESP_OK);
+        CHECK_EQ(host_node_fan_duty(0), duty_of(CONFIG_FAN_AUTO_PERCENT_MIN));
+        uint32_t writes = fake_persist_fan_writes(0);
+        uint32_t other_writes = fake_persist_fan_writes(1);
+
+        for (size_t i = 0; i < samples.size(); i++) {
+            CHECK_EQ(write_temperature(samples[i].temperature), ESP_OK);
+            if (host_node_fan_duty(0) != duty_of(samples[i].percent)) {
+                fprintf(stderr, "%s: sample %d (%d) gives duty %d, expected %d %%\n", name, (int)i,
+                        samples[i].temperature, (int)host_node_fan_duty(0), samples[i].percent);
+            }
+            CHECK_EQ(host_node_fan_duty(0), duty_of(samples[i].percent));
+        }
+
+        /* Only a changed percent reaches NVS, the sensor noise does not wear the flash */
+        CHECK_EQ(fake_persist_fan_writes(0) - writes, count_changes(samples, CONFIG_FAN_AUTO_PERCENT_MIN));
+        app_persist_fan_t persisted = {};
+        CHECK_EQ(app_persist_get_fan(0, &persisted), ESP_OK);
+        CHECK_EQ(persisted.fan_mode, APP_FAN_MODE_AUTO);
+        CHECK_EQ(persisted.percent, samples.back().percent);
+
+        CHECK_EQ(fake_persist_fan_writes(1), other_writes);
+        CHECK_EQ(host_node_fan_duty(1), duty_of(10));
+    }
+}
@@ -0,0 +1,220 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Calibration sweep and curve fit of app_fan_curve.h
+ *
+ * The files in sweeps/ are output of "matter esp curve dump <endpoint>": the fitted table followed by the samples of
+ * the sweep. The fit is replayed from the samples and has to give the dumped table again, and every table has to be
+ * usable by the driver. The sweep itself runs against modelled fans with a stall and a start duty.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include <app_fan_bank.h>
+#include <app_fan_curve.h>
+
+#include "host_test.h"
+
+#define DUTY_MAX (FAN_BANK_DUTY_MAX - 1)
+
+typedef struct {
+    unsigned start_duty;
+    unsigned rpm_min;
+    unsigned rpm_max;
+    std::vector<uint16_t> duty;
+    std::vector<app_fan_curve_sample_t> samples;
+} curve_dump_t;
+
+typedef struct {
+    uint32_t max_rpm;       /* speed at full duty */
+    uint32_t floor_rpm;     /* speed at duty 0 of a fan that never stops, 0 for one that stalls */
+    uint32_t stall_duty;    /* a running fan stops below this duty */
+    uint32_t start_duty;    /* a standing fan starts at and above this duty */
+} fan_model_t;
+
+static const char *const k_sweeps[] = { "pwm_fan_with_floor.txt", "stalling_fan.txt", "saturating_fan.txt" };
+
+static bool load_dump(const char *name, curve_dump_t *dump)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", HOST_SWEEP_DIR, name);
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+    char line[128];
+    int calibrated = 0;
+    bool header = fgets(line, sizeof(line), file) &&
+                  sscanf(line, "calibrated,%d,start_duty,%u,rpm_min,%u,rpm_max,%u", &calibrated, &dump->start_duty,
+                         &dump->rpm_min, &dump->rpm_max) == 4;
+    std::vector<app_fan_curve_sample_t> *section = NULL;
+    while (header && fgets(line, sizeof(line), file)) {
+        unsigned first, second;
+        if (strncmp(line, "percent,duty", 12) == 0) {
+            section = NULL;
+        } else if (strncmp(line, "duty,rpm", 8) == 0) {
+            section = &dump->samples;
+        } else if (sscanf(line, "%u,%u", &first, &second) == 2) {
+            if (section) {
+                section->push_back({(uint16_t)first, (uint16_t)second});
+            } else {
+                dump->duty.push_back((uint16_t)second);
+            }
+        }
+    }
+    fclose(file);
+    return header && calibrated && dump->duty.size() == APP_FAN_CURVE_POINTS && !dump->samples.empty();
+}
+
+static uint32_t model_target_rpm(const fan_model_t &fan, uint32_t duty, bool running)
+{
+    if (duty < (running ? fan.stall_duty : fan.start_duty)) {
+        return fan.floor_rpm;
+    }
+    uint32_t low = fan.floor_rpm;
+    return low + ((fan.max_rpm - low) * duty) / DUTY_MAX;
+}
+
+/* Runs a sweep against the model, one call per tach window. The speed moves halfway to its target every window, a
+   stalled fan coasts down against friction and stands still after a few windows. */
+static void run_sweep(const fan_model_t &fan, app_fan_sweep_t *sweep)
+{
+    uint32_t rpm = 0;
+    uint16_t duty = app_fan_sweep_begin(sweep, DUTY_MAX, CONFIG_FAN_CALIBRATION_SETTLE_WINDOWS);
+    for (int window = 0; window < 5000 && sweep->phase != APP_FAN_SWEEP_DONE && sweep->phase != APP_FAN_SWEEP_FAILED;
+         window++) {
+        uint32_t target = model_target_rpm(fan, duty, rpm > 0);
+        if (target == 0) {
+            uint32_t friction = fan.max_rpm / 8;
+            rpm = rpm / 2 > friction ? rpm / 2 - friction : 0;
+        } else {
+            rpm = target > rpm ? rpm + (target - rpm + 1) / 2 : rpm - (rpm - target + 1) / 2;
+        }
+        duty = app_fan_sweep_step(sweep, rpm);
+    }
+}
+
+/* What the driver relies on: 0 is off, the duty never falls with the percent and stays within full output */
+static void check_curve(const app_fan_curve_t &curve)
+{
+    CHECK_EQ(curve.duty_max, DUTY_MAX);
+    CHECK_EQ(curve.duty[0], 0);
+    CHECK(curve.duty[1] > 0);
+    for (int percent = 1; percent < APP_FAN_CURVE_POINTS; percent++) {
+        CHECK(curve.duty[percent] >= curve.duty[percent - 1]);
+        CHECK(curve.duty[percent] <= DUTY_MAX);
+    }
+    for (int percent = 1; percent < APP_FAN_CURVE_POINTS; percent++) {
+        uint32_t rpm = app_fan_curve_percent_to_rpm(curve.span, (uint8_t)percent, 0);
+        CHECK_EQ(app_fan_curve_rpm_to_percent(curve.span, rpm, 0), percent);
+    }
+}
+
+HOST_TEST(recorded_sweeps_fit_to_the_dumped_tables)
+{
+    for (const char *name : k_sweeps) {
+        curve_dump_t dump = {};
+        CHECK(load_dump(name, &dump));
+        app_fan_curve_t curve;
+        CHECK(app_fan_curve_fit(dump.samples.data(), dump.samples.size(), DUTY_MAX, dump.start_duty, &curve));
+        CHECK_EQ(curve.start_duty, dump.start_duty);
+        CHECK_EQ(curve.span.rpm_min, dump.rpm_min);
+        CHECK_EQ(curve.span.rpm_max, dump.rpm_max);
+        int mismatches = 0;
+        for (int percent = 0; percent < APP_FAN_CURVE_POINTS && percent < (int)dump.duty.size(); percent++) {
+            mismatches += curve.duty[percent] != dump.duty[percent];
+        }
+        if (mismatches) {
+            fprintf(stderr, "%s: %d steps differ from the dumped table\n", name, mismatches);
+        }
+        CHECK_EQ(mismatches, 0);
+        check_curve(curve);
+
+        /* The span comes from the slowest and fastest running sample, 1 % is the lowest duty the fan ran at */
+        uint16_t lowest_duty = UINT16_MAX;
+        for (const app_fan_curve_sample_t &sample : dump.samples) {
+            if (sample.rpm > 0 && sample.duty < lowest_duty) {
+                lowest_duty = sample.duty;
+            }
+        }
+        CHECK_EQ(curve.duty[1], lowest_duty);
+        printf("  %-24s start duty %4u  %4u..%4u RPM  1 %% at duty %4u, 50 %% at %4u\n", name, curve.start_duty,
+               curve.span.rpm_min, curve.span.rpm_max, curve.duty[1], curve.duty[50]);
+    }
+}
+
+/* Samples come in descending duty, the fit sorts them and must not depend on the order */
+HOST_TEST(fit_does_not_depend_on_the_sample_order)
+{
+    curve_dump_t dump = {};
+    CHECK(load_dump("stalling_fan.txt", &dump));
+    app_fan_curve_t forward, reverse;
+    CHECK(app_fan_curve_fit(dump.samples.data(), dump.samples.size(), DUTY_MAX, dump.start_duty, &forward));
+    std::vector<app_fan_curve_sample_t> reversed(dump.samples.rbegin(), dump.samples.rend());
+    CHECK(app_fan_curve_fit(reversed.data(), reversed.size(), DUTY_MAX, dump.start_duty, &reverse));
+    CHECK(memcmp(&forward, &reverse, sizeof(forward)) == 0);
+}
+
+HOST_TEST(fit_rejects_samples_without_a_speed_range)
+{
+    app_fan_curve_t curve;
+    const app_fan_curve_sample_t one[] = { { DUTY_MAX, 1500 }, { 1000, 0 } };
+    CHECK(!app_fan_curve_fit(one, 2, DUTY_MAX, 0, &curve));
+    const app_fan_curve_sample_t flat[] = { { DUTY_MAX, 1500 }, { 1000, 1500 }, { 500, 1500 } };
+    CHECK(!app_fan_curve_fit(flat, 3, DUTY_MAX, 0, &curve));
+    /* Noise that makes the speed fall with the duty everywhere leaves no range either */
+    const app_fan_curve_sample_t falling[] = { { DUTY_MAX, 1000 }, { 1000, 1200 } };
+    CHECK(!app_fan_curve_fit(falling, 2, DUTY_MAX, 0, &curve));
+    const app_fan_curve_sample_t two[] = { { DUTY_MAX, 1500 }, { 500, 300 } };
+    CHECK(app_fan_curve_fit(two, 2, DUTY_MAX, 0, &curve));
+    check_curve(curve);
+}
+
+HOST_TEST(sweep_finds_the_start_duty_of_a_stalling_fan)
+{
+    const fan_model_t fan = { 2400, 0, DUTY_MAX / 5, DUTY_MAX * 3 / 10 };
+    app_fan_sweep_t sweep;
+    run_sweep(fan, &sweep);
+    CHECK_EQ(sweep.phase, APP_FAN_SWEEP_DONE);
+    /* The first probe step at or above the start duty */
+    CHECK(sweep.start_duty >= fan.start_duty);
+    CHECK(sweep.start_duty < fan.start_duty + DUTY_MAX / APP_FAN_SWEEP_START_STEPS);
+    for (int i = 1; i < sweep.count; i++) {
+        CHECK(sweep.samples[i].duty < sweep.samples[i - 1].duty);
+    }
+    CHECK(sweep.samples[sweep.count - 1].duty >= fan.stall_duty);
+
+    app_fan_curve_t curve;
+    CHECK(app_fan_curve_fit(sweep.samples, sweep.count, DUTY_MAX, sweep.start_duty, &curve));
+    check_curve(curve);
+    /* 1 % is the slowest speed the fan keeps running at, below its start duty, so the driver kicks it */
+    CHECK(curve.duty[1] >= fan.stall_duty && curve.duty[1] < curve.start_duty);
+}
+
+HOST_TEST(fan_running_at_zero_duty_needs_no_kick)
+{
+    const fan_model_t fan = { 1800, 450, 0, 0 };
+    app_fan_sweep_t sweep;
+    run_sweep(fan, &sweep);
+    CHECK_EQ(sweep.phase, APP_FAN_SWEEP_DONE);
+    CHECK_EQ(sweep.start_duty, 0);
+    CHECK_EQ(sweep.count, APP_FAN_SWEEP_MAX_SAMPLES);
+}
+
+HOST_TEST(sweep_of_a_fan_without_tach_fails)
+{
+    const fan_model_t fan = { 0, 0, 0, 0 };
+    app_fan_sweep_t sweep;
+    run_sweep(fan, &sweep);
+    CHECK_EQ(sweep.phase, APP_FAN_SWEEP_FAILED);
+}
@@ -0,0 +1,217 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* FanMode <-> PercentSetting tables of app_fan_mode.h for every FanModeSequence */
+
+#include <app_fan_mode.h>
+
+#include "host_test.h"
+
+static const uint8_t k_sequences[] = {
+    APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH, APP_FAN_MODE_SEQUENCE_OFF_LOW_HIGH,
+    APP_FAN_MODE_SEQUENCE_OFF_LOW_MED_HIGH_AUTO, APP_FAN_MODE_SEQUENCE_OFF_LOW_HIGH_AUTO,
+    APP_FAN_MODE_SEQUENCE_OFF_HIGH_AUTO, APP_FAN_MODE_SEQUENCE_OFF_HIGH,
+};
+
+/* Off, Low, Medium and High modes the sequence announces */
+static bool speed_mode_supported(uint8_t sequence, uint8_t mode)
+{
+    switch (mode) {
+    case APP_FAN_MODE_OFF:
+    case APP_FAN_MODE_HIGH:
+        return true;
+    case APP_FAN_MODE_LOW:
+        return sequence_has_low(sequence);
+    case APP_FAN_MODE_MEDIUM:
+        return sequence_has_medium(sequence);
+    default:
+        return false;
+    }
+}
+
+HOST_TEST(every_percent_maps_to_a_supported_mode_whose_band_holds_it)
+{
+    for (uint8_t sequence : k_sequences) {
+        fan_mode_table_t table = make_fan_mode_table(sequence);
+        CHECK_EQ(table.percent_to_mode[0], APP_FAN_MODE_OFF);
+        for (uint8_t percent = 0; percent < k_percent_count; percent++) {
+            uint8_t mode = table.percent_to_mode[percent];
+            CHECK(speed_mode_supported(sequence, mode));
+            CHECK(fan_mode_range_contains(table.range[mode], percent));
+        }
+    }
+}
+
+/* The bands of the supported modes cover 0..100 once */
+HOST_TEST(supported_bands_do_not_overlap)
+{
+    for (uint8_t sequence : k_sequences) {
+        fan_mode_table_t table = make_fan_mode_table(sequence);
+        for (uint8_t percent = 0; percent < k_percent_count; percent++) {
+            int holders = 0;
+            for (uint8_t mode = APP_FAN_MODE_OFF; mode <= APP_FAN_MODE_HIGH; mode++) {
+                holders += speed_mode_supported(sequence, mode) && fan_mode_range_contains(table.range[mode], percent);
+            }
+            CHECK_EQ(holders, 1);
+        }
+    }
+}
+
+HOST_TEST(mode_write_keeps_a_percent_inside_the_band)
+{
+    for (uint8_t sequence : k_sequences) {
+        fan_mode_table_t table = make_fan_mode_table(sequence);
+        for (uint8_t mode = APP_FAN_MODE_OFF; mode <= APP_FAN_MODE_ON; mode++) {
+            const fan_mode_range_t &range = table.range[mode];
+            for (uint8_t percent = 0; percent < k_percent_count; percent++) {
+                fan_mode_reconcile_t result = fan_mode_reconcile_mode_write(table, mode, percent);
+                CHECK(speed_mode_supported(sequence, result.fan_mode));
+                CHECK_EQ(result.fan_mode_changed, result.fan_mode != mode);
+                CHECK(fan_mode_range_contains(table.range[result.fan_mode], result.percent));
+                if (fan_mode_range_contains(range, percent)) {
+                    CHECK_EQ(result.percent, percent);
+                    CHECK(!result.percent_changed);
+                } else {
+                    CHECK_EQ(result.percent, range.percent_max);
+                    CHECK(result.percent_changed);
+                }
+            }
+        }
+    }
+}
+
+/* Modes the sequence lacks take the band of the next higher mode and are reconciled to it */
+HOST_TEST(unsupported_modes_fold_into_the_next_higher_mode)
+{
+    fan_mode_table_t off_low_high = make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_LOW_HIGH);
+    fan_mode_reconcile_t result = fan_mode_reconcile_mode_write(off_low_high, APP_FAN_MODE_MEDIUM, 10);
+    CHECK_EQ(result.fan_mode, APP_FAN_MODE_HIGH);
+    CHECK_EQ(result.percent, HIGH_MODE_PERCENT_MAX);
+    result = fan_mode_reconcile_mode_write(off_low_high, APP_FAN_MODE_MEDIUM, MED_MODE_PERCENT_MIN);
+    CHECK_EQ(result.fan_mode, APP_FAN_MODE_HIGH);
+    CHECK_EQ(result.percent, MED_MODE_PERCENT_MIN);
+
+    fan_mode_table_t off_high = make_fan_mode_table(APP_FAN_MODE_SEQUENCE_OFF_HIGH);
+    result = fan_mode_reconcile_mode_write(off_high, APP_FAN_MODE_LOW, LOW_MODE_PERCENT_MIN);
+    CHECK_EQ(result.fan_mode, APP_FAN_MODE_HIGH);
+    CHECK_EQ(result.percent, LOW_MODE_PERCENT_MIN);
+    CHECK_EQ(off_high.percent_to_mode[LOW_MODE_PERCENT_MIN], APP_FAN_MODE_HIGH);
+
+    for (uint8_t sequence : k_sequences) {
+        result = fan_mode_reconcile_mode_write(make_fan_mode_table(sequence), APP_FAN_MODE_ON, 0);
+        CHECK_EQ(result.fan_mode, APP_FAN_MODE_HIGH);
+        CHECK(result.fan_mode_changed);
+        CHECK_EQ(result.percent, HIGH_MODE_PERCENT_MAX);
+    }
+}
+
+HOST_TEST(auto_leaves_the_percent_alone)
+{
+    for (uint8_t sequence : k_sequences) {
+        if (!sequence_has_auto(sequence)) {
+            continue;
+        }
+        fan_mode_table_t table = make_fan_mode_table(sequence);
+        for (uint8_t percent = 0; percent < k_percent_count; percent++) {
+            fan_mode_reconcile_t result = fan_mode_reconcile_mode_write(table, APP_FAN_MODE_AUTO, percent);
+            CHECK_EQ(result.fan_mode, APP_FAN_MODE_AUTO);
+            CHECK_EQ(result.percent, percent);
+            CHECK(!result.fan_mode_changed && !result.percent_changed);
+        }
+    }
+}
+
+/* Smart is in no sequence, it is reconciled to Auto and leaves the percent to the Auto controller */
+HOST_TEST(smart_folds_into_auto)
+{
+    for (uint8_t sequence : k_sequences) {
+        if (!sequence_has_auto(sequence)) {
+            continue;
+        }
+        fan_mode_table_t table = make_fan_mode_table(sequence);
+        for (uint8_t percent = 0; percent < k_percent_count; percent++) {
+            fan_mode_reconcile_t result = fan_mode_reconcile_mode_write(table, APP_FAN_MODE_SMART, percent);
+            CHECK_EQ(result.fan_mode, APP_FAN_MODE_AUTO);
+            CHECK(result.fan_mode_changed);
+            CHECK_EQ(result.percent, percent);
+            CHECK(!result.percent_changed);
+        }
+    }
+}
+
+/* Without Auto in the sequence, Auto and Smart writes are stored as High and run the fan in the High band */
+HOST_TEST(auto_and_smart_fold_into_high_without_auto)
+{
+    for (uint8_t sequence : k_sequences) {
+        if (sequence_has_auto(sequence)) {
+            continue;
+        }
+        fan_mode_table_t table = make_fan_mode_table(sequence);
+        const uint8_t modes[] = { APP_FAN_MODE_AUTO, APP_FAN_MODE_SMART };
+        for (uint8_t mode : modes) {
+            fan_mode_reconcile_t result = fan_mode_reconcile_mode_write(table, mode, 0);
+            CHECK_EQ(result.fan_mode, APP_FAN_MODE_HIGH);
+            CHECK(result.fan_mode_changed);
+            CHECK(fan_mode_range_contains(table.range[APP_FAN_MODE_HIGH], result.percent));
+            CHECK_EQ(result.percent, HIGH_MODE_PERCENT_MAX);
+            CHECK(result.percent_changed);
+
+            result = fan_mode_reconcile_mode_write(table, mode, HIGH_MODE_PERCENT_MIN);
+            CHECK_EQ(result.fan_mode, APP_FAN_MODE_HIGH);
+            CHECK_EQ(result.percent, HIGH_MODE_PERCENT_MIN);
+            CHECK(!result.percent_changed);
+        }
+    }
+}
+
+HOST_TEST(percent_write_keeps_the_mode_if_its_band_holds_the_percent)
+{
+    for (uint8_t sequence : k_sequences) {
+        fan_mode_table_t table = make_fan_mode_table(sequence);
+        for (uint8_t mode = 0; mode < k_fan_mode_count; mode++) {
+            for (uint16_t percent = 0; percent <= 110; percent++) {
+                fan_mode_reconcile_t result = fan_mode_reconcile_percent_write(table, mode, (uint8_t)percent);
+                CHECK_EQ(result.percent, percent > 100 ? 100 : percent);
+                CHECK(fan_mode_range_contains(table.range[result.fan_mode], result.percent));
+                bool keeps = speed_mode_supported(sequence, mode) &&
+                             fan_mode_range_contains(table.range[mode], result.percent);
+                CHECK_EQ(result.fan_mode_changed, !keeps);
+                CHECK_EQ(result.fan_mode, keeps ? mode : table.percent_to_mode[result.percent]);
+            }
+        }
+    }
+}
+
+/* Reconciling the result of a write again changes nothing */
+HOST_TEST(reconciled_state_is_stable)
+{
+    for (uint8_t sequence : k_sequences) {
+        fan_mode_table_t table = make_fan_mode_table(sequence);
+        for (uint8_t mode = APP_FAN_MODE_OFF; mode <= APP_FAN_MODE_ON; mode++) {
+            for (uint8_t percent = 0; percent < k_percent_count; percent++) {
+                fan_mode_reconcile_t first = fan_mode_reconcile_mode_write(table, mode, percent);
+                fan_mode_reconcile_t second = fan_mode_reconcile_percent_write(table, first.fan_mode, first.percent);
+                CHECK(!second.fan_mode_changed);
+                fan_mode_reconcile_t third = fan_mode_reconcile_mode_write(table, second.fan_mode, second.percent);
+                CHECK(!third.fan_mode_changed && !third.percent_changed);
+            }
+        }
+    }
+}
+
+HOST_TEST(speed_and_percent_round_trip)
+{
+    for (uint8_t speed_max = 1; speed_max <= 100; speed_max++) {
+        for (uint8_t speed = 0; speed <= speed_max; speed++) {
+            CHECK_EQ(app_fan_percent_to_speed(app_fan_speed_to_percent(speed, speed_max), speed_max), speed);
+        }
+        CHECK_EQ(app_fan_percent_to_speed(0, speed_max), 0);
+        CHECK_EQ(app_fan_percent_to_speed(1, speed_max), 1);
+        CHECK_EQ(app_fan_percent_to_speed(100, speed_max), speed_max);
+    }
+}
@@ -0,0 +1,178 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Step responses of the fixed-point PID of app_fan_pid.cpp against a first order fan model, one control tick per
+ * tach window like fan_control_tick() */
+
+#include <stdio.h>
+
+#include <app_fan_bank.h>
+#include <app_fan_pid.h>
+#include <app_tach.h>
+
+#include "host_test.h"
+
+#define DUTY_MAX (FAN_BANK_DUTY_MAX - 1)
+#define TIME_CONSTANT_MS 2000
+
+typedef struct {
+    int32_t max_rpm;        /* speed at full duty */
+    int32_t stall_duty;     /* the fan stands still below this duty */
+} fan_model_t;
+
+typedef struct {
+    int32_t final_rpm;
+    int32_t overshoot_rpm;  /* largest measured speed beyond the setpoint */
+    int settle_ticks;       /* first tick after which the speed stays within 2 % of the setpoint */
+    int32_t min_output;
+    int32_t max_output;
+} step_response_t;
+
+static const app_fan_pid_gains_t s_gains = {
+    .kp = CONFIG_FAN_PID_KP_Q8,
+    .ki = CONFIG_FAN_PID_KI_Q8,
+    .kd = CONFIG_FAN_PID_KD_Q8,
+    .out_min = 0,
+    .out_max = DUTY_MAX,
+};
+
+static int32_t model_target_rpm(const fan_model_t &fan, int32_t duty)
+{
+    if (duty < fan.stall_duty) {
+        return 0;
+    }
+    return (int32_t)(((int64_t)duty * fan.max_rpm) / DUTY_MAX);
+}
+
+/* Runs the controller from a standing fan towards `setpoint`. The feedforward assumes a linear fan reaching
+   CONFIG_FAN_MAX_RPM, as the uncalibrated curve does, the model may differ from it. */
+static step_response_t run_step(const app_fan_pid_gains_t &gains, const fan_model_t &fan, int32_t setpoint,
+                                int ticks)
+{
+    app_fan_pid_state_t state;
+    app_fan_pid_reset(&state, 0);
+    int32_t feedforward = (int32_t)(((int64_t)setpoint * DUTY_MAX) / CONFIG_FAN_MAX_RPM);
+    double rpm = 0;
+    uint32_t measured = 0;
+    int32_t duty = feedforward;
+    step_response_t response = { 0, 0, -1, DUTY_MAX, 0 };
+    for (int tick = 0; tick < ticks; tick++) {
+        rpm += (model_target_rpm(fan, duty) - rpm) * CONFIG_FAN_TACH_WINDOW_MS /
+               (TIME_CONSTANT_MS + CONFIG_FAN_TACH_WINDOW_MS);
+        measured = app_tach_filter_rpm(measured, (uint32_t)rpm);
+        duty = app_fan_pid_step(&gains, &state, setpoint, (int32_t)measured, feedforward);
+        response.min_output = duty < response.min_output ? duty : response.min_output;
+        response.max_output = duty > response.max_output ? duty : response.max_output;
+        if ((int32_t)measured - setpoint > response.overshoot_rpm) {
+            response.overshoot_rpm = (int32_t)measured - setpoint;
+        }
+        int32_t error = (int32_t)measured - setpoint;
+        bool inside = error * 50 <= setpoint && -error * 50 <= setpoint;
+        if (!inside) {
+            response.settle_ticks = -1;
+        } else if (response.settle_ticks < 0) {
+            response.settle_ticks = tick;
+        }
+    }
+    response.final_rpm = (int32_t)measured;
+    return response;
+}
+
+static void print_response(const char *name, int32_t setpoint, const step_response_t &response)
+{
+    printf("  %-12s setpoint %5d RPM  final %5d RPM  overshoot %4d RPM  settled after %3d ticks\n", name,
+           (int)setpoint, (int)response.final_rpm, (int)response.overshoot_rpm, response.settle_ticks);
+}
+
+/* A fan as the feedforward expects it. The speed lags the duty by several windows, the integrator must not wind up
+   meanwhile and overshoot by much. */
+HOST_TEST(step_response_of_a_nominal_fan)
+{
+    fan_model_t fan = { CONFIG_FAN_MAX_RPM, 0 };
+    const int32_t setpoints[] = { CONFIG_FAN_MAX_RPM / 4, CONFIG_FAN_MAX_RPM / 2, CONFIG_FAN_MAX_RPM * 2 / 3 };
+    for (int32_t setpoint : setpoints) {
+        step_response_t response = run_step(s_gains, fan, setpoint, 120);
+        print_response("nominal", setpoint, response);
+        CHECK(response.settle_ticks >= 0 && response.settle_ticks <= 60);
+        CHECK(response.overshoot_rpm * 100 <= setpoint * 12);
+    }
+}
+
+/* Dust or a low supply: the same duty gives 25 % less speed, the integrator makes up for it */
+HOST_TEST(step_response_of_a_weak_fan)
+{
+    fan_model_t fan = { CONFIG_FAN_MAX_RPM * 3 / 4, DUTY_MAX / 10 };
+    const int32_t setpoints[] = { CONFIG_FAN_MAX_RPM / 4, CONFIG_FAN_MAX_RPM / 2, CONFIG_FAN_MAX_RPM * 2 / 3 };
+    for (int32_t setpoint : setpoints) {
+        step_response_t response = run_step(s_gains, fan, setpoint, 120);
+        print_response("weak", setpoint, response);
+        CHECK(response.settle_ticks >= 0 && response.settle_ticks <= 60);
+        CHECK(response.overshoot_rpm * 100 <= setpoint * 12);
+        CHECK(response.min_output >= 0 && response.max_output <= DUTY_MAX);
+    }
+}
+
+/* A fan stronger than expected is slowed down below the feedforward. The feedforward alone overshoots by 25 %, the
+   controller must not add to that. */
+HOST_TEST(step_response_of_a_strong_fan)
+{
+    fan_model_t fan = { CONFIG_FAN_MAX_RPM * 5 / 4, 0 };
+    int32_t setpoint = CONFIG_FAN_MAX_RPM / 2;
+    step_response_t response = run_step(s_gains, fan, setpoint, 120);
+    print_response("strong", setpoint, response);
+    CHECK(response.settle_ticks >= 0 && response.settle_ticks <= 60);
+    CHECK(response.overshoot_rpm * 100 <= setpoint * 26);
+    CHECK(response.min_output < (int32_t)(((int64_t)setpoint * DUTY_MAX) / CONFIG_FAN_MAX_RPM));
+}
+
+/* An unreachable setpoint saturates the output, the integrator must not wind up and delay the way back */
+HOST_TEST(no_windup_on_an_unreachable_setpoint)
+{
+    fan_model_t fan = { CONFIG_FAN_MAX_RPM / 2, 0 };
+    app_fan_pid_state_t state;
+    app_fan_pid_reset(&state, 0);
+    int32_t duty = 0;
+    double rpm = 0;
+    for (int tick = 0; tick < 200; tick++) {
+        rpm += (model_target_rpm(fan, duty) - rpm) / 3;
+        duty = app_fan_pid_step(&s_gains, &state, CONFIG_FAN_MAX_RPM, (int32_t)rpm, DUTY_MAX);
+    }
+    CHECK_EQ(duty, DUTY_MAX);
+
+    /* Back to a reachable speed: the output leaves saturation on the next tick */
+    int32_t setpoint = CONFIG_FAN_MAX_RPM / 4;
+    int32_t feedforward = (int32_t)(((int64_t)setpoint * DUTY_MAX) / CONFIG_FAN_MAX_RPM);
+    duty = app_fan_pid_step(&s_gains, &state, setpoint, (int32_t)rpm, feedforward);
+    CHECK(duty < DUTY_MAX);
+}
+
+/* With the largest gains and a large error the terms exceed 32 bit, the output must still saturate the right way */
+HOST_TEST(large_gains_and_errors_do_not_overflow)
+{
+    app_fan_pid_gains_t gains = { 65535, 65535, 65535, 0, DUTY_MAX };
+    app_fan_pid_state_t state;
+    app_fan_pid_reset(&state, 0);
+    CHECK_EQ(app_fan_pid_step(&gains, &state, 20000, 0, 0), DUTY_MAX);
+    app_fan_pid_reset(&state, 20000);
+    CHECK_EQ(app_fan_pid_step(&gains, &state, 0, 20000, DUTY_MAX), 0);
+}
+
+HOST_TEST(reset_clears_the_integrator)
+{
+    app_fan_pid_state_t state;
+    app_fan_pid_reset(&state, 0);
+    for (int tick = 0; tick < 10; tick++) {
+        app_fan_pid_step(&s_gains, &state, 1000, 900, 1000);
+    }
+    CHECK(state.integral > 0);
+    app_fan_pid_reset(&state, 900);
+    CHECK_EQ(state.integral, 0);
+    CHECK_EQ(state.prev_measurement, 900);
+    /* Without an error the output is the feedforward */
+    CHECK_EQ(app_fan_pid_step(&s_gains, &state, 900, 900, 1000), 1000);
+}
@@ -0,0 +1,70 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <app_report_coalescer.h>
+
+#include "host_test.h"
+
+static const app_report_coalescer_config_t s_config = {
+    .min_delta = 5,
+    .min_interval_ms = 500,
+    .max_interval_ms = 5000,
+};
+
+HOST_TEST(unchanged_value_is_not_reported)
+{
+    app_report_coalescer_t state = { 40, 0 };
+    CHECK(!app_report_coalescer_update(&s_config, &state, 40, true, 10000));
+}
+
+HOST_TEST(reports_keep_the_min_interval)
+{
+    app_report_coalescer_t state = { 0, 0 };
+    CHECK(app_report_coalescer_update(&s_config, &state, 50, false, 1000));
+    CHECK(!app_report_coalescer_update(&s_config, &state, 90, false, 1499));
+    CHECK(app_report_coalescer_update(&s_config, &state, 90, false, 1500));
+    CHECK_EQ(state.reported, 90);
+    CHECK_EQ(state.last_report_ms, 1500);
+}
+
+HOST_TEST(small_changes_wait_for_settling_or_max_interval)
+{
+    app_report_coalescer_t state = { 50, 0 };
+    CHECK(!app_report_coalescer_update(&s_config, &state, 52, false, 1000));
+    CHECK(app_report_coalescer_update(&s_config, &state, 52, true, 1000));
+
+    state = { 50, 0 };
+    CHECK(!app_report_coalescer_update(&s_config, &state, 52, false, 4999));
+    CHECK(app_report_coalescer_update(&s_config, &state, 52, false, 5000));
+}
+
+/* A 0 -> 100 ramp sampled every 100 ms over 2 s is reported at most once per min interval plus the final value */
+HOST_TEST(ramp_is_coalesced)
+{
+    app_report_coalescer_t state = { 0, 0 };
+    int reports = 0;
+    uint32_t now_ms = 10000;
+    for (int step = 1; step <= 20; step++) {
+        now_ms += 100;
+        reports += app_report_coalescer_update(&s_config, &state, (uint8_t)(step * 5), step == 20, now_ms);
+    }
+    for (int i = 0; i < 10; i++) {
+        now_ms += 100;
+        reports += app_report_coalescer_update(&s_config, &state, 100, true, now_ms);
+    }
+    CHECK_EQ(state.reported, 100);
+    CHECK(reports <= 2000 / 500 + 1);
+}
+
+/* The millisecond clock wraps after 49 days */
+HOST_TEST(clock_wrap_keeps_the_interval)
+{
+    app_report_coalescer_t state = { 0, UINT32_MAX - 100 };
+    CHECK(!app_report_coalescer_update(&s_config, &state, 50, false, 200));
+    CHECK(app_report_coalescer_update(&s_config, &state, 50, false, 400));
+}
@@ -0,0 +1,70 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <thread>
+
+#include <app_spsc_ring.h>
+
+#include "host_test.h"
+
+HOST_TEST(every_slot_is_usable)
+{
+    spsc_ring<uint32_t, 8> ring;
+    for (uint32_t i = 0; i < 8; i++) {
+        CHECK(ring.push(i));
+    }
+    CHECK(!ring.push(8));
+    uint32_t item = 0;
+    for (uint32_t i = 0; i < 8; i++) {
+        CHECK(ring.pop(item));
+        CHECK_EQ(item, i);
+    }
+    CHECK(!ring.pop(item));
+}
+
+HOST_TEST(indices_wrap_around)
+{
+    spsc_ring<uint32_t, 4> ring;
+    uint32_t item = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+        CHECK(ring.push(i));
+        CHECK(ring.push(i + 1));
+        CHECK(ring.pop(item));
+        CHECK_EQ(item, i);
+        CHECK(ring.pop(item));
+        CHECK_EQ(item, i + 1);
+    }
+    CHECK(!ring.pop(item));
+}
+
+/* One producer and one consumer thread, like the CHIP thread and the driver task */
+HOST_TEST(items_arrive_in_order_across_threads)
+{
+    static spsc_ring<uint32_t, 32> ring;
+    const uint32_t count = 200000;
+    std::thread producer([count]() {
+        for (uint32_t i = 0; i < count; i++) {
+            while (!ring.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint32_t expected = 0;
+    uint32_t mismatches = 0;
+    while (expected < count) {
+        uint32_t item;
+        if (!ring.pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        mismatches += item != expected;
+        expected++;
+    }
+    producer.join();
+    CHECK_EQ(mismatches, 0);
+}
@@ -0,0 +1,111 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Tach RPM math of app_tach.h and the simulated tach source of app_tach.cpp */
+
+#include <esp_timer.h>
+
+#include <app_tach.h>
+
+#include "host_test.h"
+
+HOST_TEST(pulses_convert_to_rpm)
+{
+    /* 2 pulses per revolution: 50 pulses in 1 s are 25 rev/s */
+    CHECK_EQ(app_tach_pulses_to_rpm(50, 2, 1000), 1500);
+    CHECK_EQ(app_tach_pulses_to_rpm(25, 2, 500), 1500);
+    CHECK_EQ(app_tach_pulses_to_rpm(0, 2, 1000), 0);
+    CHECK_EQ(app_tach_pulses_to_rpm(1, 4, 250), 60);
+    /* No overflow for a fast fan in a long window */
+    CHECK_EQ(app_tach_pulses_to_rpm(2000000, 2, 10000), 6000000);
+}
+
+HOST_TEST(filter_settles_exactly_on_a_constant_input)
+{
+    uint32_t rpm = 0;
+    for (int i = 0; i < 100; i++) {
+        rpm = app_tach_filter_rpm(rpm, 1234);
+    }
+    CHECK_EQ(rpm, 1234);
+    for (int i = 0; i < 100; i++) {
+        rpm = app_tach_filter_rpm(rpm, 0);
+    }
+    CHECK_EQ(rpm, 0);
+}
+
+HOST_TEST(filter_weights_the_new_sample_by_a_quarter)
+{
+    CHECK_EQ(app_tach_filter_rpm(1000, 2000), 1250);
+    CHECK_EQ(app_tach_filter_rpm(2000, 1000), 1750);
+    /* Within 3 RPM the sample is taken as is */
+    CHECK_EQ(app_tach_filter_rpm(1000, 1003), 1003);
+    CHECK_EQ(app_tach_filter_rpm(1000, 997), 997);
+}
+
+HOST_TEST(filter_tames_a_single_glitch)
+{
+    uint32_t rpm = 1200;
+    rpm = app_tach_filter_rpm(rpm, 6000);
+    CHECK(rpm <= 1200 + (6000 - 1200) / 4);
+    for (int i = 0; i < 40; i++) {
+        rpm = app_tach_filter_rpm(rpm, 1200);
+    }
+    CHECK_EQ(rpm, 1200);
+}
+
+static uint32_t s_duty_permille[2];
+static int s_windows;
+
+static uint32_t get_duty_permille(size_t fan_index)
+{
+    return s_duty_permille[fan_index];
+}
+
+static void window_cb(void *arg)
+{
+    s_windows++;
+}
+
+/* The simulated source follows the duty like a first order fan and reads back through the same pulse counting */
+HOST_TEST(simulated_source_follows_the_duty)
+{
+    app_tach_config_t config = {
+        .gpios = NULL,
+        .fan_count = 2,
+        .get_duty_permille = get_duty_permille,
+        .window_cb = window_cb,
+        .window_cb_arg = NULL,
+    };
+    CHECK_EQ(app_tach_init(&config), ESP_OK);
+    s_duty_permille[0] = 500;
+    s_duty_permille[1] = 1000;
+
+    fake_esp_timer_advance(CONFIG_FAN_TACH_WINDOW_MS * 1000);
+    CHECK_EQ(s_windows, 1);
+    CHECK(app_tach_get_rpm(0) > 0);
+    CHECK(app_tach_get_rpm(0) < CONFIG_FAN_MAX_RPM / 2);
+
+    uint32_t previous = 0;
+    for (int i = 0; i < 10; i++) {
+        fake_esp_timer_advance(CONFIG_FAN_TACH_WINDOW_MS * 1000);
+        CHECK(app_tach_get_rpm(1) >= previous);
+        previous = app_tach_get_rpm(1);
+    }
+    fake_esp_timer_advance(60 * CONFIG_FAN_TACH_WINDOW_MS * 1000);
+    /* One pulse per window is the resolution */
+    uint32_t resolution = 60000 / (CONFIG_FAN_TACH_PULSES_PER_REV * CONFIG_FAN_TACH_WINDOW_MS);
+    CHECK(app_tach_get_rpm(0) + resolution >= CONFIG_FAN_MAX_RPM / 2);
+    CHECK(app_tach_get_rpm(0) <= CONFIG_FAN_MAX_RPM / 2 + resolution);
+    CHECK(app_tach_get_rpm(1) + resolution >= CONFIG_FAN_MAX_RPM);
+    CHECK(app_tach_get_rpm(1) <= CONFIG_FAN_MAX_RPM + resolution);
+    CHECK_EQ(app_tach_get_rpm(2), 0);
+
+    s_duty_permille[1] = 0;
+    fake_esp_timer_advance(60 * CONFIG_FAN_TACH_WINDOW_MS * 1000);
+    CHECK_EQ(app_tach_get_rpm(1), 0);
+}
@@ -0,0 +1,120 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "csv.h"
+
+bool csv_read(const char *path, std::vector<csv_row_t> &rows)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    std::string text;
+    char buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), file)) > 0) {
+        text.append(buf, len);
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    if (ok) {
+        csv_parse(text.data(), text.size(), rows);
+    }
+    return ok;
+}
+
+void csv_parse(const char *text, size_t size, std::vector<csv_row_t> &rows)
+{
+    csv_row_t row;
+    std::string field;
+    bool quoted = false;
+    bool pending = false; // Something was read since the last line break
+
+    for (size_t i = 0; i < size; i++) {
+        char c = text[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < size && text[i + 1] == '"') {
+                field += '"';
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+            continue;
+        }
+        switch (c) {
+        case '"':
+            quoted = true;
+            pending = true;
+            break;
+        case ',':
+            row.push_back(field);
+            field.clear();
+            pending = true;
+            break;
+        case '\r':
+            break;
+        case '\n':
+            if (pending) {
+                row.push_back(field);
+                rows.push_back(row);
+            }
+            row.clear();
+            field.clear();
+            pending = false;
+            break;
+        default:
+            field += c;
+            pending = true;
+            break;
+        }
+    }
+    if (pending) {
+        row.push_back(field);
+        rows.push_back(row);
+    }
+}
+
+int csv_column(const csv_row_t &header, const char *name)
+{
+    for (size_t i = 0; i < header.size(); i++) {
+        if (header[i] == name) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+std::string csv_format(const csv_row_t &row, const char *eol)
+{
+    std::string line;
+    for (size_t i = 0; i < row.size(); i++) {
+        if (i) {
+            line += ',';
+        }
+        const std::string &field = row[i];
+        if (field.find_first_of(",\"\r\n") == std::string::npos) {
+            line += field;
+            continue;
+        }
+        line += '"';
+        for (char c : field) {
+            if (c == '"') {
+                line += '"';
+            }
+            line += c;
+        }
+        line += '"';
+    }
+    line += eol;
+    return line;
+}
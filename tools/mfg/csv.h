@@ -0,0 +1,38 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+typedef std::vector<std::string> csv_row_t;
+
+/** Read a CSV file
+ *
+ * Quoted fields may contain commas, doubled quotes and line breaks, as in the cn_dacs-*.csv files.
+ *
+ * @param[in] path File to read.
+ * @param[out] rows All rows of the file, including the header.
+ *
+ * @return true on success.
+ * @return false if the file can not be read.
+ */
+bool csv_read(const char *path, std::vector<csv_row_t> &rows);
+
+/** Parse CSV text, see `csv_read()` */
+void csv_parse(const char *text, size_t size, std::vector<csv_row_t> &rows);
+
+/** Column of `name` in the header row, -1 if there is none */
+int csv_column(const csv_row_t &header, const char *name);
+
+/** Format one row, quoting the fields that need it
+ *
+ * The mfg tool writes internal/partition.csv with Python's csv module and CRLF line endings, all other files with LF.
+ */
+std::string csv_format(const csv_row_t &row, const char *eol = "\n");
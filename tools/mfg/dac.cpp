@@ -0,0 +1,190 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+
+#include <openssl/bio.h>
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+#include <openssl/x509v3.h>
+
+#include "dac.h"
+
+#define MATTER_OID_VENDOR_ID    "1.3.6.1.4.1.37244.2.1"
+#define MATTER_OID_PRODUCT_ID   "1.3.6.1.4.1.37244.2.2"
+
+static X509 *read_cert(const char *path)
+{
+    BIO *bio = BIO_new_file(path, "rb");
+    if (!bio) {
+        return NULL;
+    }
+    X509 *cert = PEM_read_bio_X509(bio, NULL, NULL, NULL);
+    if (!cert) {
+        (void)BIO_reset(bio);
+        cert = d2i_X509_bio(bio, NULL);
+    }
+    BIO_free(bio);
+    return cert;
+}
+
+static EVP_PKEY *read_key(const char *path)
+{
+    BIO *bio = BIO_new_file(path, "rb");
+    if (!bio) {
+        return NULL;
+    }
+    EVP_PKEY *key = PEM_read_bio_PrivateKey(bio, NULL, NULL, NULL);
+    if (!key) {
+        (void)BIO_reset(bio);
+        key = d2i_PrivateKey_bio(bio, NULL);
+    }
+    BIO_free(bio);
+    return key;
+}
+
+bool dac_issuer_load(const char *cert_path, const char *key_path, dac_issuer_t *issuer)
+{
+    issuer->cert = read_cert(cert_path);
+    issuer->key = read_key(key_path);
+    if (!issuer->cert || !issuer->key || !X509_check_private_key(issuer->cert, issuer->key)) {
+        dac_issuer_free(issuer);
+        return false;
+    }
+    return true;
+}
+
+void dac_issuer_free(dac_issuer_t *issuer)
+{
+    X509_free(issuer->cert);
+    EVP_PKEY_free(issuer->key);
+    issuer->cert = NULL;
+    issuer->key = NULL;
+}
+
+static bool add_name_entry(X509_NAME *name, const char *oid, const char *value)
+{
+    ASN1_OBJECT *object = OBJ_txt2obj(oid, 1);
+    bool ok = object && X509_NAME_add_entry_by_OBJ(name, object, MBSTRING_UTF8, (const unsigned char *)value, -1, -1, 0);
+    ASN1_OBJECT_free(object);
+    return ok;
+}
+
+static bool add_extension(X509 *cert, X509V3_CTX *ctx, int nid, const char *value)
+{
+    X509_EXTENSION *extension = X509V3_EXT_conf_nid(NULL, ctx, nid, value);
+    bool ok = extension && X509_add_ext(cert, extension, -1);
+    X509_EXTENSION_free(extension);
+    return ok;
+}
+
+static std::string bio_to_string(BIO *bio)
+{
+    char *data = NULL;
+    long size = BIO_get_mem_data(bio, &data);
+    return size > 0 ? std::string(data, (size_t)size) : std::string();
+}
+
+static bool encode_key(EVP_PKEY *key, dac_t *dac)
+{
+    BIGNUM *scalar = NULL;
+    size_t public_size = 0;
+    bool ok = EVP_PKEY_get_bn_param(key, OSSL_PKEY_PARAM_PRIV_KEY, &scalar) &&
+              BN_bn2binpad(scalar, dac->private_key, DAC_PRIVATE_KEY_SIZE) == DAC_PRIVATE_KEY_SIZE &&
+              EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, dac->public_key, DAC_PUBLIC_KEY_SIZE,
+                                              &public_size) &&
+              public_size == DAC_PUBLIC_KEY_SIZE;
+    BN_clear_free(scalar);
+    if (!ok) {
+        return false;
+    }
+
+    unsigned char *der = NULL;
+    int der_size = i2d_PrivateKey(key, &der);
+    if (der_size <= 0) {
+        return false;
+    }
+    dac->key_der.assign(der, der + der_size);
+    OPENSSL_clear_free(der, (size_t)der_size);
+
+    BIO *pem = BIO_new(BIO_s_mem());
+    ok = pem && PEM_write_bio_PrivateKey_traditional(pem, key, NULL, NULL, 0, NULL, NULL);
+    if (ok) {
+        dac->key_pem = bio_to_string(pem);
+    }
+    BIO_free(pem);
+    return ok;
+}
+
+static bool encode_cert(X509 *cert, dac_t *dac)
+{
+    unsigned char *der = NULL;
+    int der_size = i2d_X509(cert, &der);
+    if (der_size <= 0) {
+        return false;
+    }
+    dac->cert_der.assign(der, der + der_size);
+    OPENSSL_free(der);
+
+    BIO *pem = BIO_new(BIO_s_mem());
+    bool ok = pem && PEM_write_bio_X509(pem, cert);
+    if (ok) {
+        dac->cert_pem = bio_to_string(pem);
+    }
+    BIO_free(pem);
+    return ok;
+}
+
+bool dac_generate(const dac_issuer_t *issuer, uint16_t vendor_id, uint16_t product_id, const char *common_name,
+                  dac_t *dac)
+{
+    EVP_PKEY *key = EVP_PKEY_Q_keygen(NULL, NULL, "EC", "P-256");
+    X509 *cert = X509_new();
+    X509_NAME *subject = X509_NAME_new();
+    BIGNUM *serial = BN_new();
+    bool ok = key && cert && subject && serial;
+
+    char vendor[5];
+    char product[5];
+    snprintf(vendor, sizeof(vendor), "%04X", vendor_id);
+    snprintf(product, sizeof(product), "%04X", product_id);
+
+    /* Random 63 bit serial number, positive and 8 bytes long in DER */
+    ok = ok && BN_rand(serial, 63, BN_RAND_TOP_ONE, BN_RAND_BOTTOM_ANY) &&
+         BN_to_ASN1_INTEGER(serial, X509_get_serialNumber(cert));
+    ok = ok && X509_set_version(cert, X509_VERSION_3) &&
+         X509_gmtime_adj(X509_getm_notBefore(cert), 0) &&
+         X509_time_adj_ex(X509_getm_notAfter(cert), DAC_VALIDITY_DAYS, 0, NULL) &&
+         add_name_entry(subject, "2.5.4.3", common_name) &&
+         add_name_entry(subject, MATTER_OID_VENDOR_ID, vendor) &&
+         add_name_entry(subject, MATTER_OID_PRODUCT_ID, product) &&
+         X509_set_subject_name(cert, subject) &&
+         X509_set_issuer_name(cert, X509_get_subject_name(issuer->cert)) &&
+         X509_set_pubkey(cert, key);
+
+    if (ok) {
+        X509V3_CTX ctx;
+        X509V3_set_ctx_nodb(&ctx);
+        X509V3_set_ctx(&ctx, issuer->cert, cert, NULL, NULL, 0);
+        ok = add_extension(cert, &ctx, NID_basic_constraints, "critical,CA:FALSE") &&
+             add_extension(cert, &ctx, NID_key_usage, "critical,digitalSignature") &&
+             add_extension(cert, &ctx, NID_subject_key_identifier, "hash") &&
+             add_extension(cert, &ctx, NID_authority_key_identifier, "keyid:always") &&
+             X509_sign(cert, issuer->key, EVP_sha256()) > 0;
+    }
+
+    ok = ok && encode_key(key, dac) && encode_cert(cert, dac);
+
+    BN_free(serial);
+    X509_NAME_free(subject);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return ok;
+}
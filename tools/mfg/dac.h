@@ -0,0 +1,57 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+#define DAC_PRIVATE_KEY_SIZE    32
+#define DAC_PUBLIC_KEY_SIZE     65
+#define DAC_VALIDITY_DAYS       36500 // Same as the mfg tool
+
+/* Device attestation certificate and key in all the forms that go into a bundle */
+typedef struct {
+    std::vector<uint8_t> cert_der;
+    std::string cert_pem;
+    std::vector<uint8_t> key_der; // SEC1 ECPrivateKey
+    std::string key_pem;
+    uint8_t private_key[DAC_PRIVATE_KEY_SIZE]; // Raw scalar for the "dac-key" entry
+    uint8_t public_key[DAC_PUBLIC_KEY_SIZE]; // Uncompressed point for the "dac-pub-key" entry
+} dac_t;
+
+/* PAI that signs the DACs, shared read-only by all worker threads */
+typedef struct {
+    X509 *cert;
+    EVP_PKEY *key;
+} dac_issuer_t;
+
+/** Load the PAI certificate and its private key, PEM or DER
+ *
+ * @return true on success.
+ * @return false if a file can not be read or the key does not belong to the certificate.
+ */
+bool dac_issuer_load(const char *cert_path, const char *key_path, dac_issuer_t *issuer);
+
+void dac_issuer_free(dac_issuer_t *issuer);
+
+/** Generate a P-256 key pair and a DAC for it, issued by the PAI
+ *
+ * The subject holds the common name and the Matter vendor and product ID attributes, the extensions are those
+ * the Matter specification requires for a DAC.
+ *
+ * @return true on success.
+ * @return false in case of a crypto failure.
+ */
+bool dac_generate(const dac_issuer_t *issuer, uint16_t vendor_id, uint16_t product_id, const char *common_name,
+                  dac_t *dac);
@@ -0,0 +1,808 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Builds the per-device manufacturing bundles of out/<vid>_<pid> in parallel
+ *
+ * Every row of staging/master.csv is one device, columns named like the keys of staging/config.csv. Like the
+ * mfg tool, the passcodes are read from staging/pin_disc.csv next to it, row Index N belonging to device N. Blank
+ * per-device columns are generated: discriminator, pincode, salt, verifier, serial-num and, with a PAI key,
+ * the DAC. With --count the first row is repeated with all per-device columns blank. Each device gets the
+ * same files the mfg tool writes, and a row in summary.csv as soon as its bundle is complete.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include "csv.h"
+#include "dac.h"
+#include "nvs_writer.h"
+#include "onboarding.h"
+#include "paths.h"
+#include "spake2p.h"
+
+#define DEFAULT_PARTITION_SIZE  0x6000 // fctry in partitions.csv
+#define DEFAULT_ITERATIONS      10000
+#define SALT_SIZE               32
+#define SERIAL_NUM_SIZE         16
+
+namespace fs = std::filesystem;
+
+typedef std::vector<uint8_t> bytes_t;
+
+typedef struct {
+    std::string key;
+    std::string type; // namespace, data or file
+    std::string encoding;
+} config_entry_t;
+
+typedef struct {
+    const char *config_path = "staging/config.csv";
+    const char *master_path = "staging/master.csv";
+    const char *pin_disc_path = NULL; // Default pin_disc.csv next to the master file, if there is one
+    const char *out_path = "out";
+    const char *pai_cert_path = NULL;
+    const char *pai_key_path = NULL;
+    const char *cd_path = NULL;
+    size_t count = 0;
+    unsigned jobs = 0;
+    size_t partition_size = DEFAULT_PARTITION_SIZE;
+    uint8_t discovery = ONBOARDING_DISCOVERY_BLE;
+} options_t;
+
+/* Appends rows to a CSV file and flushes each one, so an interrupted run keeps the finished devices
+ *
+ * Later runs append to the same file, as long as they write the same columns.
+ */
+class csv_appender {
+public:
+    bool open(const fs::path &path, const csv_row_t &header)
+    {
+        std::ifstream existing(path);
+        std::string line;
+        if (std::getline(existing, line) && !line.empty()) {
+            std::vector<csv_row_t> rows;
+            csv_parse(line.data(), line.size(), rows);
+            if (rows.empty() || rows[0] != header) {
+                fprintf(stderr, "%s has other columns, move it away to start a new one\n", path.c_str());
+                return false;
+            }
+            m_file = fopen(path.c_str(), "a");
+            return m_file != NULL;
+        }
+        m_file = fopen(path.c_str(), "w");
+        return m_file && append(header);
+    }
+
+    bool append(const csv_row_t &row)
+    {
+        std::string line = csv_format(row);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return fwrite(line.data(), 1, line.size(), m_file) == line.size() && fflush(m_file) == 0;
+    }
+
+    bool close()
+    {
+        bool ok = !m_file || fclose(m_file) == 0;
+        m_file = NULL;
+        return ok;
+    }
+
+private:
+    FILE *m_file = NULL;
+    std::mutex m_mutex;
+};
+
+/* Files shared by all devices, like the PAI certificate and the certification declaration, are read once */
+class file_cache {
+public:
+    std::shared_ptr<const bytes_t> get(const std::string &path)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_files.find(path);
+            if (it != m_files.end()) {
+                return it->second;
+            }
+        }
+        auto data = std::make_shared<bytes_t>();
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file) {
+            return NULL;
+        }
+        uint8_t buf[4096];
+        size_t len;
+        while ((len = fread(buf, 1, sizeof(buf), file)) > 0) {
+            data->insert(data->end(), buf, buf + len);
+        }
+        bool ok = !ferror(file);
+        fclose(file);
+        if (!ok) {
+            return NULL;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_files.emplace(path, data).first->second;
+    }
+
+private:
+    std::map<std::string, std::shared_ptr<const bytes_t>> m_files;
+    std::mutex m_mutex;
+};
+
+typedef struct {
+    const options_t *options;
+    std::vector<config_entry_t> config;
+    csv_row_t header;
+    std::vector<csv_row_t> rows;
+    dac_issuer_t issuer;
+    fs::path product_dir;
+    uint16_t vendor_id;
+    uint16_t product_id;
+    file_cache files;
+    csv_appender summary;
+    csv_appender cn_dacs;
+    std::atomic<size_t> next;
+    std::atomic<size_t> done;
+    std::atomic<size_t> failed;
+} batch_t;
+
+/* Per-device columns, blanked in the rows that --count adds */
+static const char *const k_device_columns[] = {
+    "discriminator", "pincode", "salt", "verifier", "serial-num", "dac-cert", "dac-key", "dac-pub-key",
+};
+
+static std::string base64_encode(const uint8_t *data, size_t size)
+{
+    std::string out(4 * ((size + 2) / 3) + 1, '\0');
+    int len = EVP_EncodeBlock((unsigned char *)&out[0], data, (int)size);
+    out.resize(len > 0 ? (size_t)len : 0);
+    return out;
+}
+
+static bool base64_decode(const std::string &text, bytes_t &out)
+{
+    out.resize(3 * ((text.size() + 3) / 4));
+    int len = EVP_DecodeBlock(out.data(), (const unsigned char *)text.data(), (int)text.size());
+    if (len < 0 || text.size() % 4) {
+        return false;
+    }
+    /* EVP_DecodeBlock counts the padding as data */
+    for (size_t i = text.size(); i > 0 && text[i - 1] == '='; i--) {
+        len--;
+    }
+    out.resize((size_t)len);
+    return true;
+}
+
+static std::string hex_encode(const uint8_t *data, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (size_t i = 0; i < size; i++) {
+        out += digits[data[i] >> 4];
+        out += digits[data[i] & 0x0F];
+    }
+    return out;
+}
+
+static bool hex_decode(const std::string &text, bytes_t &out)
+{
+    if (text.size() % 2) {
+        return false;
+    }
+    out.clear();
+    for (size_t i = 0; i < text.size(); i += 2) {
+        char byte[3] = {text[i], text[i + 1], '\0'};
+        char *end;
+        long value = strtol(byte, &end, 16);
+        if (*end) {
+            return false;
+        }
+        out.push_back((uint8_t)value);
+    }
+    return true;
+}
+
+static bool parse_number(const std::string &text, uint64_t *value)
+{
+    if (text.empty()) {
+        return false;
+    }
+    char *end;
+    *value = strtoull(text.c_str(), &end, 0);
+    return *end == '\0';
+}
+
+static uint32_t random_u32()
+{
+    uint32_t value = 0;
+    RAND_bytes((unsigned char *)&value, sizeof(value));
+    return value;
+}
+
+static std::string random_uuid()
+{
+    uint8_t uuid[16];
+    RAND_bytes(uuid, sizeof(uuid));
+    uuid[6] = (uuid[6] & 0x0F) | 0x40; // Version 4
+    uuid[8] = (uuid[8] & 0x3F) | 0x80; // RFC 4122 variant
+    std::string hex = hex_encode(uuid, sizeof(uuid));
+    return hex.substr(0, 8) + "-" + hex.substr(8, 4) + "-" + hex.substr(12, 4) + "-" + hex.substr(16, 4) + "-" +
+           hex.substr(20);
+}
+
+static bool write_file(const fs::path &path, const void *data, size_t size)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(data, 1, size, file) == size;
+    return fclose(file) == 0 && ok;
+}
+
+static bool write_file(const fs::path &path, const std::string &text)
+{
+    return write_file(path, text.data(), text.size());
+}
+
+typedef struct {
+    csv_row_t row;
+    std::map<std::string, bytes_t> generated_files; // Written by this device, served without reading them back
+    std::string error;
+} device_t;
+
+/* load_inputs() adds every column the tool reads or fills in to the header */
+static std::string &column(batch_t *batch, device_t *device, const char *name)
+{
+    thread_local std::string none;
+    int index = csv_column(batch->header, name);
+    if (index < 0) {
+        none.clear();
+        return none;
+    }
+    return device->row[index];
+}
+
+static bool fail(device_t *device, const std::string &error)
+{
+    device->error = error;
+    return false;
+}
+
+static bool file_contents(batch_t *batch, device_t *device, const std::string &path, bytes_t &out)
+{
+    auto generated = device->generated_files.find(path);
+    if (generated != device->generated_files.end()) {
+        out = generated->second;
+        return true;
+    }
+    std::string resolved = mfg_resolve_path(batch->product_dir, path);
+    auto cached = resolved.empty() ? NULL : batch->files.get(resolved);
+    if (!cached) {
+        return fail(device, "can not read " + path);
+    }
+    out = *cached;
+    return true;
+}
+
+static bool generate_credentials(batch_t *batch, device_t *device)
+{
+    std::string &discriminator = column(batch, device, "discriminator");
+    if (discriminator.empty()) {
+        discriminator = std::to_string(random_u32() & ONBOARDING_DISCRIMINATOR_MAX);
+    }
+    std::string &iterations = column(batch, device, "iteration-count");
+    if (iterations.empty()) {
+        iterations = std::to_string(DEFAULT_ITERATIONS);
+    }
+
+    std::string &verifier = column(batch, device, "verifier");
+    std::string &pincode = column(batch, device, "pincode");
+    if (pincode.empty()) {
+        if (!verifier.empty()) {
+            return fail(device, "the verifier is given without the pincode it was made from");
+        }
+        uint32_t passcode;
+        do {
+            passcode = random_u32() % 99999998 + 1;
+        } while (!spake2p_passcode_valid(passcode));
+        pincode = std::to_string(passcode);
+    }
+
+    std::string &salt = column(batch, device, "salt");
+    if (salt.empty()) {
+        uint8_t bytes[SALT_SIZE];
+        RAND_bytes(bytes, sizeof(bytes));
+        salt = base64_encode(bytes, sizeof(bytes));
+        verifier.clear(); // A given verifier belongs to another salt
+    }
+    if (verifier.empty()) {
+        uint64_t passcode, iteration_count;
+        bytes_t salt_bytes;
+        uint8_t bytes[SPAKE2P_VERIFIER_SIZE];
+        if (!parse_number(pincode, &passcode) || !spake2p_passcode_valid((uint32_t)passcode) ||
+            !parse_number(iterations, &iteration_count) || !base64_decode(salt, salt_bytes) ||
+            !spake2p_verifier((uint32_t)passcode, salt_bytes.data(), salt_bytes.size(), (uint32_t)iteration_count,
+                              bytes)) {
+            return fail(device, "invalid pincode, salt or iteration count");
+        }
+        verifier = base64_encode(bytes, sizeof(bytes));
+    }
+
+    std::string &serial = column(batch, device, "serial-num");
+    if (serial.empty()) {
+        uint8_t bytes[SERIAL_NUM_SIZE];
+        RAND_bytes(bytes, sizeof(bytes));
+        serial = hex_encode(bytes, sizeof(bytes));
+    }
+
+    std::string &pai_cert = column(batch, device, "pai-cert");
+    if (pai_cert.empty() && batch->options->pai_cert_path) {
+        pai_cert = fs::absolute(batch->options->pai_cert_path).string();
+    }
+    std::string &cd = column(batch, device, "cert-dclrn");
+    if (cd.empty() && batch->options->cd_path) {
+        cd = batch->options->cd_path;
+    }
+    return true;
+}
+
+static bool generate_dac(batch_t *batch, device_t *device, const std::string &uuid, const fs::path &internal)
+{
+    std::string &cert = column(batch, device, "dac-cert");
+    std::string &key = column(batch, device, "dac-key");
+    std::string &pub_key = column(batch, device, "dac-pub-key");
+    if (!cert.empty() || !key.empty() || !pub_key.empty()) {
+        return true;
+    }
+    if (!batch->issuer.key) {
+        return fail(device, "no DAC given and no PAI key to generate one, see --pai-key");
+    }
+
+    dac_t dac;
+    if (!dac_generate(&batch->issuer, batch->vendor_id, batch->product_id, uuid.c_str(), &dac)) {
+        return fail(device, "failed to generate the DAC");
+    }
+    cert = (internal / "DAC_cert.der").string();
+    key = (internal / "DAC_private_key.bin").string();
+    pub_key = (internal / "DAC_public_key.bin").string();
+    device->generated_files[cert] = dac.cert_der;
+    device->generated_files[key] = bytes_t(dac.private_key, dac.private_key + sizeof(dac.private_key));
+    device->generated_files[pub_key] = bytes_t(dac.public_key, dac.public_key + sizeof(dac.public_key));
+
+    bool ok = write_file(cert, dac.cert_der.data(), dac.cert_der.size()) &&
+              write_file(internal / "DAC_cert.pem", dac.cert_pem) &&
+              write_file(internal / "DAC_key.der", dac.key_der.data(), dac.key_der.size()) &&
+              write_file(internal / "DAC_key.pem", dac.key_pem) &&
+              write_file(key, dac.private_key, sizeof(dac.private_key)) &&
+              write_file(pub_key, dac.public_key, sizeof(dac.public_key)) &&
+              batch->cn_dacs.append({uuid, dac.cert_pem});
+    OPENSSL_cleanse(dac.private_key, sizeof(dac.private_key));
+    return ok || fail(device, "failed to write the DAC files");
+}
+
+static bool add_nvs_entry(batch_t *batch, device_t *device, nvs_writer &nvs, int ns, const config_entry_t &entry,
+                          const std::string &value)
+{
+    static const struct {
+        const char *name;
+        uint8_t type;
+    } integers[] = {
+        {"u8", NVS_TYPE_U8}, {"i8", NVS_TYPE_I8}, {"u16", NVS_TYPE_U16}, {"i16", NVS_TYPE_I16},
+        {"u32", NVS_TYPE_U32}, {"i32", NVS_TYPE_I32}, {"u64", NVS_TYPE_U64}, {"i64", NVS_TYPE_I64},
+    };
+    const char *key = entry.key.c_str();
+
+    bytes_t data;
+    if (entry.type == "file") {
+        if (!file_contents(batch, device, value, data)) {
+            return false;
+        }
+    } else {
+        data.assign(value.begin(), value.end());
+    }
+    std::string text(data.begin(), data.end());
+
+    for (const auto &integer : integers) {
+        if (entry.encoding == integer.name) {
+            char *end;
+            uint64_t number = integer.name[0] == 'u' ? strtoull(text.c_str(), &end, 0)
+                                                     : (uint64_t)strtoll(text.c_str(), &end, 0);
+            if (text.empty() || *end) {
+                return fail(device, entry.key + ": not a number");
+            }
+            return nvs.add_integer((uint8_t)ns, key, integer.type, number) || fail(device, nvs.error());
+        }
+    }
+    if (entry.encoding == "string") {
+        return nvs.add_string((uint8_t)ns, key, text) || fail(device, nvs.error());
+    }
+    if (entry.encoding == "hex2bin" && !hex_decode(text, data)) {
+        return fail(device, entry.key + ": invalid hex");
+    }
+    if (entry.encoding == "base64" && !base64_decode(text, data)) {
+        return fail(device, entry.key + ": invalid base64");
+    }
+    if (entry.encoding == "binary" || entry.encoding == "hex2bin" || entry.encoding == "base64") {
+        return nvs.add_blob((uint8_t)ns, key, data.data(), data.size()) || fail(device, nvs.error());
+    }
+    return fail(device, entry.key + ": unsupported encoding " + entry.encoding);
+}
+
+static bool build_partition(batch_t *batch, device_t *device, const fs::path &internal, bytes_t &image)
+{
+    nvs_writer nvs;
+    if (!nvs.init(batch->options->partition_size)) {
+        return fail(device, nvs.error());
+    }
+    std::string partition_csv = csv_format({"key", "type", "encoding", "value"}, "\r\n");
+    int ns = -1;
+    for (const config_entry_t &entry : batch->config) {
+        if (entry.type == "namespace") {
+            ns = nvs.add_namespace(entry.key.c_str());
+            if (ns < 0) {
+                return fail(device, nvs.error());
+            }
+            partition_csv += csv_format({entry.key, entry.type, "", ""}, "\r\n");
+            continue;
+        }
+        if (ns < 0) {
+            return fail(device, "config.csv has to start with a namespace");
+        }
+        const std::string &value = column(batch, device, entry.key.c_str());
+        if (value.empty()) {
+            return fail(device, "no value for " + entry.key);
+        }
+        if (!add_nvs_entry(batch, device, nvs, ns, entry, value)) {
+            return false;
+        }
+        partition_csv += csv_format({entry.key, entry.type, entry.encoding, value}, "\r\n");
+    }
+    nvs.finish();
+    image = nvs.image();
+    return write_file(internal / "partition.csv", partition_csv) || fail(device, "failed to write partition.csv");
+}
+
+static bool build_bundle(batch_t *batch, device_t *device)
+{
+    if (!generate_credentials(batch, device)) {
+        return false;
+    }
+
+    std::string uuid = random_uuid();
+    fs::path dir = batch->product_dir / uuid;
+    fs::path internal = dir / "internal";
+    std::error_code ec;
+    fs::create_directories(internal, ec);
+    if (ec) {
+        return fail(device, "can not create " + internal.string());
+    }
+    if (!generate_dac(batch, device, uuid, internal)) {
+        return false;
+    }
+
+    bytes_t pai_cert;
+    bytes_t image;
+    if (!file_contents(batch, device, column(batch, device, "pai-cert"), pai_cert) ||
+        !build_partition(batch, device, internal, image)) {
+        return false;
+    }
+
+    uint64_t discriminator = 0, passcode = 0;
+    parse_number(column(batch, device, "discriminator"), &discriminator);
+    parse_number(column(batch, device, "pincode"), &passcode);
+    std::string qrcode = onboarding_qr_payload(batch->vendor_id, batch->product_id, batch->options->discovery,
+                                               (uint16_t)discriminator, (uint32_t)passcode);
+    std::string manualcode = onboarding_manual_code((uint16_t)discriminator, (uint32_t)passcode);
+    std::string onb_codes = csv_format({"qrcode", "manualcode", "discriminator", "passcode"}) +
+                            csv_format({qrcode, manualcode, std::to_string(discriminator), std::to_string(passcode)});
+
+    if (!write_file(internal / "PAI_cert.der", pai_cert.data(), pai_cert.size()) ||
+        !write_file(dir / (uuid + "-partition.bin"), image.data(), image.size()) ||
+        !write_file(dir / (uuid + "-onb_codes.csv"), onb_codes) ||
+        !onboarding_write_qr_png(qrcode, (dir / (uuid + "-qrcode.png")).c_str())) {
+        return fail(device, "failed to write the bundle to " + dir.string());
+    }
+
+    /* Summary columns are the master columns followed by the onboarding codes */
+    csv_row_t summary;
+    for (size_t i = 0; i < batch->header.size(); i++) {
+        if (batch->header[i] != "pincode") {
+            summary.push_back(device->row[i]);
+        }
+    }
+    summary.push_back(column(batch, device, "pincode"));
+    summary.push_back(qrcode);
+    summary.push_back(manualcode);
+    return batch->summary.append(summary) || fail(device, "failed to append to the summary");
+}
+
+static void worker(batch_t *batch)
+{
+    size_t count = batch->options->count;
+    for (size_t index = batch->next++; index < count; index = batch->next++) {
+        device_t device;
+        if (index < batch->rows.size()) {
+            device.row = batch->rows[index];
+        } else {
+            device.row = batch->rows[0];
+            for (const char *name : k_device_columns) {
+                column(batch, &device, name).clear();
+            }
+        }
+        if (!build_bundle(batch, &device)) {
+            fprintf(stderr, "\ndevice %zu: %s\n", index, device.error.c_str());
+            batch->failed++;
+        }
+        batch->done++;
+    }
+}
+
+/* Columns of the mfg tool's pin_disc.csv and the master columns they fill in */
+static const struct {
+    const char *pin_disc;
+    const char *master;
+} k_pin_disc_columns[] = {
+    {"PIN Code", "pincode"}, {"Iteration Count", "iteration-count"}, {"Salt", "salt"},
+    {"Verifier", "verifier"}, {"Discriminator", "discriminator"},
+};
+
+static bool load_pin_disc(batch_t *batch)
+{
+    const options_t *options = batch->options;
+    std::string path;
+    if (options->pin_disc_path) {
+        path = options->pin_disc_path;
+    } else {
+        path = (fs::path(options->master_path).parent_path() / "pin_disc.csv").string();
+        std::error_code ec;
+        if (!fs::exists(path, ec)) {
+            return true;
+        }
+    }
+
+    std::vector<csv_row_t> rows;
+    if (!csv_read(path.c_str(), rows) || rows.empty()) {
+        fprintf(stderr, "Can not read %s\n", path.c_str());
+        return false;
+    }
+    int index_column = csv_column(rows[0], "Index");
+    if (index_column < 0) {
+        fprintf(stderr, "%s: the Index column is missing\n", path.c_str());
+        return false;
+    }
+    for (size_t i = 1; i < rows.size(); i++) {
+        const csv_row_t &row = rows[i];
+        uint64_t index;
+        if ((size_t)index_column >= row.size() || !parse_number(row[index_column], &index) ||
+            index >= batch->rows.size()) {
+            fprintf(stderr, "%s:%zu: Index is not a row of %s\n", path.c_str(), i + 1, options->master_path);
+            return false;
+        }
+        csv_row_t &device = batch->rows[index];
+        for (const auto &names : k_pin_disc_columns) {
+            int from = csv_column(rows[0], names.pin_disc);
+            int to = csv_column(batch->header, names.master);
+            if (from < 0 || to < 0 || (size_t)from >= row.size() || row[from].empty()) {
+                continue;
+            }
+            std::string &value = device[to];
+            if (value.empty()) {
+                value = row[from];
+            } else if (value != row[from]) {
+                fprintf(stderr, "%s:%zu: %s %s does not match %s %s of %s\n", path.c_str(), i + 1, names.pin_disc,
+                        row[from].c_str(), names.master, value.c_str(), options->master_path);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool load_inputs(batch_t *batch)
+{
+    const options_t *options = batch->options;
+    std::vector<csv_row_t> rows;
+    if (!csv_read(options->config_path, rows)) {
+        fprintf(stderr, "Can not read %s\n", options->config_path);
+        return false;
+    }
+    for (const csv_row_t &row : rows) {
+        if (row.size() < 2) {
+            fprintf(stderr, "%s: expected key,type,encoding\n", options->config_path);
+            return false;
+        }
+        batch->config.push_back({row[0], row[1], row.size() > 2 ? row[2] : ""});
+    }
+
+    rows.clear();
+    if (!csv_read(options->master_path, rows) || rows.size() < 2) {
+        fprintf(stderr, "Can not read any device from %s\n", options->master_path);
+        return false;
+    }
+    batch->header = rows[0];
+    batch->rows.assign(rows.begin() + 1, rows.end());
+    for (const char *name : k_device_columns) {
+        if (csv_column(batch->header, name) < 0) {
+            batch->header.push_back(name);
+        }
+    }
+    for (const config_entry_t &entry : batch->config) {
+        if (entry.type != "namespace" && csv_column(batch->header, entry.key.c_str()) < 0) {
+            batch->header.push_back(entry.key);
+        }
+    }
+    for (csv_row_t &row : batch->rows) {
+        row.resize(batch->header.size());
+    }
+    if (!load_pin_disc(batch)) {
+        return false;
+    }
+
+    uint64_t vendor_id, product_id;
+    const csv_row_t &first = batch->rows[0];
+    int vendor_column = csv_column(batch->header, "vendor-id");
+    int product_column = csv_column(batch->header, "product-id");
+    if (vendor_column < 0 || product_column < 0 || !parse_number(first[vendor_column], &vendor_id) ||
+        !parse_number(first[product_column], &product_id)) {
+        fprintf(stderr, "%s: vendor-id and product-id are required\n", options->master_path);
+        return false;
+    }
+    for (const csv_row_t &row : batch->rows) {
+        if (row[vendor_column] != first[vendor_column] || row[product_column] != first[product_column]) {
+            fprintf(stderr, "%s: all devices of a batch need the same vendor-id and product-id\n",
+                    options->master_path);
+            return false;
+        }
+    }
+    batch->vendor_id = (uint16_t)vendor_id;
+    batch->product_id = (uint16_t)product_id;
+
+    if (options->pai_key_path) {
+        if (!options->pai_cert_path ||
+            !dac_issuer_load(options->pai_cert_path, options->pai_key_path, &batch->issuer)) {
+            fprintf(stderr, "Can not load the PAI, --pai-cert and --pai-key have to be a matching pair\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -c, --config PATH     NVS key layout, default staging/config.csv\n"
+            "  -m, --master PATH     one row per device, default staging/master.csv\n"
+            "      --pin-disc PATH   passcodes by row Index, default pin_disc.csv next to the master file\n"
+            "  -o, --out PATH        output directory, bundles go to PATH/<vid>_<pid>, default out\n"
+            "  -n, --count N         number of devices, default the rows of the master file\n"
+            "  -j, --jobs N          worker threads, default the number of CPUs\n"
+            "      --pai-cert PATH   PAI certificate for blank pai-cert columns and DAC generation\n"
+            "      --pai-key PATH    PAI private key, needed to generate DACs\n"
+            "      --cd PATH         certification declaration for blank cert-dclrn columns\n"
+            "      --size N          partition size, default 0x%x\n"
+            "      --discovery N     discovery capabilities of the QR code, default %d (BLE)\n",
+            name, DEFAULT_PARTITION_SIZE, ONBOARDING_DISCOVERY_BLE);
+}
+
+int main(int argc, char **argv)
+{
+    enum { OPT_PIN_DISC = 256, OPT_PAI_CERT, OPT_PAI_KEY, OPT_CD, OPT_SIZE, OPT_DISCOVERY };
+    static const struct option long_options[] = {
+        {"config", required_argument, NULL, 'c'},
+        {"master", required_argument, NULL, 'm'},
+        {"pin-disc", required_argument, NULL, OPT_PIN_DISC},
+        {"out", required_argument, NULL, 'o'},
+        {"count", required_argument, NULL, 'n'},
+        {"jobs", required_argument, NULL, 'j'},
+        {"pai-cert", required_argument, NULL, OPT_PAI_CERT},
+        {"pai-key", required_argument, NULL, OPT_PAI_KEY},
+        {"cd", required_argument, NULL, OPT_CD},
+        {"size", required_argument, NULL, OPT_SIZE},
+        {"discovery", required_argument, NULL, OPT_DISCOVERY},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    options_t options;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "c:m:o:n:j:h", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'c': options.config_path = optarg; break;
+        case 'm': options.master_path = optarg; break;
+        case OPT_PIN_DISC: options.pin_disc_path = optarg; break;
+        case 'o': options.out_path = optarg; break;
+        case 'n': options.count = strtoul(optarg, NULL, 0); break;
+        case 'j': options.jobs = (unsigned)strtoul(optarg, NULL, 0); break;
+        case OPT_PAI_CERT: options.pai_cert_path = optarg; break;
+        case OPT_PAI_KEY: options.pai_key_path = optarg; break;
+        case OPT_CD: options.cd_path = optarg; break;
+        case OPT_SIZE: options.partition_size = strtoul(optarg, NULL, 0); break;
+        case OPT_DISCOVERY: options.discovery = (uint8_t)strtoul(optarg, NULL, 0); break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    batch_t *batch = new batch_t();
+    batch->options = &options;
+    if (!load_inputs(batch)) {
+        return 1;
+    }
+    if (options.count == 0) {
+        options.count = batch->rows.size();
+    }
+    if (options.jobs == 0) {
+        options.jobs = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    }
+
+    char product[16];
+    snprintf(product, sizeof(product), "%04x_%04x", batch->vendor_id, batch->product_id);
+    batch->product_dir = fs::absolute(options.out_path) / product;
+    csv_row_t summary_header;
+    for (const std::string &name : batch->header) {
+        if (name != "pincode") {
+            summary_header.push_back(name);
+        }
+    }
+    summary_header.insert(summary_header.end(), {"pincode", "qrcode", "manualcode"});
+    std::error_code ec;
+    fs::create_directories(batch->product_dir, ec);
+    if (!batch->summary.open(batch->product_dir / "summary.csv", summary_header) ||
+        !batch->cn_dacs.open(batch->product_dir / "cn_dacs.csv", {"CN", "certs"})) {
+        fprintf(stderr, "Can not write the summary to %s\n", batch->product_dir.c_str());
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < options.jobs; i++) {
+        threads.emplace_back(worker, batch);
+    }
+    for (unsigned tick = 1; batch->done < options.count; tick++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (tick % 10 == 0) {
+            fprintf(stderr, "\r%zu/%zu devices, %.1f devices/s", batch->done.load(), options.count,
+                    batch->done / elapsed());
+        }
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    double seconds = elapsed();
+
+    bool ok = batch->summary.close() & batch->cn_dacs.close();
+    size_t failed = batch->failed;
+    printf("\n%zu devices in %.2f s, %.1f devices/s with %u threads, %zu failed\n", options.count - failed, seconds,
+           (options.count - failed) / seconds, options.jobs, failed);
+    printf("Bundles and summary.csv are in %s\n", batch->product_dir.c_str());
+    dac_issuer_free(&batch->issuer);
+    delete batch;
+    return ok && failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,496 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* Checks every <uuid>-partition.bin of out/<vid>_<pid> against its row in summary.csv or summary-*.csv
+ *
+ * Images are mapped read-only and parsed in place, one worker thread per CPU. Each image is matched to its
+ * row by the UUID directory of the row's dac-cert path, or by serial number. The integers and strings of the
+ * factory namespace are compared with the row and the blobs with the files the row refers to. The image
+ * also has to be a valid NVS partition that fits the target partition of partitions.csv, and every item of the
+ * namespace has to be found by the lookup the firmware runs on its flash mapping, see main/app_factory_nvs.h.
+ *
+ * One JSON object per image is written to stdout as soon as it is checked, the totals go to stderr.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app_factory_nvs.h"
+#include "csv.h"
+#include "mapped_file.h"
+#include "nvs_reader.h"
+#include "partition_table.h"
+#include "paths.h"
+
+#define DEFAULT_NAMESPACE   "chip-factory"
+#define DEFAULT_LABEL       "fctry"
+#define IMAGE_SUFFIX        "-partition.bin"
+
+namespace fs = std::filesystem;
+
+typedef struct {
+    std::string key;
+    bool is_file; // The summary holds the path of the blob, not its value
+} expected_key_t;
+
+typedef struct {
+    const csv_row_t *header;
+    csv_row_t row;
+} summary_row_t;
+
+typedef struct {
+    fs::path product_dir;
+    std::string ns;
+    std::vector<expected_key_t> keys;
+    std::vector<csv_row_t> headers; // One per summary file
+    std::vector<summary_row_t> rows;
+    std::map<std::string, size_t> rows_by_uuid;
+    std::map<std::string, size_t> rows_by_serial;
+    std::vector<fs::path> images;
+    partition_t target;
+
+    std::map<std::string, std::shared_ptr<mapped_file>> references;
+    std::mutex references_mutex;
+    std::vector<uint8_t> row_seen; // Written by the worker that matched the row
+    std::mutex output_mutex;
+    std::atomic<size_t> next;
+    std::atomic<size_t> mismatched;
+} verify_t;
+
+static std::string json_string(const std::string &text)
+{
+    std::string out = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += (char)c;
+        }
+    }
+    return out + "\"";
+}
+
+class diff_list {
+public:
+    void add(const std::string &key, const char *reason, const std::string &expected = "",
+             const std::string &actual = "")
+    {
+        std::string diff = "{\"key\":" + json_string(key) + ",\"reason\":\"" + reason + "\"";
+        if (!expected.empty() || !actual.empty()) {
+            diff += ",\"expected\":" + json_string(expected) + ",\"actual\":" + json_string(actual);
+        }
+        m_diffs.push_back(diff + "}");
+    }
+
+    bool empty() const { return m_diffs.empty(); }
+
+    std::string json() const
+    {
+        std::string out = "[";
+        for (size_t i = 0; i < m_diffs.size(); i++) {
+            out += (i ? "," : "") + m_diffs[i];
+        }
+        return out + "]";
+    }
+
+private:
+    std::vector<std::string> m_diffs;
+};
+
+static void emit(verify_t *verify, const std::string &image, const std::string &uuid, const char *status,
+                 const diff_list &diffs)
+{
+    std::string line = "{\"image\":" + json_string(image) + ",\"uuid\":" + json_string(uuid) + ",\"status\":\"" +
+                       status + "\",\"diffs\":" + diffs.json() + "}\n";
+    std::lock_guard<std::mutex> lock(verify->output_mutex);
+    fwrite(line.data(), 1, line.size(), stdout);
+}
+
+static const std::string *row_value(const summary_row_t &row, const char *name)
+{
+    int index = csv_column(*row.header, name);
+    return index >= 0 && (size_t)index < row.row.size() ? &row.row[index] : NULL;
+}
+
+/* UUID directory of a bundle file path like .../<uuid>/internal/DAC_cert.der */
+static std::string bundle_uuid(const std::string &path)
+{
+    fs::path parent = fs::path(path).parent_path();
+    if (parent.filename() == "internal") {
+        parent = parent.parent_path();
+    }
+    return parent.filename().string();
+}
+
+static std::shared_ptr<mapped_file> reference(verify_t *verify, const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(verify->references_mutex);
+    auto it = verify->references.find(path);
+    if (it != verify->references.end()) {
+        return it->second;
+    }
+    auto file = std::make_shared<mapped_file>();
+    if (!file->open(path.c_str())) {
+        file = NULL;
+    }
+    verify->references[path] = file;
+    return file;
+}
+
+static void compare_item(verify_t *verify, const expected_key_t &key, const std::string &expected,
+                         const nvs_item_t *item, diff_list &diffs)
+{
+    if (!item) {
+        diffs.add(key.key, "missing_in_image");
+        return;
+    }
+    if (key.is_file) {
+        std::string path = mfg_resolve_path(verify->product_dir, expected);
+        auto file = path.empty() ? NULL : reference(verify, path);
+        if (!file) {
+            diffs.add(key.key, "reference_missing", expected, "");
+        } else if (item->type != NVS_TYPE_BLOB_IDX) {
+            diffs.add(key.key, "type", "blob", "");
+        } else if (file->size() != item->size || memcmp(file->data(), item->data, item->size) != 0) {
+            size_t offset = 0;
+            size_t common = file->size() < item->size ? file->size() : item->size;
+            while (offset < common && file->data()[offset] == item->data[offset]) {
+                offset++;
+            }
+            diffs.add(key.key, "content", "size " + std::to_string(file->size()),
+                      "size " + std::to_string(item->size) + ", first difference at " + std::to_string(offset));
+        }
+        return;
+    }
+    if (item->type == NVS_TYPE_STR) {
+        std::string actual((const char *)item->data, item->size);
+        if (actual != expected) {
+            diffs.add(key.key, "value", expected, actual);
+        }
+    } else if (nvs_type_size(item->type)) {
+        char *end;
+        uint64_t value = strtoull(expected.c_str(), &end, 0);
+        if (expected.empty() || *end || value != item->value) {
+            diffs.add(key.key, "value", expected, std::to_string(item->value));
+        }
+    } else {
+        diffs.add(key.key, "type", "string or integer", "blob");
+    }
+}
+
+static uint32_t zlib_crc32(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    return (uint32_t)crc32(crc, buf, len);
+}
+
+/* The firmware serves these items from the mapping and reads the others through the NVS API */
+static void compare_firmware_lookup(const verify_t *verify, const uint8_t *image, size_t size, const nvs_item_t &item,
+                                    diff_list &diffs)
+{
+    std::string key(item.key);
+    app_factory_nvs_item_t found;
+    if (item.type == NVS_TYPE_BLOB_IDX || item.type == NVS_TYPE_STR) {
+        uint8_t type = item.type == NVS_TYPE_STR ? APP_FACTORY_NVS_TYPE_STR : APP_FACTORY_NVS_TYPE_BLOB;
+        if (!app_factory_nvs_find(image, size, verify->ns.c_str(), key.c_str(), type, zlib_crc32, &found)) {
+            diffs.add(key, "not_mappable");
+        } else if (found.data != item.data || found.size != item.size) {
+            diffs.add(key, "firmware_lookup", "offset " + std::to_string(item.data - image),
+                      "offset " + std::to_string(found.data - image));
+        }
+    } else if (item.type == NVS_TYPE_U8 || item.type == NVS_TYPE_U16 || item.type == NVS_TYPE_U32) {
+        if (!app_factory_nvs_find(image, size, verify->ns.c_str(), key.c_str(), item.type, zlib_crc32, &found)) {
+            diffs.add(key, "not_mappable");
+        } else if (found.value != item.value) {
+            diffs.add(key, "firmware_lookup", std::to_string(item.value), std::to_string(found.value));
+        }
+    }
+}
+
+static void verify_image(verify_t *verify, const fs::path &path)
+{
+    std::string name = path.filename().string();
+    std::string uuid = name.substr(0, name.size() - strlen(IMAGE_SUFFIX));
+    diff_list diffs;
+
+    mapped_file image;
+    if (!image.open(path.c_str())) {
+        diffs.add("", "unreadable");
+        emit(verify, path.string(), uuid, "error", diffs);
+        verify->mismatched++;
+        return;
+    }
+
+    if (image.size() > verify->target.size) {
+        diffs.add("", "layout", "at most " + std::to_string(verify->target.size) + " bytes for " + verify->target.name,
+                  std::to_string(image.size()) + " bytes");
+    }
+    nvs_reader reader;
+    if (!reader.parse(image.data(), image.size())) {
+        for (const std::string &error : reader.errors()) {
+            diffs.add("", "corrupt", "", error);
+        }
+    }
+
+    size_t row_index = SIZE_MAX;
+    auto by_uuid = verify->rows_by_uuid.find(uuid);
+    if (by_uuid != verify->rows_by_uuid.end()) {
+        row_index = by_uuid->second;
+    } else {
+        const nvs_item_t *serial = reader.find(verify->ns.c_str(), "serial-num");
+        auto by_serial = serial && serial->type == NVS_TYPE_STR
+                             ? verify->rows_by_serial.find(std::string((const char *)serial->data, serial->size))
+                             : verify->rows_by_serial.end();
+        if (by_serial != verify->rows_by_serial.end()) {
+            row_index = by_serial->second;
+        }
+    }
+    if (row_index == SIZE_MAX) {
+        emit(verify, path.string(), uuid, "no_summary_row", diffs);
+        verify->mismatched++;
+        return;
+    }
+    const summary_row_t &row = verify->rows[row_index];
+    verify->row_seen[row_index] = 1;
+
+    std::set<std::string_view> expected_keys;
+    for (const expected_key_t &key : verify->keys) {
+        expected_keys.insert(key.key);
+        const std::string *expected = row_value(row, key.key.c_str());
+        if (expected) {
+            compare_item(verify, key, *expected, reader.find(verify->ns.c_str(), key.key.c_str()), diffs);
+        }
+    }
+    for (const nvs_item_t &item : reader.items()) {
+        if (reader.namespace_name(item.ns) != verify->ns) {
+            continue;
+        }
+        if (!expected_keys.count(item.key)) {
+            diffs.add(std::string(item.key), "unexpected_in_image");
+        }
+        compare_firmware_lookup(verify, image.data(), image.size(), item, diffs);
+    }
+
+    emit(verify, path.string(), uuid, diffs.empty() ? "ok" : "mismatch", diffs);
+    if (!diffs.empty()) {
+        verify->mismatched++;
+    }
+}
+
+static void worker(verify_t *verify)
+{
+    for (size_t index = verify->next++; index < verify->images.size(); index = verify->next++) {
+        verify_image(verify, verify->images[index]);
+    }
+}
+
+static bool load_keys(verify_t *verify, const char *config_path)
+{
+    if (config_path) {
+        std::vector<csv_row_t> rows;
+        if (!csv_read(config_path, rows)) {
+            fprintf(stderr, "Can not read %s\n", config_path);
+            return false;
+        }
+        for (const csv_row_t &row : rows) {
+            if (row.size() >= 2 && row[1] != "namespace") {
+                verify->keys.push_back({row[0], row[1] == "file"});
+            }
+        }
+        return true;
+    }
+
+    /* Without config.csv, check the keys the mfg tool writes for Matter */
+    static const expected_key_t defaults[] = {
+        {"discriminator", false}, {"iteration-count", false}, {"salt", false}, {"verifier", false},
+        {"vendor-id", false}, {"product-id", false}, {"serial-num", false}, {"dac-cert", true},
+        {"dac-key", true}, {"dac-pub-key", true}, {"pai-cert", true}, {"cert-dclrn", true},
+    };
+    verify->keys.assign(defaults, defaults + sizeof(defaults) / sizeof(defaults[0]));
+    return true;
+}
+
+static bool load_summaries(verify_t *verify, std::vector<std::string> paths)
+{
+    std::error_code ec;
+    if (paths.empty()) {
+        for (const auto &entry : fs::directory_iterator(verify->product_dir, ec)) {
+            std::string name = entry.path().filename().string();
+            if ((name == "summary.csv" || name.rfind("summary-", 0) == 0) && entry.path().extension() == ".csv") {
+                paths.push_back(entry.path().string());
+            }
+        }
+    }
+    if (paths.empty()) {
+        fprintf(stderr, "No summary.csv or summary-*.csv in %s\n", verify->product_dir.c_str());
+        return false;
+    }
+
+    verify->headers.reserve(paths.size()); // Rows keep pointers to their header
+    for (const std::string &path : paths) {
+        std::vector<csv_row_t> rows;
+        if (!csv_read(path.c_str(), rows) || rows.empty()) {
+            fprintf(stderr, "Can not read %s\n", path.c_str());
+            return false;
+        }
+        const csv_row_t &header = verify->headers.emplace_back(rows[0]);
+        for (size_t i = 1; i < rows.size(); i++) {
+            verify->rows.push_back({&header, rows[i]});
+        }
+    }
+
+    for (size_t i = 0; i < verify->rows.size(); i++) {
+        const std::string *dac_cert = row_value(verify->rows[i], "dac-cert");
+        const std::string *serial = row_value(verify->rows[i], "serial-num");
+        if (dac_cert && !dac_cert->empty()) {
+            verify->rows_by_uuid[bundle_uuid(*dac_cert)] = i;
+        }
+        if (serial && !serial->empty()) {
+            verify->rows_by_serial[*serial] = i;
+        }
+    }
+    verify->row_seen.assign(verify->rows.size(), 0);
+    return true;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <out/<vid>_<pid>>\n"
+            "  -s, --summary PATH      summary CSV, can be repeated, default all summary*.csv of the directory\n"
+            "  -c, --config PATH       NVS key layout, default staging/config.csv of the directory if present\n"
+            "  -p, --partitions PATH   partition table, default partitions.csv\n"
+            "  -l, --label NAME        partition the images are flashed to, default " DEFAULT_LABEL "\n"
+            "  -n, --namespace NAME    NVS namespace of the factory data, default " DEFAULT_NAMESPACE "\n"
+            "  -j, --jobs N            worker threads, default the number of CPUs\n",
+            name);
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option long_options[] = {
+        {"summary", required_argument, NULL, 's'},
+        {"config", required_argument, NULL, 'c'},
+        {"partitions", required_argument, NULL, 'p'},
+        {"label", required_argument, NULL, 'l'},
+        {"namespace", required_argument, NULL, 'n'},
+        {"jobs", required_argument, NULL, 'j'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    std::vector<std::string> summary_paths;
+    const char *config_path = NULL;
+    const char *partitions_path = "partitions.csv";
+    const char *label = DEFAULT_LABEL;
+    const char *ns = DEFAULT_NAMESPACE;
+    unsigned jobs = 0;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:c:p:l:n:j:h", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 's': summary_paths.push_back(optarg); break;
+        case 'c': config_path = optarg; break;
+        case 'p': partitions_path = optarg; break;
+        case 'l': label = optarg; break;
+        case 'n': ns = optarg; break;
+        case 'j': jobs = (unsigned)strtoul(optarg, NULL, 0); break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind + 1 != argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    verify_t *verify = new verify_t();
+    verify->product_dir = fs::absolute(argv[optind]).lexically_normal();
+    if (verify->product_dir.filename().empty()) {
+        verify->product_dir = verify->product_dir.parent_path();
+    }
+    verify->ns = ns;
+
+    std::error_code ec;
+    std::string default_config = (verify->product_dir / "staging" / "config.csv").string();
+    if (!config_path && fs::exists(default_config, ec)) {
+        config_path = default_config.c_str();
+    }
+    std::vector<partition_t> partitions;
+    std::string error;
+    if (!partition_table_read(partitions_path, PARTITION_TABLE_OFFSET, partitions, error)) {
+        fprintf(stderr, "%s: %s\n", partitions_path, error.c_str());
+        return 1;
+    }
+    const partition_t *target = partition_table_find(partitions, label);
+    if (!target || target->type != "data" || target->subtype != "nvs") {
+        fprintf(stderr, "%s has no NVS data partition named %s\n", partitions_path, label);
+        return 1;
+    }
+    verify->target = *target;
+    if (!load_keys(verify, config_path) || !load_summaries(verify, summary_paths)) {
+        return 1;
+    }
+
+    for (const auto &entry : fs::recursive_directory_iterator(verify->product_dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (entry.is_regular_file() && name.size() > strlen(IMAGE_SUFFIX) &&
+            name.compare(name.size() - strlen(IMAGE_SUFFIX), std::string::npos, IMAGE_SUFFIX) == 0) {
+            verify->images.push_back(entry.path());
+        }
+    }
+
+    if (jobs == 0) {
+        jobs = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < jobs; i++) {
+        threads.emplace_back(worker, verify);
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    /* Rows that no image matched */
+    size_t missing = 0;
+    for (size_t i = 0; i < verify->rows.size(); i++) {
+        if (!verify->row_seen[i]) {
+            const std::string *dac_cert = row_value(verify->rows[i], "dac-cert");
+            emit(verify, "", dac_cert ? bundle_uuid(*dac_cert) : "", "missing_image", diff_list());
+            missing++;
+        }
+    }
+    fflush(stdout);
+
+    size_t mismatched = verify->mismatched;
+    fprintf(stderr, "%zu images in %.3f s, %.0f images/s with %u threads: %zu ok, %zu mismatched, %zu rows without image\n",
+            verify->images.size(), seconds, seconds > 0 ? verify->images.size() / seconds : 0.0, jobs,
+            verify->images.size() - mismatched, mismatched, missing);
+    fprintf(stderr, "Target partition %s at 0x%x, 0x%x bytes\n", target->name.c_str(), target->offset, target->size);
+    delete verify;
+    return mismatched || missing ? 1 : 0;
+}
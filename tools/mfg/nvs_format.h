@@ -0,0 +1,138 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <zlib.h>
+
+/* On-flash layout of an NVS partition, format version 2 as written by nvs_partition_gen.py and read by nvs_flash.
+ * All fields are little endian, the tools only run on little endian hosts.
+ */
+
+#define NVS_PAGE_SIZE           4096
+#define NVS_ENTRY_SIZE          32
+#define NVS_ENTRY_COUNT         126
+#define NVS_BITMAP_OFFSET       32
+#define NVS_ENTRY_OFFSET        64 // Page header and entry state bitmap
+#define NVS_KEY_SIZE            16 // Including the terminating NUL
+#define NVS_NAMESPACE_MAX       254
+
+#define NVS_PAGE_STATE_EMPTY    0xFFFFFFFF
+#define NVS_PAGE_STATE_ACTIVE   0xFFFFFFFE
+#define NVS_PAGE_STATE_FULL     0xFFFFFFFC
+#define NVS_PAGE_STATE_FREEING  0xFFFFFFF8
+#define NVS_PAGE_VERSION_2      0xFE
+
+#define NVS_ENTRY_STATE_EMPTY   3
+#define NVS_ENTRY_STATE_WRITTEN 2
+#define NVS_ENTRY_STATE_ERASED  0
+
+#define NVS_TYPE_U8             0x01
+#define NVS_TYPE_I8             0x11
+#define NVS_TYPE_U16            0x02
+#define NVS_TYPE_I16            0x12
+#define NVS_TYPE_U32            0x04
+#define NVS_TYPE_I32            0x14
+#define NVS_TYPE_U64            0x08
+#define NVS_TYPE_I64            0x18
+#define NVS_TYPE_STR            0x21
+#define NVS_TYPE_BLOB_DATA      0x42
+#define NVS_TYPE_BLOB_IDX       0x48
+
+#define NVS_CHUNK_ANY           0xFF
+
+typedef struct __attribute__((packed)) {
+    uint32_t state;
+    uint32_t seq;
+    uint8_t version;
+    uint8_t reserved[19];
+    uint32_t crc32; // Over seq, version and reserved
+} nvs_page_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t ns;
+    uint8_t type;
+    uint8_t span; // Entries taken by this item, including the data entries that follow it
+    uint8_t chunk_index;
+    uint32_t crc32; // Over the entry without this field
+    char key[NVS_KEY_SIZE];
+    union {
+        uint8_t raw[8];
+        struct __attribute__((packed)) {
+            uint16_t size;
+            uint16_t reserved;
+            uint32_t data_crc32;
+        } var; // NVS_TYPE_STR and NVS_TYPE_BLOB_DATA
+        struct __attribute__((packed)) {
+            uint32_t size;
+            uint8_t chunk_count;
+            uint8_t chunk_start;
+            uint16_t reserved;
+        } blob_index; // NVS_TYPE_BLOB_IDX
+    } data;
+} nvs_entry_t;
+
+static_assert(sizeof(nvs_page_header_t) == NVS_ENTRY_SIZE, "NVS page header size mismatch");
+static_assert(sizeof(nvs_entry_t) == NVS_ENTRY_SIZE, "NVS entry size mismatch");
+
+/* NVS uses the ROM crc32_le with an initial value of 0xFFFFFFFF, which is zlib's crc32() seeded the same way */
+static inline uint32_t nvs_crc32(const void *data, size_t size)
+{
+    return (uint32_t)crc32(0xFFFFFFFF, (const Bytef *)data, (uInt)size);
+}
+
+static inline uint32_t nvs_page_header_crc(const nvs_page_header_t *header)
+{
+    return nvs_crc32(&header->seq, offsetof(nvs_page_header_t, crc32) - offsetof(nvs_page_header_t, seq));
+}
+
+static inline uint32_t nvs_entry_crc(const nvs_entry_t *entry)
+{
+    uint8_t buf[NVS_ENTRY_SIZE - sizeof(uint32_t)];
+    const uint8_t *raw = (const uint8_t *)entry;
+    for (size_t i = 0; i < offsetof(nvs_entry_t, crc32); i++) {
+        buf[i] = raw[i];
+    }
+    for (size_t i = offsetof(nvs_entry_t, key); i < NVS_ENTRY_SIZE; i++) {
+        buf[i - sizeof(uint32_t)] = raw[i];
+    }
+    return nvs_crc32(buf, sizeof(buf));
+}
+
+static inline unsigned nvs_entry_state(const uint8_t *page, unsigned index)
+{
+    return (page[NVS_BITMAP_OFFSET + index / 4] >> ((index % 4) * 2)) & 3;
+}
+
+static inline void nvs_set_entry_state(uint8_t *page, unsigned index, unsigned state)
+{
+    uint8_t *bits = &page[NVS_BITMAP_OFFSET + index / 4];
+    unsigned shift = (index % 4) * 2;
+    *bits = (uint8_t)((*bits & ~(3u << shift)) | (state << shift));
+}
+
+/* Size of the fixed width integer types, 0 for the variable length ones */
+static inline size_t nvs_type_size(uint8_t type)
+{
+    switch (type) {
+    case NVS_TYPE_U8:
+    case NVS_TYPE_I8:
+    case NVS_TYPE_U16:
+    case NVS_TYPE_I16:
+    case NVS_TYPE_U32:
+    case NVS_TYPE_I32:
+    case NVS_TYPE_U64:
+    case NVS_TYPE_I64:
+        return type & 0x0F;
+    default:
+        return 0;
+    }
+}
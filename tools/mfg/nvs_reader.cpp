@@ -0,0 +1,167 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "nvs_reader.h"
+
+static std::string_view entry_key(const nvs_entry_t *entry)
+{
+    return std::string_view(entry->key, strnlen(entry->key, NVS_KEY_SIZE));
+}
+
+void nvs_reader::error(size_t page, unsigned entry, const char *reason)
+{
+    char buf[96];
+    snprintf(buf, sizeof(buf), "page %zu entry %u: %s", page, entry, reason);
+    m_errors.push_back(buf);
+}
+
+bool nvs_reader::parse(const uint8_t *image, size_t size)
+{
+    m_image = image;
+    m_items.clear();
+    m_chunks.clear();
+    m_namespaces.assign(NVS_NAMESPACE_MAX + 1, std::string_view());
+    m_assembled.clear();
+    m_errors.clear();
+    if (size % NVS_PAGE_SIZE) {
+        m_errors.push_back("image size is not a multiple of the page size");
+        return false;
+    }
+
+    for (size_t p = 0; p < size / NVS_PAGE_SIZE; p++) {
+        const uint8_t *page = image + p * NVS_PAGE_SIZE;
+        const nvs_page_header_t *header = (const nvs_page_header_t *)page;
+        if (header->state == NVS_PAGE_STATE_EMPTY) {
+            continue;
+        }
+        if (header->state != NVS_PAGE_STATE_ACTIVE && header->state != NVS_PAGE_STATE_FULL &&
+            header->state != NVS_PAGE_STATE_FREEING) {
+            error(p, 0, "invalid page state");
+            continue;
+        }
+        if (header->version != NVS_PAGE_VERSION_2 || header->crc32 != nvs_page_header_crc(header)) {
+            error(p, 0, "invalid page header");
+            continue;
+        }
+
+        for (unsigned i = 0; i < NVS_ENTRY_COUNT;) {
+            if (nvs_entry_state(page, i) != NVS_ENTRY_STATE_WRITTEN) {
+                i++;
+                continue;
+            }
+            const nvs_entry_t *entry = (const nvs_entry_t *)(page + NVS_ENTRY_OFFSET + i * NVS_ENTRY_SIZE);
+            if (entry->crc32 != nvs_entry_crc(entry) || entry->span == 0 || entry->span > NVS_ENTRY_COUNT - i) {
+                error(p, i, "entry header CRC or span mismatch");
+                i++;
+                continue;
+            }
+
+            nvs_item_t item = {entry->ns, entry->type, entry_key(entry), 0, NULL, 0};
+            size_t value_size = nvs_type_size(entry->type);
+            if (value_size) {
+                for (size_t b = 0; b < value_size; b++) {
+                    item.value |= (uint64_t)entry->data.raw[b] << (8 * b);
+                }
+                if ((entry->type & 0x10) && value_size < 8 && (item.value >> (8 * value_size - 1)) & 1) {
+                    item.value |= ~0ULL << (8 * value_size);
+                }
+            } else if (entry->type == NVS_TYPE_STR || entry->type == NVS_TYPE_BLOB_DATA) {
+                item.data = (const uint8_t *)(entry + 1);
+                item.size = entry->data.var.size;
+                if (item.size > (size_t)(entry->span - 1) * NVS_ENTRY_SIZE ||
+                    entry->data.var.data_crc32 != nvs_crc32(item.data, item.size)) {
+                    error(p, i, "data CRC or size mismatch");
+                    i += entry->span;
+                    continue;
+                }
+                if (entry->type == NVS_TYPE_STR && item.size) {
+                    item.size--; // NUL
+                }
+            } else if (entry->type == NVS_TYPE_BLOB_IDX) {
+                item.value = entry->data.blob_index.size;
+                item.size = entry->data.blob_index.chunk_count | (entry->data.blob_index.chunk_start << 8);
+            } else {
+                error(p, i, "unknown type");
+                i += entry->span;
+                continue;
+            }
+
+            if (entry->ns == 0 && entry->type == NVS_TYPE_U8) {
+                m_namespaces[item.value & 0xFF] = item.key;
+            } else if (entry->type == NVS_TYPE_BLOB_DATA) {
+                item.value = entry->chunk_index;
+                m_chunks.push_back(item);
+            } else {
+                m_items.push_back(item);
+            }
+            i += entry->span;
+        }
+    }
+
+    resolve_blobs();
+    return m_errors.empty();
+}
+
+/* Blob index entries carry the size and chunk range, the data comes from the chunks in any page */
+void nvs_reader::resolve_blobs()
+{
+    for (nvs_item_t &item : m_items) {
+        if (item.type != NVS_TYPE_BLOB_IDX) {
+            continue;
+        }
+        size_t blob_size = item.value;
+        unsigned chunk_count = item.size & 0xFF;
+        unsigned chunk_start = (unsigned)(item.size >> 8);
+        std::vector<const nvs_item_t *> chunks(chunk_count, NULL);
+        for (const nvs_item_t &chunk : m_chunks) {
+            if (chunk.ns == item.ns && chunk.key == item.key && chunk.value >= chunk_start &&
+                chunk.value < chunk_start + chunk_count) {
+                chunks[chunk.value - chunk_start] = &chunk;
+            }
+        }
+
+        size_t total = 0;
+        for (const nvs_item_t *chunk : chunks) {
+            total += chunk ? chunk->size : 0;
+            if (!chunk) {
+                total = SIZE_MAX;
+                break;
+            }
+        }
+        if (total != blob_size) {
+            m_errors.push_back(std::string(item.key) + ": blob chunks are missing or do not add up to its size");
+            item.data = NULL;
+            item.size = 0;
+            continue;
+        }
+        if (chunk_count == 1) {
+            item.data = chunks[0]->data;
+        } else {
+            std::vector<uint8_t> &blob = m_assembled.emplace_back();
+            blob.reserve(blob_size);
+            for (const nvs_item_t *chunk : chunks) {
+                blob.insert(blob.end(), chunk->data, chunk->data + chunk->size);
+            }
+            item.data = blob.data();
+        }
+        item.size = blob_size;
+    }
+}
+
+const nvs_item_t *nvs_reader::find(const char *ns, const char *key) const
+{
+    for (const nvs_item_t &item : m_items) {
+        if (namespace_name(item.ns) == ns && item.key == key) {
+            return &item;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,62 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "nvs_format.h"
+
+typedef struct {
+    uint8_t ns;
+    uint8_t type; // NVS_TYPE_*, blobs are reported once with NVS_TYPE_BLOB_IDX
+    std::string_view key;
+    uint64_t value; // Integer types, sign extended
+    const uint8_t *data; // Strings without the NUL and blobs, points into the image unless the blob has several chunks
+    size_t size;
+} nvs_item_t;
+
+/** Parses an NVS partition image in place
+ *
+ * Page headers, entry headers and data are checked against their CRCs, entries that fail are reported and
+ * skipped like nvs_flash skips them. Items refer to the image, which has to outlive the reader.
+ */
+class nvs_reader {
+public:
+    /** Parse the image, returns false if any check failed, see `errors()` */
+    bool parse(const uint8_t *image, size_t size);
+
+    /** Item `key` of namespace `ns`, NULL if there is none */
+    const nvs_item_t *find(const char *ns, const char *key) const;
+
+    /** Name of namespace `index`, empty if the image does not define it */
+    std::string_view namespace_name(uint8_t index) const
+    {
+        return index < m_namespaces.size() ? m_namespaces[index] : std::string_view();
+    }
+
+    const std::vector<nvs_item_t> &items() const { return m_items; }
+    const std::vector<std::string> &errors() const { return m_errors; }
+
+private:
+    void error(size_t page, unsigned entry, const char *reason);
+    void resolve_blobs();
+
+    const uint8_t *m_image = NULL;
+    std::vector<nvs_item_t> m_items;
+    std::vector<nvs_item_t> m_chunks; // BLOB_DATA entries, chunk index in `value`
+    std::vector<std::string_view> m_namespaces; // Indexed by namespace index
+    std::deque<std::vector<uint8_t>> m_assembled; // Blobs of several chunks
+    std::vector<std::string> m_errors;
+};
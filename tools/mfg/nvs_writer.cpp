@@ -0,0 +1,187 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "nvs_writer.h"
+
+/* Largest string that nvs_flash accepts, it has to fit into one page */
+#define NVS_STRING_MAX_SIZE     4000
+/* Largest blob of the version 2 format, chunks of one page each, less the index entry */
+#define NVS_BLOB_MAX_SIZE       508000
+
+bool nvs_writer::init(size_t size)
+{
+    m_error.clear();
+    if (size % NVS_PAGE_SIZE || size < 2 * NVS_PAGE_SIZE) {
+        m_error = "partition size must be a multiple of 4096 bytes and hold at least two pages";
+        return false;
+    }
+    m_image.assign(size, 0xFF);
+    m_page_count = size / NVS_PAGE_SIZE;
+    m_page = 0;
+    m_entry = 0;
+    m_namespace_count = 0;
+    return true;
+}
+
+bool nvs_writer::fail(const char *key, const char *reason)
+{
+    m_error = std::string(key) + ": " + reason;
+    return false;
+}
+
+bool nvs_writer::next_page()
+{
+    /* The last page stays erased */
+    if (m_page + 2 >= m_page_count) {
+        return false;
+    }
+    m_page++;
+    m_entry = 0;
+    return true;
+}
+
+nvs_entry_t nvs_writer::make_entry(uint8_t ns, const char *key, uint8_t type, uint8_t span, uint8_t chunk_index)
+{
+    nvs_entry_t entry;
+    memset(&entry, 0xFF, sizeof(entry));
+    entry.ns = ns;
+    entry.type = type;
+    entry.span = span;
+    entry.chunk_index = chunk_index;
+    memset(entry.key, 0, sizeof(entry.key));
+    strncpy(entry.key, key, sizeof(entry.key) - 1);
+    return entry;
+}
+
+/* Write the entry header followed by `size` bytes of data, padded with 0xFF to whole entries */
+void nvs_writer::write_entry(nvs_entry_t &entry, const uint8_t *data, size_t size)
+{
+    uint8_t *page = &m_image[m_page * NVS_PAGE_SIZE];
+    entry.crc32 = nvs_entry_crc(&entry);
+    memcpy(&page[NVS_ENTRY_OFFSET + m_entry * NVS_ENTRY_SIZE], &entry, sizeof(entry));
+    if (size) {
+        memcpy(&page[NVS_ENTRY_OFFSET + (m_entry + 1) * NVS_ENTRY_SIZE], data, size);
+    }
+    unsigned span = 1 + (unsigned)((size + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE);
+    for (unsigned i = 0; i < span; i++) {
+        nvs_set_entry_state(page, m_entry + i, NVS_ENTRY_STATE_WRITTEN);
+    }
+    m_entry += span;
+}
+
+int nvs_writer::add_namespace(const char *name)
+{
+    if (m_namespace_count >= NVS_NAMESPACE_MAX) {
+        fail(name, "too many namespaces");
+        return -1;
+    }
+    uint8_t index = (uint8_t)++m_namespace_count;
+    if (!add_integer(0, name, NVS_TYPE_U8, index)) {
+        return -1;
+    }
+    return index;
+}
+
+bool nvs_writer::add_integer(uint8_t ns, const char *key, uint8_t type, uint64_t value)
+{
+    size_t size = nvs_type_size(type);
+    if (size == 0) {
+        return fail(key, "not an integer type");
+    }
+    if (strlen(key) >= NVS_KEY_SIZE) {
+        return fail(key, "key is longer than 15 characters");
+    }
+    if (m_entry >= NVS_ENTRY_COUNT && !next_page()) {
+        return fail(key, "partition is full");
+    }
+    nvs_entry_t entry = make_entry(ns, key, type, 1, NVS_CHUNK_ANY);
+    for (size_t i = 0; i < size; i++) {
+        entry.data.raw[i] = (uint8_t)(value >> (8 * i));
+    }
+    write_entry(entry, NULL, 0);
+    return true;
+}
+
+bool nvs_writer::add_string(uint8_t ns, const char *key, const std::string &value)
+{
+    size_t size = value.size() + 1;
+    if (strlen(key) >= NVS_KEY_SIZE) {
+        return fail(key, "key is longer than 15 characters");
+    }
+    if (size > NVS_STRING_MAX_SIZE) {
+        return fail(key, "string does not fit into a page");
+    }
+    unsigned span = 1 + (unsigned)((size + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE);
+    /* Like nvs_partition_gen.py, a string that would end exactly at the page end also moves to the next page */
+    if (m_entry + span >= NVS_ENTRY_COUNT && !next_page()) {
+        return fail(key, "partition is full");
+    }
+    nvs_entry_t entry = make_entry(ns, key, NVS_TYPE_STR, (uint8_t)span, NVS_CHUNK_ANY);
+    entry.data.var.size = (uint16_t)size;
+    entry.data.var.data_crc32 = nvs_crc32(value.c_str(), size);
+    write_entry(entry, (const uint8_t *)value.c_str(), size);
+    return true;
+}
+
+bool nvs_writer::add_blob(uint8_t ns, const char *key, const uint8_t *data, size_t size)
+{
+    if (strlen(key) >= NVS_KEY_SIZE) {
+        return fail(key, "key is longer than 15 characters");
+    }
+    if (size > NVS_BLOB_MAX_SIZE) {
+        return fail(key, "blob is too large");
+    }
+    if (m_entry >= NVS_ENTRY_COUNT && !next_page()) {
+        return fail(key, "partition is full");
+    }
+
+    /* Fill the rest of the current page with a chunk and continue on the next pages */
+    size_t offset = 0;
+    uint8_t chunk_count = 0;
+    while (true) {
+        size_t tailroom = (size_t)(NVS_ENTRY_COUNT - m_entry - 1) * NVS_ENTRY_SIZE;
+        size_t chunk_size = size - offset < tailroom ? size - offset : tailroom;
+        nvs_entry_t entry = make_entry(ns, key, NVS_TYPE_BLOB_DATA,
+                                       (uint8_t)(1 + (chunk_size + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE), chunk_count);
+        entry.data.var.size = (uint16_t)chunk_size;
+        entry.data.var.data_crc32 = nvs_crc32(data + offset, chunk_size);
+        write_entry(entry, data + offset, chunk_size);
+        chunk_count++;
+        offset += chunk_size;
+
+        /* The index entry needs one more free entry on the page */
+        if ((offset < size || tailroom - chunk_size < NVS_ENTRY_SIZE) && !next_page()) {
+            return fail(key, "partition is full");
+        }
+        if (offset == size) {
+            break;
+        }
+    }
+
+    nvs_entry_t index = make_entry(ns, key, NVS_TYPE_BLOB_IDX, 1, NVS_CHUNK_ANY);
+    index.data.blob_index.size = (uint32_t)size;
+    index.data.blob_index.chunk_count = chunk_count;
+    index.data.blob_index.chunk_start = 0;
+    write_entry(index, NULL, 0);
+    return true;
+}
+
+void nvs_writer::finish()
+{
+    for (size_t i = 0; i + 1 < m_page_count; i++) {
+        nvs_page_header_t header;
+        memset(&header, 0xFF, sizeof(header));
+        header.state = NVS_PAGE_STATE_FULL;
+        header.seq = (uint32_t)i;
+        header.version = NVS_PAGE_VERSION_2;
+        header.crc32 = nvs_page_header_crc(&header);
+        memcpy(&m_image[i * NVS_PAGE_SIZE], &header, sizeof(header));
+    }
+}
@@ -0,0 +1,63 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "nvs_format.h"
+
+/** Builds an NVS partition image in memory
+ *
+ * Entries are placed exactly like nvs_partition_gen.py places them, so an image built from the same
+ * partition.csv is byte-identical to the one of the mfg tool. Every page but the last is marked full,
+ * the last page is left erased for the NVS garbage collection.
+ */
+class nvs_writer {
+public:
+    /** Start an empty image of `size` bytes, a multiple of the page size and at least two pages */
+    bool init(size_t size);
+
+    /** Add a namespace, the entries added after it belong to it
+     *
+     * @return namespace index, -1 in case of failure.
+     */
+    int add_namespace(const char *name);
+
+    /** Add an integer entry of one of the NVS_TYPE_U8..NVS_TYPE_I64 types, `value` holds the two's complement */
+    bool add_integer(uint8_t ns, const char *key, uint8_t type, uint64_t value);
+
+    /** Add a NUL terminated string entry, stored in a single page */
+    bool add_string(uint8_t ns, const char *key, const std::string &value);
+
+    /** Add a blob entry, split into chunks across pages where needed */
+    bool add_blob(uint8_t ns, const char *key, const uint8_t *data, size_t size);
+
+    /** Write the page headers, the image is complete afterwards */
+    void finish();
+
+    const std::vector<uint8_t> &image() const { return m_image; }
+    const std::string &error() const { return m_error; }
+
+private:
+    bool next_page();
+    nvs_entry_t make_entry(uint8_t ns, const char *key, uint8_t type, uint8_t span, uint8_t chunk_index);
+    void write_entry(nvs_entry_t &entry, const uint8_t *data, size_t size);
+    bool fail(const char *key, const char *reason);
+
+    std::vector<uint8_t> m_image;
+    std::string m_error;
+    size_t m_page_count = 0;
+    size_t m_page = 0;
+    unsigned m_entry = 0; // Next free entry of the current page
+    unsigned m_namespace_count = 0;
+};
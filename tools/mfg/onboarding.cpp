@@ -0,0 +1,156 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include <zlib.h>
+
+#include "onboarding.h"
+#include "qr_code.h"
+
+#define QR_PNG_SCALE        6
+#define QR_PNG_BORDER       4
+
+static const char k_base38[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ-.";
+
+std::string onboarding_qr_payload(uint16_t vendor_id, uint16_t product_id, uint8_t discovery,
+                                  uint16_t discriminator, uint32_t passcode)
+{
+    /* Version 0, standard commissioning flow and 4 bits of padding, packed LSB first into 11 bytes */
+    uint8_t packed[11] = {0};
+    int offset = 0;
+    auto pack = [&](uint32_t value, int bits) {
+        for (int i = 0; i < bits; i++, offset++) {
+            packed[offset / 8] |= (uint8_t)(((value >> i) & 1) << (offset % 8));
+        }
+    };
+    pack(0, 3);
+    pack(vendor_id, 16);
+    pack(product_id, 16);
+    pack(0, 2);
+    pack(discovery, 8);
+    pack(discriminator & ONBOARDING_DISCRIMINATOR_MAX, 12);
+    pack(passcode, 27);
+    pack(0, 4);
+
+    /* Three bytes become five characters, a trailing pair four and a single byte two, least significant first */
+    std::string payload = "MT:";
+    for (size_t i = 0; i < sizeof(packed); i += 3) {
+        size_t bytes = sizeof(packed) - i < 3 ? sizeof(packed) - i : 3;
+        uint32_t value = 0;
+        for (size_t j = 0; j < bytes; j++) {
+            value |= (uint32_t)packed[i + j] << (8 * j);
+        }
+        int chars = bytes == 3 ? 5 : (bytes == 2 ? 4 : 2);
+        for (int j = 0; j < chars; j++) {
+            payload += k_base38[value % 38];
+            value /= 38;
+        }
+    }
+    return payload;
+}
+
+static int verhoeff_check_digit(const char *digits)
+{
+    static const uint8_t d[10][10] = {
+        {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, {1, 2, 3, 4, 0, 6, 7, 8, 9, 5}, {2, 3, 4, 0, 1, 7, 8, 9, 5, 6},
+        {3, 4, 0, 1, 2, 8, 9, 5, 6, 7}, {4, 0, 1, 2, 3, 9, 5, 6, 7, 8}, {5, 9, 8, 7, 6, 0, 4, 3, 2, 1},
+        {6, 5, 9, 8, 7, 1, 0, 4, 3, 2}, {7, 6, 5, 9, 8, 2, 1, 0, 4, 3}, {8, 7, 6, 5, 9, 3, 2, 1, 0, 4},
+        {9, 8, 7, 6, 5, 4, 3, 2, 1, 0},
+    };
+    static const uint8_t p[8][10] = {
+        {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, {1, 5, 7, 6, 2, 8, 3, 0, 9, 4}, {5, 8, 0, 3, 7, 9, 6, 1, 4, 2},
+        {8, 9, 1, 6, 0, 4, 3, 5, 2, 7}, {9, 4, 5, 3, 1, 2, 6, 8, 7, 0}, {4, 2, 8, 6, 5, 7, 3, 9, 0, 1},
+        {2, 7, 9, 3, 8, 0, 6, 4, 1, 5}, {7, 0, 4, 6, 9, 1, 3, 2, 5, 8},
+    };
+    static const uint8_t inv[10] = {0, 4, 3, 2, 1, 5, 6, 7, 8, 9};
+
+    int c = 0;
+    size_t length = strlen(digits);
+    for (size_t i = 0; i < length; i++) {
+        c = d[c][p[(i + 1) % 8][digits[length - 1 - i] - '0']];
+    }
+    return inv[c];
+}
+
+std::string onboarding_manual_code(uint16_t discriminator, uint32_t passcode)
+{
+    /* Only the upper 4 bits of the discriminator go into the manual code */
+    uint32_t short_discriminator = (discriminator & ONBOARDING_DISCRIMINATOR_MAX) >> 8;
+    char digits[16];
+    snprintf(digits, sizeof(digits), "%01u%05u%04u", (unsigned)(short_discriminator >> 2),
+             (unsigned)(((short_discriminator & 0x3) << 14) | (passcode & 0x3FFF)), (unsigned)(passcode >> 14));
+    char code[20];
+    snprintf(code, sizeof(code), "%.4s-%.3s-%.3s%d", digits, digits + 4, digits + 7, verhoeff_check_digit(digits));
+    return code;
+}
+
+static void png_chunk(std::vector<uint8_t> &png, const char *type, const uint8_t *data, size_t size)
+{
+    uint8_t header[8] = {
+        (uint8_t)(size >> 24), (uint8_t)(size >> 16), (uint8_t)(size >> 8), (uint8_t)size,
+        (uint8_t)type[0], (uint8_t)type[1], (uint8_t)type[2], (uint8_t)type[3],
+    };
+    png.insert(png.end(), header, header + sizeof(header));
+    png.insert(png.end(), data, data + size);
+    uLong crc = crc32(0, header + 4, 4);
+    if (size) {
+        crc = crc32(crc, data, (uInt)size); // crc32() with a NULL buffer would restart the checksum
+    }
+    uint8_t trailer[4] = {(uint8_t)(crc >> 24), (uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t)crc};
+    png.insert(png.end(), trailer, trailer + sizeof(trailer));
+}
+
+bool onboarding_write_qr_png(const std::string &payload, const char *path)
+{
+    qr_code_t qr;
+    if (!qr_encode_alphanumeric(payload.c_str(), &qr)) {
+        return false;
+    }
+
+    uint32_t width = (uint32_t)(qr.size + 2 * QR_PNG_BORDER) * QR_PNG_SCALE;
+    size_t stride = 1 + (width + 7) / 8;
+    std::vector<uint8_t> raw(stride * width, 0);
+    for (uint32_t y = 0; y < width; y++) {
+        uint8_t *row = &raw[y * stride]; // Filter type 0 in row[0]
+        for (uint32_t x = 0; x < width; x++) {
+            int mx = (int)(x / QR_PNG_SCALE) - QR_PNG_BORDER;
+            int my = (int)(y / QR_PNG_SCALE) - QR_PNG_BORDER;
+            bool dark = mx >= 0 && my >= 0 && mx < qr.size && my < qr.size && qr.modules[my][mx];
+            if (!dark) {
+                row[1 + x / 8] |= (uint8_t)(0x80 >> (x % 8));
+            }
+        }
+    }
+    uLongf compressed_size = compressBound((uLong)raw.size());
+    std::vector<uint8_t> compressed(compressed_size);
+    if (compress2(compressed.data(), &compressed_size, raw.data(), (uLong)raw.size(), Z_BEST_COMPRESSION) != Z_OK) {
+        return false;
+    }
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    const uint8_t ihdr[13] = {
+        (uint8_t)(width >> 24), (uint8_t)(width >> 16), (uint8_t)(width >> 8), (uint8_t)width,
+        (uint8_t)(width >> 24), (uint8_t)(width >> 16), (uint8_t)(width >> 8), (uint8_t)width,
+        1, 0, 0, 0, 0, // 1 bit grayscale, deflate, adaptive filtering, no interlace
+    };
+    std::vector<uint8_t> png(signature, signature + sizeof(signature));
+    png_chunk(png, "IHDR", ihdr, sizeof(ihdr));
+    png_chunk(png, "IDAT", compressed.data(), compressed_size);
+    png_chunk(png, "IEND", NULL, 0);
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(png.data(), 1, png.size(), file) == png.size();
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,35 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+#define ONBOARDING_DISCOVERY_SOFT_AP    (1 << 0)
+#define ONBOARDING_DISCOVERY_BLE        (1 << 1)
+#define ONBOARDING_DISCOVERY_ON_NETWORK (1 << 2)
+
+#define ONBOARDING_DISCRIMINATOR_MAX    0xFFF
+
+/** QR code payload, "MT:" followed by the base-38 encoded setup payload with the standard commissioning flow */
+std::string onboarding_qr_payload(uint16_t vendor_id, uint16_t product_id, uint8_t discovery,
+                                  uint16_t discriminator, uint32_t passcode);
+
+/** 11 digit manual pairing code formatted as "dddd-ddd-dddd" */
+std::string onboarding_manual_code(uint16_t discriminator, uint32_t passcode);
+
+/** Write the payload as a 1 bit grayscale PNG
+ *
+ * Modules are 6 pixels wide with a 4 module quiet zone, the same image the mfg tool writes.
+ *
+ * @return true on success.
+ * @return false if the payload can not be encoded or the file can not be written.
+ */
+bool onboarding_write_qr_png(const std::string &payload, const char *path);
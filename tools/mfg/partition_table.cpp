@@ -0,0 +1,90 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdlib.h>
+
+#include "csv.h"
+#include "partition_table.h"
+
+#define APP_ALIGNMENT   0x10000
+#define DATA_ALIGNMENT  0x1000
+
+static std::string trim(const std::string &text)
+{
+    size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    return text.substr(begin, text.find_last_not_of(" \t") - begin + 1);
+}
+
+/* Numbers may be hex or decimal, with an optional K or M suffix */
+static bool parse_size(const std::string &text, uint32_t *value)
+{
+    char *end;
+    unsigned long number = strtoul(text.c_str(), &end, 0);
+    if (end == text.c_str()) {
+        return false;
+    }
+    if (*end == 'K' || *end == 'k') {
+        number *= 1024;
+        end++;
+    } else if (*end == 'M' || *end == 'm') {
+        number *= 1024 * 1024;
+        end++;
+    }
+    *value = (uint32_t)number;
+    return *end == '\0';
+}
+
+bool partition_table_read(const char *path, uint32_t table_offset, std::vector<partition_t> &partitions,
+                          std::string &error)
+{
+    std::vector<csv_row_t> rows;
+    if (!csv_read(path, rows)) {
+        error = std::string("can not read ") + path;
+        return false;
+    }
+
+    uint32_t next = table_offset + PARTITION_TABLE_SIZE;
+    for (const csv_row_t &row : rows) {
+        if (row.empty() || trim(row[0]).empty() || trim(row[0])[0] == '#') {
+            continue;
+        }
+        if (row.size() < 5) {
+            error = "partition " + trim(row[0]) + " has less than 5 columns";
+            return false;
+        }
+        partition_t partition = {trim(row[0]), trim(row[1]), trim(row[2]), 0, 0};
+        std::string offset = trim(row[3]);
+        uint32_t alignment = partition.type == "app" ? APP_ALIGNMENT : DATA_ALIGNMENT;
+        if (offset.empty()) {
+            partition.offset = (next + alignment - 1) & ~(alignment - 1);
+        } else if (!parse_size(offset, &partition.offset)) {
+            error = "partition " + partition.name + " has an invalid offset";
+            return false;
+        }
+        if (!parse_size(trim(row[4]), &partition.size)) {
+            error = "partition " + partition.name + " has an invalid size";
+            return false;
+        }
+        next = partition.offset + partition.size;
+        partitions.push_back(partition);
+    }
+    return true;
+}
+
+const partition_t *partition_table_find(const std::vector<partition_t> &partitions, const char *name)
+{
+    for (const partition_t &partition : partitions) {
+        if (partition.name == name) {
+            return &partition;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,44 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#define PARTITION_TABLE_OFFSET  0xC000 // CONFIG_PARTITION_TABLE_OFFSET
+#define PARTITION_TABLE_SIZE    0x1000
+
+typedef struct {
+    std::string name;
+    std::string type;
+    std::string subtype;
+    uint32_t offset;
+    uint32_t size;
+} partition_t;
+
+/** Read partitions.csv
+ *
+ * Blank offsets are filled in the way gen_esp32part.py does, following the previous partition with 64 KiB
+ * alignment for app partitions and 4 KiB for data partitions.
+ *
+ * @param[in] path partitions.csv.
+ * @param[in] table_offset Offset of the partition table, the first partition follows it.
+ * @param[out] partitions Partitions in file order.
+ * @param[out] error Reason in case of failure.
+ *
+ * @return true on success.
+ * @return false if the file can not be read or has an invalid line.
+ */
+bool partition_table_read(const char *path, uint32_t table_offset, std::vector<partition_t> &partitions,
+                          std::string &error);
+
+/** Partition `name`, NULL if there is none */
+const partition_t *partition_table_find(const std::vector<partition_t> &partitions, const char *name);
@@ -0,0 +1,35 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "paths.h"
+
+namespace fs = std::filesystem;
+
+std::string mfg_resolve_path(const fs::path &product_dir, const std::string &path)
+{
+    std::error_code ec;
+    if (fs::exists(path, ec)) {
+        return path;
+    }
+    std::string marker = "/" + product_dir.filename().string() + "/";
+    size_t pos = path.rfind(marker);
+    if (pos != std::string::npos) {
+        fs::path moved = product_dir / path.substr(pos + marker.size());
+        if (fs::exists(moved, ec)) {
+            return moved.string();
+        }
+    }
+    if (fs::path(path).is_relative()) {
+        for (fs::path base = product_dir; base.has_relative_path(); base = base.parent_path()) {
+            if (fs::exists(base / path, ec)) {
+                return (base / path).string();
+            }
+        }
+    }
+    return "";
+}
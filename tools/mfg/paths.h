@@ -0,0 +1,24 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+/** Find a file a master or summary row refers to
+ *
+ * The rows keep the paths of the machine that generated them. Paths below a directory named like the product
+ * directory are moved into it, relative paths are tried from the parents of the product directory.
+ *
+ * @param[in] product_dir The out/<vid>_<pid> directory.
+ * @param[in] path Path as written in the row.
+ *
+ * @return path of the file, empty if it can not be found.
+ */
+std::string mfg_resolve_path(const std::filesystem::path &product_dir, const std::string &path);
@@ -0,0 +1,370 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "qr_code.h"
+
+#define QR_FORMAT_EC_LEVEL_M    0
+#define QR_PENALTY_N1           3
+#define QR_PENALTY_N2           3
+#define QR_PENALTY_N3           40
+#define QR_PENALTY_N4           10
+
+/* Error correction level M, indexed by version - 1 */
+static const uint8_t k_ec_codewords_per_block[QR_VERSION_MAX] = {10, 16, 26, 18, 24, 16};
+static const uint8_t k_block_count[QR_VERSION_MAX] = {1, 1, 1, 2, 2, 4};
+static const uint8_t k_total_codewords[QR_VERSION_MAX] = {26, 44, 70, 100, 134, 172};
+
+static const char k_alphanumeric[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:";
+
+typedef struct {
+    qr_code_t *qr;
+    uint8_t is_function[QR_SIZE_MAX][QR_SIZE_MAX];
+} qr_builder_t;
+
+typedef struct {
+    uint8_t bytes[QR_VERSION_MAX * 32];
+    int bit_count;
+} qr_bits_t;
+
+static void append_bits(qr_bits_t *bits, uint32_t value, int count)
+{
+    for (int i = count - 1; i >= 0; i--, bits->bit_count++) {
+        if ((value >> i) & 1) {
+            bits->bytes[bits->bit_count >> 3] |= (uint8_t)(0x80 >> (bits->bit_count & 7));
+        }
+    }
+}
+
+static uint8_t gf_multiply(uint8_t x, uint8_t y)
+{
+    int z = 0;
+    for (int i = 7; i >= 0; i--) {
+        z = (z << 1) ^ ((z >> 7) * 0x11D);
+        z ^= ((y >> i) & 1) * x;
+    }
+    return (uint8_t)z;
+}
+
+static void reed_solomon(const uint8_t *data, int size, int degree, uint8_t *ec)
+{
+    uint8_t divisor[32] = {0};
+    divisor[degree - 1] = 1;
+    uint8_t root = 1;
+    for (int i = 0; i < degree; i++) {
+        for (int j = 0; j < degree; j++) {
+            divisor[j] = gf_multiply(divisor[j], root);
+            if (j + 1 < degree) {
+                divisor[j] ^= divisor[j + 1];
+            }
+        }
+        root = gf_multiply(root, 0x02);
+    }
+
+    memset(ec, 0, degree);
+    for (int i = 0; i < size; i++) {
+        uint8_t factor = data[i] ^ ec[0];
+        memmove(ec, ec + 1, degree - 1);
+        ec[degree - 1] = 0;
+        for (int j = 0; j < degree; j++) {
+            ec[j] ^= gf_multiply(divisor[j], factor);
+        }
+    }
+}
+
+static void set_function(qr_builder_t *builder, int x, int y, bool dark)
+{
+    builder->qr->modules[y][x] = dark;
+    builder->is_function[y][x] = 1;
+}
+
+static void draw_format_bits(qr_builder_t *builder, int mask)
+{
+    int size = builder->qr->size;
+    int data = (QR_FORMAT_EC_LEVEL_M << 3) | mask;
+    int rem = data;
+    for (int i = 0; i < 10; i++) {
+        rem = (rem << 1) ^ ((rem >> 9) * 0x537);
+    }
+    int bits = ((data << 10) | rem) ^ 0x5412;
+
+    for (int i = 0; i <= 5; i++) {
+        set_function(builder, 8, i, (bits >> i) & 1);
+    }
+    set_function(builder, 8, 7, (bits >> 6) & 1);
+    set_function(builder, 8, 8, (bits >> 7) & 1);
+    set_function(builder, 7, 8, (bits >> 8) & 1);
+    for (int i = 9; i < 15; i++) {
+        set_function(builder, 14 - i, 8, (bits >> i) & 1);
+    }
+    for (int i = 0; i < 8; i++) {
+        set_function(builder, size - 1 - i, 8, (bits >> i) & 1);
+    }
+    for (int i = 8; i < 15; i++) {
+        set_function(builder, 8, size - 15 + i, (bits >> i) & 1);
+    }
+    set_function(builder, 8, size - 8, true);
+}
+
+static void draw_function_patterns(qr_builder_t *builder, int version)
+{
+    int size = builder->qr->size;
+    for (int i = 0; i < size; i++) {
+        set_function(builder, 6, i, i % 2 == 0);
+        set_function(builder, i, 6, i % 2 == 0);
+    }
+
+    const int finders[3][2] = {{3, 3}, {size - 4, 3}, {3, size - 4}};
+    for (const auto &finder : finders) {
+        for (int dy = -4; dy <= 4; dy++) {
+            for (int dx = -4; dx <= 4; dx++) {
+                int x = finder[0] + dx;
+                int y = finder[1] + dy;
+                int dist = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+                if (x >= 0 && x < size && y >= 0 && y < size) {
+                    set_function(builder, x, y, dist != 2 && dist != 4);
+                }
+            }
+        }
+    }
+
+    /* Versions 2 to 6 have a single alignment pattern next to the bottom right corner */
+    if (version > 1) {
+        int center = size - 7;
+        for (int dy = -2; dy <= 2; dy++) {
+            for (int dx = -2; dx <= 2; dx++) {
+                set_function(builder, center + dx, center + dy, (abs(dx) > abs(dy) ? abs(dx) : abs(dy)) != 1);
+            }
+        }
+    }
+
+    /* Reserve the format areas, the final bits are drawn with the chosen mask */
+    draw_format_bits(builder, 0);
+}
+
+static void draw_codewords(qr_builder_t *builder, const uint8_t *codewords, int count)
+{
+    int size = builder->qr->size;
+    int i = 0;
+    for (int right = size - 1; right >= 1; right -= 2) {
+        if (right == 6) {
+            right = 5;
+        }
+        for (int vert = 0; vert < size; vert++) {
+            for (int j = 0; j < 2; j++) {
+                int x = right - j;
+                bool upward = ((right + 1) & 2) == 0;
+                int y = upward ? size - 1 - vert : vert;
+                if (!builder->is_function[y][x] && i < count * 8) {
+                    builder->qr->modules[y][x] = (codewords[i >> 3] >> (7 - (i & 7))) & 1;
+                    i++;
+                }
+            }
+        }
+    }
+}
+
+static void apply_mask(qr_builder_t *builder, int mask)
+{
+    int size = builder->qr->size;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            bool invert;
+            switch (mask) {
+            case 0: invert = (x + y) % 2 == 0; break;
+            case 1: invert = y % 2 == 0; break;
+            case 2: invert = x % 3 == 0; break;
+            case 3: invert = (x + y) % 3 == 0; break;
+            case 4: invert = (x / 3 + y / 2) % 2 == 0; break;
+            case 5: invert = x * y % 2 + x * y % 3 == 0; break;
+            case 6: invert = (x * y % 2 + x * y % 3) % 2 == 0; break;
+            default: invert = ((x + y) % 2 + x * y % 3) % 2 == 0; break;
+            }
+            if (invert && !builder->is_function[y][x]) {
+                builder->qr->modules[y][x] ^= 1;
+            }
+        }
+    }
+}
+
+/* Finder-like patterns are counted on the run lengths of alternating colors, light first */
+static void finder_add_history(int size, int run_length, int history[7])
+{
+    if (history[0] == 0) {
+        run_length += size; // The light border before the first run
+    }
+    memmove(&history[1], &history[0], 6 * sizeof(int));
+    history[0] = run_length;
+}
+
+static int finder_count_patterns(const int history[7])
+{
+    int n = history[1];
+    bool core = n > 0 && history[2] == n && history[3] == n * 3 && history[4] == n && history[5] == n;
+    return (core && history[0] >= n * 4 && history[6] >= n ? 1 : 0) +
+           (core && history[6] >= n * 4 && history[0] >= n ? 1 : 0);
+}
+
+static int finder_terminate_and_count(int size, bool run_color, int run_length, int history[7])
+{
+    if (run_color) {
+        finder_add_history(size, run_length, history);
+        run_length = 0;
+    }
+    run_length += size; // The light border after the last run
+    finder_add_history(size, run_length, history);
+    return finder_count_patterns(history);
+}
+
+static long penalty_score(const qr_code_t *qr)
+{
+    int size = qr->size;
+    long result = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (int a = 0; a < size; a++) {
+            bool run_color = false;
+            int run = 0;
+            int history[7] = {0};
+            for (int b = 0; b < size; b++) {
+                bool dark = pass == 0 ? qr->modules[a][b] : qr->modules[b][a];
+                if (dark == run_color) {
+                    run++;
+                    if (run == 5) {
+                        result += QR_PENALTY_N1;
+                    } else if (run > 5) {
+                        result++;
+                    }
+                } else {
+                    finder_add_history(size, run, history);
+                    if (!run_color) {
+                        result += finder_count_patterns(history) * QR_PENALTY_N3;
+                    }
+                    run_color = dark;
+                    run = 1;
+                }
+            }
+            result += finder_terminate_and_count(size, run_color, run, history) * QR_PENALTY_N3;
+        }
+    }
+
+    for (int y = 0; y < size - 1; y++) {
+        for (int x = 0; x < size - 1; x++) {
+            uint8_t color = qr->modules[y][x];
+            if (color == qr->modules[y][x + 1] && color == qr->modules[y + 1][x] &&
+                color == qr->modules[y + 1][x + 1]) {
+                result += QR_PENALTY_N2;
+            }
+        }
+    }
+
+    int dark = 0;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            dark += qr->modules[y][x];
+        }
+    }
+    int total = size * size;
+    int k = (abs(dark * 20 - total * 10) + total - 1) / total - 1;
+    result += (long)k * QR_PENALTY_N4;
+    return result;
+}
+
+bool qr_encode_alphanumeric(const char *text, qr_code_t *qr)
+{
+    int length = (int)strlen(text);
+    int values[QR_VERSION_MAX * 32];
+    if (length > (int)(sizeof(values) / sizeof(values[0]))) {
+        return false;
+    }
+    for (int i = 0; i < length; i++) {
+        const char *found = strchr(k_alphanumeric, text[i]);
+        if (!found) {
+            return false;
+        }
+        values[i] = (int)(found - k_alphanumeric);
+    }
+
+    /* Mode indicator, 9 bit character count, 11 bits per pair and 6 bits for an odd last character */
+    int data_bits = 4 + 9 + (length / 2) * 11 + (length % 2) * 6;
+    int version = 1;
+    while (version <= QR_VERSION_MAX &&
+           data_bits > (k_total_codewords[version - 1] -
+                        k_ec_codewords_per_block[version - 1] * k_block_count[version - 1]) * 8) {
+        version++;
+    }
+    if (version > QR_VERSION_MAX) {
+        return false;
+    }
+
+    int ec_per_block = k_ec_codewords_per_block[version - 1];
+    int block_count = k_block_count[version - 1];
+    int total_codewords = k_total_codewords[version - 1];
+    int data_codewords = total_codewords - ec_per_block * block_count;
+
+    qr_bits_t bits = {};
+    append_bits(&bits, 0x2, 4);
+    append_bits(&bits, (uint32_t)length, 9);
+    for (int i = 0; i + 1 < length; i += 2) {
+        append_bits(&bits, (uint32_t)(values[i] * 45 + values[i + 1]), 11);
+    }
+    if (length % 2) {
+        append_bits(&bits, (uint32_t)values[length - 1], 6);
+    }
+    int capacity = data_codewords * 8;
+    append_bits(&bits, 0, capacity - bits.bit_count < 4 ? capacity - bits.bit_count : 4);
+    append_bits(&bits, 0, (8 - bits.bit_count % 8) % 8);
+    for (uint8_t pad = 0xEC; bits.bit_count < capacity; pad ^= 0xEC ^ 0x11) {
+        append_bits(&bits, pad, 8);
+    }
+
+    /* Split into blocks, the long blocks come last, then interleave data and error correction codewords */
+    uint8_t blocks[8][QR_VERSION_MAX * 32];
+    int short_block_count = block_count - total_codewords % block_count;
+    int short_block_size = total_codewords / block_count;
+    for (int i = 0, offset = 0; i < block_count; i++) {
+        int size = short_block_size - ec_per_block + (i < short_block_count ? 0 : 1);
+        memcpy(blocks[i], &bits.bytes[offset], size);
+        reed_solomon(&bits.bytes[offset], size, ec_per_block, &blocks[i][short_block_size + 1 - ec_per_block]);
+        offset += size;
+    }
+    uint8_t codewords[QR_VERSION_MAX * 32];
+    int count = 0;
+    for (int i = 0; i <= short_block_size; i++) {
+        for (int j = 0; j < block_count; j++) {
+            if (i != short_block_size - ec_per_block || j >= short_block_count) {
+                codewords[count++] = blocks[j][i];
+            }
+        }
+    }
+
+    qr_builder_t builder = {};
+    memset(qr, 0, sizeof(*qr));
+    qr->size = 17 + 4 * version;
+    builder.qr = qr;
+    draw_function_patterns(&builder, version);
+    draw_codewords(&builder, codewords, count);
+
+    int best_mask = 0;
+    long best_penalty = -1;
+    for (int mask = 0; mask < 8; mask++) {
+        apply_mask(&builder, mask);
+        draw_format_bits(&builder, mask);
+        long penalty = penalty_score(qr);
+        if (best_penalty < 0 || penalty < best_penalty) {
+            best_mask = mask;
+            best_penalty = penalty;
+        }
+        apply_mask(&builder, mask);
+    }
+    apply_mask(&builder, best_mask);
+    draw_format_bits(&builder, best_mask);
+    return true;
+}
@@ -0,0 +1,33 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+/* Onboarding payloads are 22 characters, versions up to 6 leave room and need no version information block */
+#define QR_VERSION_MAX      6
+#define QR_SIZE_MAX         (17 + 4 * QR_VERSION_MAX)
+
+typedef struct {
+    int size;
+    uint8_t modules[QR_SIZE_MAX][QR_SIZE_MAX]; // [y][x], 1 is dark
+} qr_code_t;
+
+/** Encode text of the QR alphanumeric character set
+ *
+ * Uses error correction level M, the smallest version the text fits in and the mask with the lowest
+ * penalty score, the same choices the mfg tool makes for the onboarding QR code.
+ *
+ * @param[in] text Upper case letters, digits and " $%*+-./:".
+ * @param[out] qr Module matrix.
+ *
+ * @return true on success.
+ * @return false if the text has other characters or does not fit into version QR_VERSION_MAX.
+ */
+bool qr_encode_alphanumeric(const char *text, qr_code_t *qr);
@@ -0,0 +1,76 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <openssl/bn.h>
+#include <openssl/crypto.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+
+#include "spake2p.h"
+
+/* w0s and w1s are 40 bytes each, reduced modulo the group order */
+#define SPAKE2P_WS_SIZE     40
+#define SPAKE2P_W_SIZE      32
+
+bool spake2p_passcode_valid(uint32_t passcode)
+{
+    static const uint32_t invalid[] = {
+        11111111, 22222222, 33333333, 44444444, 55555555,
+        66666666, 77777777, 88888888, 99999999, 12345678, 87654321,
+    };
+    if (passcode == 0 || passcode > 99999998) {
+        return false;
+    }
+    for (uint32_t value : invalid) {
+        if (passcode == value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool spake2p_verifier(uint32_t passcode, const uint8_t *salt, size_t salt_size, uint32_t iterations,
+                      uint8_t verifier[SPAKE2P_VERIFIER_SIZE])
+{
+    if (salt_size < SPAKE2P_SALT_MIN_SIZE || salt_size > SPAKE2P_SALT_MAX_SIZE ||
+        iterations < SPAKE2P_ITERATIONS_MIN || iterations > SPAKE2P_ITERATIONS_MAX) {
+        return false;
+    }
+
+    uint8_t password[4] = {
+        (uint8_t)passcode, (uint8_t)(passcode >> 8), (uint8_t)(passcode >> 16), (uint8_t)(passcode >> 24),
+    };
+    uint8_t ws[2 * SPAKE2P_WS_SIZE];
+    if (!PKCS5_PBKDF2_HMAC((const char *)password, sizeof(password), salt, (int)salt_size, (int)iterations,
+                           EVP_sha256(), sizeof(ws), ws)) {
+        return false;
+    }
+
+    bool ok = false;
+    EC_GROUP *group = EC_GROUP_new_by_curve_name(NID_X9_62_prime256v1);
+    BN_CTX *ctx = BN_CTX_new();
+    BIGNUM *w0 = BN_bin2bn(ws, SPAKE2P_WS_SIZE, NULL);
+    BIGNUM *w1 = BN_bin2bn(ws + SPAKE2P_WS_SIZE, SPAKE2P_WS_SIZE, NULL);
+    OPENSSL_cleanse(ws, sizeof(ws));
+    EC_POINT *L = group ? EC_POINT_new(group) : NULL;
+    if (group && ctx && w0 && w1 && L &&
+        BN_nnmod(w0, w0, EC_GROUP_get0_order(group), ctx) &&
+        BN_nnmod(w1, w1, EC_GROUP_get0_order(group), ctx) &&
+        BN_bn2binpad(w0, verifier, SPAKE2P_W_SIZE) == SPAKE2P_W_SIZE &&
+        EC_POINT_mul(group, L, w1, NULL, NULL, ctx)) {
+        ok = EC_POINT_point2oct(group, L, POINT_CONVERSION_UNCOMPRESSED, verifier + SPAKE2P_W_SIZE,
+                                SPAKE2P_VERIFIER_SIZE - SPAKE2P_W_SIZE, ctx) == SPAKE2P_VERIFIER_SIZE - SPAKE2P_W_SIZE;
+    }
+    EC_POINT_free(L);
+    BN_clear_free(w1);
+    BN_clear_free(w0);
+    BN_CTX_free(ctx);
+    EC_GROUP_free(group);
+    return ok;
+}
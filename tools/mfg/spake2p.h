@@ -0,0 +1,37 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPAKE2P_VERIFIER_SIZE       97 // w0 and the uncompressed point L = w1 * G on P-256
+#define SPAKE2P_SALT_MIN_SIZE       16
+#define SPAKE2P_SALT_MAX_SIZE       32
+#define SPAKE2P_ITERATIONS_MIN      1000
+#define SPAKE2P_ITERATIONS_MAX      100000
+
+/** Whether the passcode is allowed by the Matter specification */
+bool spake2p_passcode_valid(uint32_t passcode);
+
+/** Compute the SPAKE2+ verifier stored in the "verifier" key of chip-factory
+ *
+ * This runs PBKDF2-HMAC-SHA256 over the passcode, which is what most of the time per device goes into.
+ *
+ * @param[in] passcode Setup passcode.
+ * @param[in] salt Salt, SPAKE2P_SALT_MIN_SIZE to SPAKE2P_SALT_MAX_SIZE bytes.
+ * @param[in] salt_size Size of the salt.
+ * @param[in] iterations PBKDF2 iteration count.
+ * @param[out] verifier w0 || L.
+ *
+ * @return true on success.
+ * @return false in case of invalid arguments or a crypto failure.
+ */
+bool spake2p_verifier(uint32_t passcode, const uint8_t *salt, size_t salt_size, uint32_t iterations,
+                      uint8_t verifier[SPAKE2P_VERIFIER_SIZE]);
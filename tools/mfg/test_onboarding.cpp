@@ -0,0 +1,253 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+/* SPAKE2+ verifier, QR code payload, manual code and QR code of mfg_batch, checked against the devices the mfg tool
+ * generated into out/
+ *
+ * Every row of a summary-*.csv is recomputed from its pincode, salt, iteration count, discriminator, vendor and
+ * product ID and has to give the verifier, qrcode and manualcode of the row. The <uuid>-qrcode.png of the device is
+ * decoded and has to show the modules of the QR code mfg_batch would draw for the payload.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <zlib.h>
+
+#include "csv.h"
+#include "onboarding.h"
+#include "qr_code.h"
+#include "spake2p.h"
+
+#include "host_test.h"
+
+/* mfg_batch's default, the discovery capabilities are not in the summary */
+#define DISCOVERY           ONBOARDING_DISCOVERY_BLE
+#define QR_PNG_BORDER       4
+
+namespace fs = std::filesystem;
+
+typedef std::vector<uint8_t> bytes_t;
+
+typedef struct {
+    fs::path summary;
+    csv_row_t header;
+    csv_row_t row;
+} summary_row_t;
+
+static std::vector<summary_row_t> load_summaries()
+{
+    std::vector<summary_row_t> rows;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(MFG_OUT_DIR, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.rfind("summary", 0) != 0 || it->path().extension() != ".csv") {
+            continue;
+        }
+        std::vector<csv_row_t> csv;
+        CHECK(csv_read(it->path().c_str(), csv));
+        for (size_t i = 1; i < csv.size(); i++) {
+            if (csv[i].size() == csv[0].size()) {
+                rows.push_back({it->path(), csv[0], csv[i]});
+            }
+        }
+    }
+    return rows;
+}
+
+static std::string field(const summary_row_t &row, const char *name)
+{
+    int column = csv_column(row.header, name);
+    CHECK(column >= 0);
+    return column >= 0 ? row.row[column] : std::string();
+}
+
+static uint32_t number(const summary_row_t &row, const char *name)
+{
+    return (uint32_t)strtoul(field(row, name).c_str(), NULL, 0);
+}
+
+static bool base64_decode(const std::string &text, bytes_t &out)
+{
+    out.resize(3 * ((text.size() + 3) / 4));
+    int len = EVP_DecodeBlock(out.data(), (const unsigned char *)text.data(), (int)text.size());
+    if (len < 0 || text.size() % 4) {
+        return false;
+    }
+    for (size_t i = text.size(); i > 0 && text[i - 1] == '='; i--) {
+        len--;
+    }
+    out.resize((size_t)len);
+    return true;
+}
+
+static uint32_t be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/* Decodes a non-interlaced 1 bit grayscale PNG into one byte per pixel, 1 for black */
+static bool decode_png(const fs::path &path, uint32_t *width, std::vector<uint8_t> &pixels)
+{
+    std::ifstream file(path, std::ios::binary);
+    bytes_t png((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (png.size() < 8 || memcmp(png.data(), "\x89PNG\r\n\x1a\n", 8) != 0) {
+        return false;
+    }
+    uint32_t height = 0;
+    bytes_t idat;
+    for (size_t offset = 8; offset + 12 <= png.size();) {
+        uint32_t size = be32(&png[offset]);
+        if (offset + 12 + size > png.size()) {
+            return false;
+        }
+        const uint8_t *type = &png[offset + 4];
+        const uint8_t *data = &png[offset + 8];
+        if (memcmp(type, "IHDR", 4) == 0) {
+            /* Bit depth 1, grayscale, no interlace */
+            if (size != 13 || data[8] != 1 || data[9] != 0 || data[12] != 0) {
+                return false;
+            }
+            *width = be32(data);
+            height = be32(data + 4);
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            idat.insert(idat.end(), data, data + size);
+        }
+        offset += 12 + size;
+    }
+    size_t stride = (*width + 7) / 8;
+    bytes_t raw((stride + 1) * height);
+    uLongf raw_size = raw.size();
+    if (!*width || uncompress(raw.data(), &raw_size, idat.data(), idat.size()) != Z_OK || raw_size != raw.size()) {
+        return false;
+    }
+
+    /* Undo the row filters, one byte per pixel group at bit depth 1 */
+    bytes_t previous(stride, 0), row(stride);
+    pixels.assign((size_t)*width * height, 0);
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t *line = &raw[y * (stride + 1)];
+        for (size_t i = 0; i < stride; i++) {
+            int a = i > 0 ? row[i - 1] : 0, b = previous[i], c = i > 0 ? previous[i - 1] : 0;
+            int predictor = 0;
+            switch (line[0]) {
+            case 0: predictor = 0; break;
+            case 1: predictor = a; break;
+            case 2: predictor = b; break;
+            case 3: predictor = (a + b) / 2; break;
+            case 4: {
+                int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+                predictor = pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+                break;
+            }
+            default: return false;
+            }
+            row[i] = (uint8_t)(line[1 + i] + predictor);
+        }
+        for (uint32_t x = 0; x < *width; x++) {
+            pixels[(size_t)y * *width + x] = !(row[x / 8] & (0x80 >> (x % 8)));
+        }
+        previous = row;
+    }
+    return true;
+}
+
+HOST_TEST(summary_rows_recompute_to_their_codes)
+{
+    std::vector<summary_row_t> rows = load_summaries();
+    CHECK(!rows.empty());
+    for (const summary_row_t &row : rows) {
+        uint32_t passcode = number(row, "pincode");
+        uint16_t discriminator = (uint16_t)number(row, "discriminator");
+        CHECK(spake2p_passcode_valid(passcode));
+
+        bytes_t salt;
+        CHECK(base64_decode(field(row, "salt"), salt));
+        CHECK(salt.size() >= SPAKE2P_SALT_MIN_SIZE && salt.size() <= SPAKE2P_SALT_MAX_SIZE);
+        bytes_t verifier;
+        CHECK(base64_decode(field(row, "verifier"), verifier));
+        CHECK_EQ(verifier.size(), SPAKE2P_VERIFIER_SIZE);
+        uint8_t computed[SPAKE2P_VERIFIER_SIZE];
+        CHECK(spake2p_verifier(passcode, salt.data(), salt.size(), number(row, "iteration-count"), computed));
+        CHECK(verifier.size() == sizeof(computed) && memcmp(verifier.data(), computed, sizeof(computed)) == 0);
+
+        std::string qrcode = onboarding_qr_payload((uint16_t)number(row, "vendor-id"),
+                                                   (uint16_t)number(row, "product-id"), DISCOVERY, discriminator,
+                                                   passcode);
+        std::string manualcode = onboarding_manual_code(discriminator, passcode);
+        if (qrcode != field(row, "qrcode") || manualcode != field(row, "manualcode")) {
+            fprintf(stderr, "%s: %s gives %s %s, expected %s %s\n", row.summary.filename().c_str(),
+                    field(row, "serial-num").c_str(), qrcode.c_str(), manualcode.c_str(), field(row, "qrcode").c_str(),
+                    field(row, "manualcode").c_str());
+        }
+        CHECK(qrcode == field(row, "qrcode"));
+        CHECK(manualcode == field(row, "manualcode"));
+        printf("  %s: discriminator %4u, %s, %s\n", row.summary.filename().c_str(), discriminator, qrcode.c_str(),
+               manualcode.c_str());
+    }
+}
+
+/* The PNG next to each device is drawn from the payload of its row */
+HOST_TEST(qr_code_images_show_the_encoded_payload)
+{
+    std::vector<summary_row_t> rows = load_summaries();
+    int images = 0;
+    for (const summary_row_t &row : rows) {
+        /* The bundle is the UUID directory of the row's DAC */
+        fs::path bundle = fs::path(field(row, "dac-cert")).parent_path().parent_path();
+        fs::path png = row.summary.parent_path() / bundle.filename() / (bundle.filename().string() + "-qrcode.png");
+        if (!fs::exists(png)) {
+            continue;
+        }
+        qr_code_t qr;
+        CHECK(qr_encode_alphanumeric(field(row, "qrcode").c_str(), &qr));
+        uint32_t width = 0;
+        std::vector<uint8_t> pixels;
+        CHECK(decode_png(png, &width, pixels));
+        CHECK_EQ(width % (uint32_t)(qr.size + 2 * QR_PNG_BORDER), 0);
+        uint32_t scale = width / (uint32_t)(qr.size + 2 * QR_PNG_BORDER);
+        if (!scale || pixels.size() != (size_t)width * width) {
+            continue;
+        }
+        int mismatches = 0;
+        for (int y = 0; y < qr.size; y++) {
+            for (int x = 0; x < qr.size; x++) {
+                uint32_t px = (x + QR_PNG_BORDER) * scale + scale / 2;
+                uint32_t py = (y + QR_PNG_BORDER) * scale + scale / 2;
+                mismatches += pixels[(size_t)py * width + px] != qr.modules[y][x];
+            }
+        }
+        if (mismatches) {
+            fprintf(stderr, "%s: %d modules differ\n", png.filename().c_str(), mismatches);
+        }
+        CHECK_EQ(mismatches, 0);
+        images++;
+    }
+    CHECK(images > 0);
+}
+
+/* Known values of the Matter specification and the SDK's test device */
+HOST_TEST(codes_of_the_sdk_test_device)
+{
+    CHECK(onboarding_manual_code(3840, 20202021) == "3497-011-2332");
+    CHECK(onboarding_qr_payload(0xFFF1, 0x8000, ONBOARDING_DISCOVERY_BLE, 3840, 20202021) ==
+          "MT:Y.K9042C00KA0648G00");
+    CHECK(!spake2p_passcode_valid(0));
+    CHECK(!spake2p_passcode_valid(11111111));
+    CHECK(!spake2p_passcode_valid(12345678));
+    CHECK(!spake2p_passcode_valid(100000000));
+    CHECK(spake2p_passcode_valid(20202021));
+}
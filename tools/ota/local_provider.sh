@@ -0,0 +1,98 @@
+#!/usr/bin/env bash
+#
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# Unless required by applicable law or agreed to in writing, this
+# software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied.
+#
+# Serves an OTA image from the Linux chip-ota-provider-app and measures the update of one fan node.
+#
+#   tools/ota/local_provider.sh <image.ota> <device-node-id> <version> [report.csv]
+#
+# The fan node has to be commissioned with the same chip-tool storage beforehand, and has to reach
+# this host over IPv6 (for Thread through the border router). The provider is commissioned as its own
+# node, gets an ACL entry that lets any node of the fabric use the OTA Provider cluster, and is then
+# announced to the fan node. The time from the announcement until the node reports the new
+# SoftwareVersion is the transfer, patch and reboot time of the release; the device logs the download
+# and apply phases on its own. Both the image size and the time are added to the report, the size in
+# the column of the image type, which is taken from the -delta.ota or -full.ota suffix that
+# make_delta_ota.sh gives the image.
+
+set -euo pipefail
+
+if [ $# -lt 3 ]; then
+    sed -n '11p' "$0" | sed 's/^# *//'
+    exit 1
+fi
+
+OTA_IMAGE=$1
+DEVICE_NODE_ID=$2
+VERSION=$3
+REPORT=${4:-$(dirname "$OTA_IMAGE")/ota_report.csv}
+
+IMAGE_NAME=$(basename "$OTA_IMAGE" .ota)
+IMAGE_TYPE=${IMAGE_NAME##*-}
+VERSION_STRING=${IMAGE_NAME%-*}
+VERSION_STRING=${VERSION_STRING#light-}
+case "$IMAGE_TYPE" in
+delta) ;;
+full)
+    echo "Warning: a device built with CONFIG_ENABLE_DELTA_OTA rejects a full image" >&2
+    ;;
+*)
+    echo "$OTA_IMAGE is neither a -delta.ota nor a -full.ota image of make_delta_ota.sh" >&2
+    exit 1
+    ;;
+esac
+
+CHIP_TOOL=${CHIP_TOOL:-chip-tool}
+OTA_PROVIDER_APP=${OTA_PROVIDER_APP:-chip-ota-provider-app}
+PROVIDER_NODE_ID=${PROVIDER_NODE_ID:-0xDEADBEEF}
+PROVIDER_DISCRIMINATOR=${PROVIDER_DISCRIMINATOR:-22}
+PROVIDER_PASSCODE=${PROVIDER_PASSCODE:-20202021}
+PROVIDER_KVS=${PROVIDER_KVS:-/tmp/chip_kvs_ota_provider}
+CONTROLLER_NODE_ID=${CONTROLLER_NODE_ID:-112233}
+TIMEOUT_S=${TIMEOUT_S:-1800}
+
+"$OTA_PROVIDER_APP" --discriminator "$PROVIDER_DISCRIMINATOR" --passcode "$PROVIDER_PASSCODE" \
+    --secured-device-port 5565 --KVS "$PROVIDER_KVS" --filepath "$OTA_IMAGE" > ota_provider.log 2>&1 &
+PROVIDER_PID=$!
+trap 'kill $PROVIDER_PID 2>/dev/null || true' EXIT
+sleep 2
+
+"$CHIP_TOOL" pairing onnetwork-long "$PROVIDER_NODE_ID" "$PROVIDER_PASSCODE" "$PROVIDER_DISCRIMINATOR"
+"$CHIP_TOOL" accesscontrol write acl \
+    "[{\"fabricIndex\": 1, \"privilege\": 5, \"authMode\": 2, \"subjects\": [$CONTROLLER_NODE_ID], \"targets\": null},
+      {\"fabricIndex\": 1, \"privilege\": 3, \"authMode\": 2, \"subjects\": null,
+       \"targets\": [{\"cluster\": 41, \"endpoint\": null, \"deviceType\": null}]}]" \
+    "$PROVIDER_NODE_ID" 0
+
+software_version() {
+    "$CHIP_TOOL" basicinformation read software-version "$DEVICE_NODE_ID" 0 2>/dev/null |
+        sed -n 's/.*SoftwareVersion: \([0-9]*\).*/\1/p' | tail -n 1
+}
+
+START_S=$(date +%s)
+"$CHIP_TOOL" otasoftwareupdaterequestor announce-otaprovider "$PROVIDER_NODE_ID" 0 0 0 "$DEVICE_NODE_ID" 0
+
+while [ "$(software_version)" != "$VERSION" ]; do
+    if [ $(($(date +%s) - START_S)) -ge "$TIMEOUT_S" ]; then
+        echo "Node $DEVICE_NODE_ID did not report version $VERSION within $TIMEOUT_S s" >&2
+        exit 1
+    fi
+    sleep 10
+done
+
+TRANSFER_S=$(($(date +%s) - START_S))
+IMAGE_SIZE=$(stat -c %s "$OTA_IMAGE")
+if [ ! -f "$REPORT" ]; then
+    echo "version,version_string,full_bytes,delta_bytes,delta_percent,transfer_s,device" > "$REPORT"
+fi
+if [ "$IMAGE_TYPE" = delta ]; then
+    echo "$VERSION,$VERSION_STRING,,$IMAGE_SIZE,,$TRANSFER_S,$DEVICE_NODE_ID" >> "$REPORT"
+else
+    echo "$VERSION,$VERSION_STRING,$IMAGE_SIZE,,,$TRANSFER_S,$DEVICE_NODE_ID" >> "$REPORT"
+fi
+
+echo "Node $DEVICE_NODE_ID runs version $VERSION after $TRANSFER_S s, $IMAGE_SIZE bytes transferred"
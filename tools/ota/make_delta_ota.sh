@@ -0,0 +1,84 @@
+#!/usr/bin/env bash
+#
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# Unless required by applicable law or agreed to in writing, this
+# software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied.
+#
+# Builds a Matter delta OTA image from two application binaries.
+#
+#   tools/ota/make_delta_ota.sh <base.bin> <new.bin> <version> <version-string> [out-dir]
+#
+# <base.bin> is the image running on the devices, <new.bin> the release build (build/light.bin).
+# <version> must be greater than CONFIG_DEVICE_SOFTWARE_VERSION_NUMBER of the base image,
+# otherwise the OTA requestor ignores the image.
+#
+# The patch is checked against both binaries before it is wrapped into a Matter OTA image.
+# The full image is built as well, but only as a size reference: with CONFIG_ENABLE_DELTA_OTA the
+# requestor applies every image it downloads as a patch, so the devices reject a full image. The
+# sizes of both are appended to <out-dir>/ota_report.csv.
+
+set -euo pipefail
+
+if [ $# -lt 4 ]; then
+    sed -n '11p' "$0" | sed 's/^# *//'
+    exit 1
+fi
+
+BASE_BIN=$1
+NEW_BIN=$2
+VERSION=$3
+VERSION_STRING=$4
+OUT_DIR=${5:-ota}
+
+PROJECT_DIR=$(cd "$(dirname "$0")/../.." && pwd)
+SDKCONFIG=${SDKCONFIG:-$PROJECT_DIR/sdkconfig}
+
+sdkconfig_value() {
+    sed -n "s/^$1=\"\?\([^\"]*\)\"\?$/\1/p" "$SDKCONFIG"
+}
+
+TARGET=$(sdkconfig_value CONFIG_IDF_TARGET)
+VENDOR_ID=$(sdkconfig_value CONFIG_DEVICE_VENDOR_ID)
+PRODUCT_ID=$(sdkconfig_value CONFIG_DEVICE_PRODUCT_ID)
+
+# The patch generator ships with the esp_delta_ota component, ota_image_tool.py with the Matter SDK
+PATCH_GEN=${PATCH_GEN:-$(find "$PROJECT_DIR/managed_components" "${ESP_MATTER_PATH:-/nonexistent}" \
+    -name esp_delta_ota_patch_gen.py -print -quit 2>/dev/null || true)}
+OTA_IMAGE_TOOL=${OTA_IMAGE_TOOL:-$ESP_MATTER_PATH/connectedhomeip/connectedhomeip/src/app/ota_image_tool.py}
+
+if [ -z "$PATCH_GEN" ] || [ ! -f "$PATCH_GEN" ]; then
+    echo "esp_delta_ota_patch_gen.py not found, set PATCH_GEN" >&2
+    exit 1
+fi
+if [ ! -f "$OTA_IMAGE_TOOL" ]; then
+    echo "ota_image_tool.py not found, set OTA_IMAGE_TOOL or ESP_MATTER_PATH" >&2
+    exit 1
+fi
+
+mkdir -p "$OUT_DIR"
+PATCH_BIN=$OUT_DIR/light-$VERSION_STRING.patch
+DELTA_OTA=$OUT_DIR/light-$VERSION_STRING-delta.ota
+FULL_OTA=$OUT_DIR/light-$VERSION_STRING-full.ota
+
+python3 "$PATCH_GEN" create_patch --chip "$TARGET" \
+    --base_binary "$BASE_BIN" --new_binary "$NEW_BIN" --patch_file_name "$PATCH_BIN"
+python3 "$PATCH_GEN" verify_patch --chip "$TARGET" \
+    --base_binary "$BASE_BIN" --new_binary "$NEW_BIN" --patch_file_name "$PATCH_BIN"
+
+for image in "$PATCH_BIN:$DELTA_OTA" "$NEW_BIN:$FULL_OTA"; do
+    python3 "$OTA_IMAGE_TOOL" create -v "$VENDOR_ID" -p "$PRODUCT_ID" -vn "$VERSION" -vs "$VERSION_STRING" \
+        -da sha256 "${image%%:*}" "${image##*:}"
+done
+
+FULL_SIZE=$(stat -c %s "$FULL_OTA")
+DELTA_SIZE=$(stat -c %s "$DELTA_OTA")
+REPORT=$OUT_DIR/ota_report.csv
+if [ ! -f "$REPORT" ]; then
+    echo "version,version_string,full_bytes,delta_bytes,delta_percent,transfer_s,device" > "$REPORT"
+fi
+echo "$VERSION,$VERSION_STRING,$FULL_SIZE,$DELTA_SIZE,$((DELTA_SIZE * 100 / FULL_SIZE)),," >> "$REPORT"
+
+echo "Full image:  $FULL_OTA ($FULL_SIZE bytes, size reference only, not accepted with CONFIG_ENABLE_DELTA_OTA)"
+echo "Delta image: $DELTA_OTA ($DELTA_SIZE bytes, $((DELTA_SIZE * 100 / FULL_SIZE))% of full)"
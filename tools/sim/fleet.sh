@@ -0,0 +1,83 @@
+#!/usr/bin/env bash
+#
+# This example code is in the Public Domain (or CC0 licensed, at your option.)
+#
+# Unless required by applicable law or agreed to in writing, this
+# software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+# CONDITIONS OF ANY KIND, either express or implied.
+#
+# Starts a fleet of simulated fan nodes on this host and puts controller load on it.
+#
+#   tools/sim/fleet.sh <count> [work-dir]
+#
+# Every node is an instance of fan_node_sim from the host build in test/host. It runs the fan driver
+# of main/ unchanged on the fake data model, LEDC, tach and button, and serves the attributes over UDP
+# on loopback (see the head of test/host/fan_node_sim.cpp). It does not speak Matter, esp-matter has no
+# Linux target. Build it first:
+#
+#   cmake -S test/host -B build-host && cmake --build build-host -j
+#
+# Node n listens on BASE_PORT + n. The start time and resident memory of every node go to
+# <work-dir>/fleet.csv. Then fleet_load subscribes to every node and writes PercentSetting at RATE
+# writes per second for DURATION_S seconds, its results go to <work-dir>/load.csv. With DURATION_S=0
+# the nodes keep running until the script is stopped, for a controller of your own.
+
+set -euo pipefail
+
+if [ $# -lt 1 ]; then
+    sed -n '11p' "$0" | sed 's/^# *//'
+    exit 1
+fi
+
+COUNT=$1
+WORK_DIR=${2:-/tmp/fan_fleet}
+PROJECT_DIR=$(cd "$(dirname "$0")/../.." && pwd)
+
+SIM_BUILD_DIR=${SIM_BUILD_DIR:-$PROJECT_DIR/build-host}
+BIND=${BIND:-::1}
+BASE_PORT=${BASE_PORT:-5600}
+DURATION_S=${DURATION_S:-10}
+RATE=${RATE:-100}
+START_TIMEOUT_S=${START_TIMEOUT_S:-10}
+
+for tool in fan_node_sim fleet_load; do
+    if [ ! -x "$SIM_BUILD_DIR/$tool" ]; then
+        echo "$SIM_BUILD_DIR/$tool not found, build test/host or set SIM_BUILD_DIR" >&2
+        exit 1
+    fi
+done
+
+mkdir -p "$WORK_DIR"
+PIDS=()
+trap 'kill "${PIDS[@]}" 2>/dev/null || true' EXIT
+
+now_ms() {
+    echo $(($(date +%s%N) / 1000000))
+}
+
+echo "node,pid,port,start_ms,rss_kb" > "$WORK_DIR/fleet.csv"
+for ((n = 0; n < COUNT; n++)); do
+    LOG="$WORK_DIR/node-$n.log"
+    START_MS=$(now_ms)
+    "$SIM_BUILD_DIR/fan_node_sim" --bind "$BIND" --port $((BASE_PORT + n)) > "$LOG" 2>&1 &
+    PIDS+=($!)
+
+    # The node is up once it serves requests, every node is started after the previous one so the
+    # start time is not skewed by the others
+    until grep -qs "^ready" "$LOG"; do
+        if ! kill -0 "${PIDS[n]}" 2>/dev/null || [ $(($(now_ms) - START_MS)) -ge $((START_TIMEOUT_S * 1000)) ]; then
+            echo "Node $n did not start, see $LOG" >&2
+            exit 1
+        fi
+        sleep 0.01
+    done
+    RSS_KB=$(sed -n 's/^VmRSS:[[:space:]]*\([0-9]*\) kB/\1/p' "/proc/${PIDS[n]}/status")
+    echo "$n,${PIDS[n]},$((BASE_PORT + n)),$(($(now_ms) - START_MS)),$RSS_KB" >> "$WORK_DIR/fleet.csv"
+done
+echo "$COUNT nodes running on ports $BASE_PORT to $((BASE_PORT + COUNT - 1)), see $WORK_DIR/fleet.csv"
+
+if [ "$DURATION_S" = 0 ]; then
+    wait
+fi
+"$SIM_BUILD_DIR/fleet_load" --host "$BIND" --duration "$DURATION_S" --rate "$RATE" "$BASE_PORT" "$COUNT" |
+    tee "$WORK_DIR/load.csv"